@@ -5,21 +5,24 @@
 #include "TimeManager.h"
 #include "DeviceManager.h"
 #include "Storage.h"
+#include "CropProfiles.h"
+#include "Rules.h"
+#include "PiController.h"
+#include "PumpDuty.h"
+#include "PumpGovernor.h"
 #include "SunPosition.h"
+#include "TickContext.h"
+#include "Clock.h"
 
 #include <math.h>
+#include <string.h>
 
 // Многоуровневая автоматика с адаптацией и диагностикой.
 
 namespace {
 
-constexpr uint32_t MANUAL_HOLD_MS      = 5UL * 60UL * 1000UL; // 5 минут
 constexpr uint32_t STATS_UPDATE_MIN_MS = 10UL * 1000UL;
 
-// Ограничения safety для насоса (можно подправить при желании в коде)
-constexpr uint32_t PUMP_MAX_DAY_MS     = 20UL * 60UL * 1000UL; // суммарно 20 мин за 24ч
-constexpr uint32_t PUMP_MAX_RUN_MS     = 5UL  * 60UL * 1000UL; // одна сессия не более 5 мин
-
 template<typename T>
 T clampT(T v, T lo, T hi) {
   if (v < lo) return lo;
@@ -35,13 +38,33 @@ float lerp(float a, float b, float t) {
 
 // ---------- ручной режим ----------
 
-uint32_t manualPumpUntil  = 0;
 uint32_t manualLightUntil = 0;
 uint32_t manualFanUntil   = 0;
 uint32_t manualDoorUntil  = 0;
 
-bool isManualActive(uint32_t until) {
-  return (until != 0 && millis() < until);
+// Сравнение через разность — переживает переход millis() через 2^32.
+// Истёкшее удержание обнуляем: иначе через 2^31 мс разность снова
+// станет положительной и выход опять уйдёт в ручной режим.
+bool isManualActive(uint32_t& until, uint32_t nowMs) {
+  if (until != 0 && (int32_t)(until - nowMs) > 0) return true;
+  until = 0;
+  return false;
+}
+
+uint32_t manualUntil(uint32_t holdMs) {
+  uint32_t until = Clock::millis() + holdMs;
+  return until ? until : 1;   // 0 — удержания нет
+}
+
+// ---------- аварийный климат ----------
+
+// Перегрев/переохлаждение: вентиляция принудительно, без учёта правил
+constexpr float AIR_EMERGENCY_HOT  = 40.0f;
+constexpr float AIR_EMERGENCY_COLD = 5.0f;
+
+bool isAirEmergency(float airTemp) {
+  return !isnan(airTemp) &&
+         (airTemp > AIR_EMERGENCY_HOT || airTemp < AIR_EMERGENCY_COLD);
 }
 
 // ---------- свет / lux ----------
@@ -59,19 +82,6 @@ struct LightAdaptiveState {
 
 LightAdaptiveState g_light;
 
-// ---------- safety насоса ----------
-
-struct SafetyState {
-  uint32_t pumpWindowMs      = 0;  // накопленное время работы насоса в окне
-  uint32_t pumpWindowStartMs = 0;  // начало окна
-  uint32_t pumpLastStateMs   = 0;  // время последнего обновления
-  bool     pumpLastStateOn   = false;
-  uint32_t pumpRunStartMs    = 0;  // когда текущий запуск начался
-  bool     pumpLocked        = false;
-};
-
-SafetyState g_safety;
-
 // ---------- история климата ----------
 
 struct ClimateHistory {
@@ -84,40 +94,199 @@ struct ClimateHistory {
 
 ClimateHistory g_climateHist;
 
-// ---------- статистика полива ----------
+// ---------- проветривание ----------
+
+using PiController::q16;
+
+constexpr PiController::Gains ventGains(const VentConfig::Gains& g) {
+  return { PiController::fromFloat(g.kp),
+           PiController::fromFloat(g.ki),
+           PiController::fromFloat(g.rateMax) };
+}
+
+// Коэффициенты по ClimateMode (Eco, Normal, Aggressive), уже в Q16.16
+constexpr PiController::Gains VENT_GAINS[] = {
+  ventGains(VentConfig::GAINS[0]),
+  ventGains(VentConfig::GAINS[1]),
+  ventGains(VentConfig::GAINS[2]),
+};
+constexpr uint8_t VENT_MODES = sizeof(VENT_GAINS) / sizeof(VENT_GAINS[0]);
+
+constexpr PiController::Limits VENT_LIMITS = { 0, PiController::fromInt(100) };
+
+struct VentState {
+  PiController::State pi;
+  uint8_t demand = 0;   // выход регулятора, %
+  uint8_t door   = 0;   // заданный угол двери с учётом мёртвой зоны, %
+};
+
+VentState                g_vent;
+Automation::VentControl  g_ventControl = Automation::VentControl::Pi;
+
+// Прежний регулятор: оценка "жарко/влажно" сразу в угол двери
+void ventHeuristic(float t, float h, const CropProfiles::Params& cp,
+                   bool& needVent, uint8_t& doorAngle) {
+  float tempOver  = 0.0f;
+  float tempUnder = 0.0f;
+  if (t > cp.tempMax) tempOver  = t - cp.tempMax;
+  if (t < cp.tempMin) tempUnder = cp.tempMin - t;
+
+  float humOver   = 0.0f;
+  float humUnder  = 0.0f;
+  if (h > cp.humMax) humOver   = h - cp.humMax;
+  if (h < cp.humMin) humUnder  = cp.humMin - h;
+
+  float trendBoost = 0.0f;
+  if (g_climateHist.dTdt > 1.0f) {
+    trendBoost += (g_climateHist.dTdt - 1.0f) * 0.5f;
+  }
+  if (g_climateHist.dHdt > 3.0f) {
+    trendBoost += (g_climateHist.dHdt - 3.0f) * 0.1f;
+  }
+
+  float scoreHotHumid =
+    tempOver * 2.0f + humOver * 0.7f + trendBoost;
+
+  float scoreColdDry =
+    tempUnder * 2.0f + humUnder * 0.7f;
+
+  needVent  = false;
+  doorAngle = 0;
+
+  if (scoreHotHumid > 0.5f) {
+    needVent = true;
+    float norm = clampT(scoreHotHumid / 20.0f, 0.0f, 1.0f);
+    doorAngle = (uint8_t)(norm * 100.0f);
+  }
+
+  if (scoreColdDry > 1.0f) {
+    needVent  = false;
+    doorAngle = 0;
+  }
+}
+
+// Ошибка для PI, °C: перегрев над tempMax или избыток влажности в
+// пересчёте на градусы — что больше; ниже tempMin — закрываться всегда
+float ventError(float t, float h, const CropProfiles::Params& cp) {
+  float err    = t - cp.tempMax;
+  float humErr = (h - cp.humMax) * VentConfig::HUM_WEIGHT;
+  if (humErr > err) err = humErr;
+  if (t < cp.tempMin) err = t - cp.tempMin;
+  return err;
+}
+
+// Спрос 0..100 % делится на дверь и вентилятор (split range)
+uint8_t ventDoorFor(uint8_t demand) {
+  uint16_t d = (uint16_t)demand * 100 / VentConfig::DOOR_FULL_AT;
+  return d > 100 ? 100 : (uint8_t)d;
+}
+
+uint8_t ventFanFor(uint8_t demand) {
+  if (demand <= VentConfig::FAN_FROM) return 0;
+  return (uint8_t)((uint16_t)(demand - VentConfig::FAN_FROM) * 100 /
+                   (100 - VentConfig::FAN_FROM));
+}
+
+// Серво не дёргаем ради шага меньше мёртвой зоны; крайние положения — всегда
+uint8_t ventDoorDeadband(uint8_t target) {
+  uint8_t cur  = g_vent.door;
+  uint8_t diff = target > cur ? target - cur : cur - target;
+  if (diff >= VentConfig::DOOR_DEADBAND || target == 0 || target == 100) {
+    g_vent.door = target;
+  }
+  return g_vent.door;
+}
+
+// ---------- зоны полива ----------
 
-struct WateringStats {
-  bool     lastPumpOn         = false;
-  uint32_t lastPumpToggleMs   = 0;
+// Состояние грядок — массивы по полям (struct of arrays): проход по всем
+// зонам читает подряд лежащие float'ы одного поля, а не прыгает по
+// структурам. Индекс — номер зоны, значимы первые g_zoneCount элементов.
+constexpr uint8_t MAX_ZONES = ZoneConfig::MAX_ZONES;
 
-  float lastBeforeMoisture    = NAN;
-  float lastAfterMoisture     = NAN;
+struct ZoneArrays {
+  float    soil[MAX_ZONES];             // отсчёт этого тика, % (NAN — нет данных)
+  float    setpointOffset[MAX_ZONES];   // адаптивный сдвиг setpoint'а, %
+  float    soilStress[MAX_ZONES];
 
-  float avgDelta              = NAN; // средний прирост влажности за полив
-  float avgDrySpeed           = NAN; // средняя скорость высыхания, %/ч
+  // статистика полива
+  float    beforeMoisture[MAX_ZONES];   // влажность в момент начала полива
+  float    avgDelta[MAX_ZONES];         // средний прирост влажности за полив
+  float    avgDrySpeed[MAX_ZONES];      // средняя скорость высыхания, %/ч
+  float    lastDryMoisture[MAX_ZONES];
+  uint32_t lastDrySampleMs[MAX_ZONES];
 
-  uint32_t lastDrySampleMs    = 0;
-  float    lastDryMoisture    = NAN;
+  uint8_t  watering[MAX_ZONES];         // зона сейчас поливается
+  uint8_t  lastWatering[MAX_ZONES];     // для отслеживания начала/конца полива
 };
 
-WateringStats g_waterStats;
+ZoneArrays g_zones;
+uint8_t    g_zoneCount  = 1;
+bool       g_zonesPrimed = false;       // lastWatering ещё не снят
+
+// Отсчёты зон 1.. приходят из задачи опроса (setZoneSoil), забираются
+// в g_zones.soil под спинлоком одним копированием
+portMUX_TYPE g_zoneInMux = portMUX_INITIALIZER_UNLOCKED;
+float        g_zoneIn[MAX_ZONES];
+
+// Статистика полива и адаптивные сдвиги (после смены настроек)
+void resetZoneStats() {
+  for (uint8_t z = 0; z < MAX_ZONES; ++z) {
+    g_zones.setpointOffset[z]  = 0.0f;
+    g_zones.beforeMoisture[z]  = NAN;
+    g_zones.avgDelta[z]        = NAN;
+    g_zones.avgDrySpeed[z]     = NAN;
+    g_zones.lastDryMoisture[z] = NAN;
+    g_zones.lastDrySampleMs[z] = 0;
+  }
+  g_zonesPrimed = false;
+}
+
+void resetZones() {
+  for (uint8_t z = 0; z < MAX_ZONES; ++z) {
+    g_zones.soil[z]         = NAN;
+    g_zones.soilStress[z]   = 0.0f;
+    g_zones.watering[z]     = 0;
+    g_zones.lastWatering[z] = 0;
+    g_zoneIn[z]             = NAN;
+  }
+  resetZoneStats();
+}
+
+// Зона 0 — штатный датчик из кадра тика, остальные — последние setZoneSoil()
+void loadZoneSoil(const TickContext& ctx) {
+  g_zones.soil[0] = ctx.sensors.soilMoisture;
+  if (g_zoneCount < 2) return;
+
+  portENTER_CRITICAL(&g_zoneInMux);
+  memcpy(&g_zones.soil[1], &g_zoneIn[1], sizeof(float) * (g_zoneCount - 1));
+  portEXIT_CRITICAL(&g_zoneInMux);
+}
 
 // ---------- стресс-индекс ----------
 
+// Факторы подряд — шаг и сглаживание идут одним циклом по массиву.
+// Почва последней: её уровень — среднее по грядкам, а не интеграл.
+enum StressFactor : uint8_t { SF_TEMP, SF_HUM, SF_LIGHT, SF_SOIL, SF_COUNT };
+
+static_assert(sizeof(StressConfig::TAU_S) / sizeof(float) == SF_COUNT,
+              "StressConfig::TAU_S must list every factor");
+
 struct StressState {
-  float tempStress   = 0.0f;
-  float humStress    = 0.0f;
-  float soilStress   = 0.0f;
-  float lightStress  = 0.0f;
-  float totalStress  = 0.0f;
+  float    level[SF_COUNT]  = {};   // текущий вклад фактора
+  float    avg1h[SF_COUNT]  = {};   // EWMA с постоянной 1 ч
+  float    avg24h[SF_COUNT] = {};   // EWMA с постоянной 24 ч
+  float    total            = 0.0f;
+  uint32_t lastMs           = 0;    // прошлый запуск этапа
+  bool     started          = false;
 };
 
 StressState g_stress;
 
 // ---------- адаптивные параметры и их диапазоны ----------
 
+// Сдвиг setpoint'а почвы — свой у каждой зоны (g_zones.setpointOffset)
 struct AdaptiveParams {
-  float soilSetpointOffset = 0.0f; // -X..+Y % к setpoint'у почвы
   float luxOnOffset        = 0.0f; // -X..+Y лк к порогу включения света
   float luxOffOffset       = 0.0f; // -X..+Y лк к порогу выключения света
 };
@@ -133,66 +302,12 @@ struct AdaptLimits {
 
 AdaptLimits g_limits;
 
-// ---------- профили культур ----------
-
-void applyCropProfile() {
-  switch (g_settings.cropProfile) {
-    case CropProfile::Tomatoes:
-      g_settings.comfortTempMin       = 22.0f;
-      g_settings.comfortTempMax       = 28.0f;
-      g_settings.comfortHumMin        = 55.0f;
-      g_settings.comfortHumMax        = 75.0f;
-      g_settings.soilMoistureSetpoint = 65;
-      g_settings.soilMoistureHyst     = 5;
-      g_settings.waterStartHour       = 7;
-      g_settings.waterEndHour         = 20;
-      break;
-
-    case CropProfile::Cucumbers:
-      g_settings.comfortTempMin       = 23.0f;
-      g_settings.comfortTempMax       = 29.0f;
-      g_settings.comfortHumMin        = 65.0f;
-      g_settings.comfortHumMax        = 85.0f;
-      g_settings.soilMoistureSetpoint = 70;
-      g_settings.soilMoistureHyst     = 5;
-      g_settings.waterStartHour       = 6;
-      g_settings.waterEndHour         = 21;
-      break;
-
-    case CropProfile::Greens:
-      g_settings.comfortTempMin       = 18.0f;
-      g_settings.comfortTempMax       = 24.0f;
-      g_settings.comfortHumMin        = 50.0f;
-      g_settings.comfortHumMax        = 70.0f;
-      g_settings.soilMoistureSetpoint = 60;
-      g_settings.soilMoistureHyst     = 5;
-      g_settings.waterStartHour       = 7;
-      g_settings.waterEndHour         = 19;
-      break;
-
-    case CropProfile::Hibiscus:
-      g_settings.comfortTempMin       = 20.0f;
-      g_settings.comfortTempMax       = 26.0f;
-      g_settings.comfortHumMin        = 45.0f;
-      g_settings.comfortHumMax        = 65.0f;
-      g_settings.soilMoistureSetpoint = 55;
-      g_settings.soilMoistureHyst     = 5;
-      g_settings.waterStartHour       = 8;
-      g_settings.waterEndHour         = 19;
-      break;
-
-    case CropProfile::Custom:
-    default:
-      break;
-  }
-}
-
 // ---------- окно полива ----------
 
-bool isWithinWaterWindowInternal() {
-  uint8_t h      = TimeManager::getHour();
-  uint8_t startH = g_settings.waterStartHour;
-  uint8_t endH   = g_settings.waterEndHour;
+bool isWithinWaterWindowInternal(uint8_t h) {
+  const CropProfiles::Params& cp = CropProfiles::active();
+  uint8_t startH = cp.waterStartHour;
+  uint8_t endH   = cp.waterEndHour;
 
   if (startH == endH) {
     return true;
@@ -204,76 +319,22 @@ bool isWithinWaterWindowInternal() {
   }
 }
 
-// ---------- safety насоса ----------
-
-void updatePumpSafety() {
-  uint32_t now = millis();
-  bool pumpNow = g_sensors.pumpOn;
-
-  if (g_safety.pumpWindowStartMs == 0) {
-    g_safety.pumpWindowStartMs = now;
-    g_safety.pumpLastStateMs   = now;
-    g_safety.pumpLastStateOn   = pumpNow;
-    g_safety.pumpRunStartMs    = pumpNow ? now : 0;
-  }
-
-  // скользящее окно ~24 часа
-  if (now - g_safety.pumpWindowStartMs > 24UL * 60UL * 60UL * 1000UL) {
-    g_safety.pumpWindowStartMs = now;
-    g_safety.pumpWindowMs      = 0;
-    g_safety.pumpLocked        = false;
-  }
-
-  uint32_t dt = now - g_safety.pumpLastStateMs;
-  g_safety.pumpLastStateMs = now;
-
-  // накапливаем суммарное время работы насоса
-  if (g_safety.pumpLastStateOn) {
-    g_safety.pumpWindowMs += dt;
-  }
-
-  // отследим момент включения насоса
-  if (pumpNow && !g_safety.pumpLastStateOn) {
-    g_safety.pumpRunStartMs = now;
-  }
-
-  g_safety.pumpLastStateOn = pumpNow;
-
-  // лимит по суммарному времени за сутки
-  if (!g_safety.pumpLocked &&
-      g_safety.pumpWindowMs > PUMP_MAX_DAY_MS) {
-    g_safety.pumpLocked = true;
-  }
-
-  // лимит по одной сессии работы
-  if (!g_safety.pumpLocked &&
-      pumpNow &&
-      g_safety.pumpRunStartMs != 0 &&
-      (now - g_safety.pumpRunStartMs > PUMP_MAX_RUN_MS)) {
-    g_safety.pumpLocked = true;
-  }
-
-  if (g_safety.pumpLocked && pumpNow) {
-    DeviceManager::setPump(false);
-  }
-}
-
 // ---------- история климата ----------
 
-void updateClimateHistory() {
-  uint32_t now = millis();
+void updateClimateHistory(const TickContext& ctx) {
+  uint32_t now = ctx.nowMs;
 
-  if (isnan(g_sensors.airTemp) || isnan(g_sensors.airHum)) {
+  if (isnan(ctx.sensors.airTemp) || isnan(ctx.sensors.airHum)) {
     g_climateHist.lastSampleMs = now;
-    g_climateHist.lastAirTemp  = g_sensors.airTemp;
-    g_climateHist.lastAirHum   = g_sensors.airHum;
+    g_climateHist.lastAirTemp  = ctx.sensors.airTemp;
+    g_climateHist.lastAirHum   = ctx.sensors.airHum;
     return;
   }
 
   if (g_climateHist.lastSampleMs == 0) {
     g_climateHist.lastSampleMs = now;
-    g_climateHist.lastAirTemp  = g_sensors.airTemp;
-    g_climateHist.lastAirHum   = g_sensors.airHum;
+    g_climateHist.lastAirTemp  = ctx.sensors.airTemp;
+    g_climateHist.lastAirHum   = ctx.sensors.airHum;
     return;
   }
 
@@ -284,107 +345,102 @@ void updateClimateHistory() {
   if (dtHours <= 0.0f) dtHours = 0.0001f;
 
   g_climateHist.dTdt =
-    (g_sensors.airTemp - g_climateHist.lastAirTemp) / dtHours;
+    (ctx.sensors.airTemp - g_climateHist.lastAirTemp) / dtHours;
   g_climateHist.dHdt =
-    (g_sensors.airHum  - g_climateHist.lastAirHum)  / dtHours;
+    (ctx.sensors.airHum  - g_climateHist.lastAirHum)  / dtHours;
 
-  g_climateHist.lastAirTemp    = g_sensors.airTemp;
-  g_climateHist.lastAirHum     = g_sensors.airHum;
+  g_climateHist.lastAirTemp    = ctx.sensors.airTemp;
+  g_climateHist.lastAirHum     = ctx.sensors.airHum;
   g_climateHist.lastSampleMs   = now;
 }
 
-// ---------- статистика полива ----------
-
-void updateWateringStatsOnPumpToggle() {
-  bool pumpNow = g_sensors.pumpOn;
-  uint32_t now = millis();
+// ---------- статистика полива и адаптация (по зонам) ----------
 
-  if (g_waterStats.lastPumpToggleMs == 0) {
-    g_waterStats.lastPumpToggleMs = now;
-    g_waterStats.lastPumpOn       = pumpNow;
+// Насос общий: без него полива нет ни в одной зоне. Если насос включён
+// не автоматикой (вручную) и ни одна зона не отмечена — поливаются все.
+void syncWateringWithPump() {
+  const uint8_t n = g_zoneCount;
+  if (!g_sensors.pumpOn) {
+    memset(g_zones.watering, 0, n);
+    return;
   }
-
-  if (pumpNow != g_waterStats.lastPumpOn) {
-    if (pumpNow) {
-      // насос только что включился
-      g_waterStats.lastBeforeMoisture = g_sensors.soilMoisture;
-    } else {
-      // насос только что выключился
-      g_waterStats.lastAfterMoisture = g_sensors.soilMoisture;
-      if (!isnan(g_waterStats.lastBeforeMoisture) &&
-          !isnan(g_waterStats.lastAfterMoisture)) {
-        float delta = g_waterStats.lastAfterMoisture -
-                      g_waterStats.lastBeforeMoisture;
-        if (!isnan(g_waterStats.avgDelta)) {
-          g_waterStats.avgDelta = lerp(g_waterStats.avgDelta, delta, 0.3f);
-        } else {
-          g_waterStats.avgDelta = delta;
-        }
-      }
-    }
-
-    g_waterStats.lastPumpOn       = pumpNow;
-    g_waterStats.lastPumpToggleMs = now;
+  for (uint8_t z = 0; z < n; ++z) {
+    if (g_zones.watering[z]) return;
   }
+  memset(g_zones.watering, 1, n);
 }
 
-void updateDryingStats() {
-  if (isnan(g_sensors.soilMoisture)) return;
-
-  uint32_t now = millis();
-  if (g_waterStats.lastDrySampleMs == 0) {
-    g_waterStats.lastDrySampleMs = now;
-    g_waterStats.lastDryMoisture = g_sensors.soilMoisture;
-    return;
-  }
-
-  uint32_t dtMs = now - g_waterStats.lastDrySampleMs;
-  if (dtMs < 5UL * 60UL * 1000UL) return; // раз в ~5 минут
+const float FAST_DRY_SPEED = 8.0f; // %/час
+const float SLOW_DRY_SPEED = 3.0f; // %/час
 
-  float dtHours = float(dtMs) / 3600000.0f;
-  if (dtHours <= 0.0f) dtHours = 0.0001f;
+// Один проход по зонам: скорость высыхания (раз в ~5 минут), подстройка
+// setpoint'а и прирост влажности за полив (по началу/концу полива зоны)
+void updateZoneStats(const TickContext& ctx) {
+  const uint32_t now = ctx.nowMs;
+  const uint8_t  n   = g_zoneCount;
 
-  float d = g_waterStats.lastDryMoisture - g_sensors.soilMoisture;
-  if (d > 0.0f) {
-    float speed = d / dtHours; // %/час
-    if (!isnan(g_waterStats.avgDrySpeed)) {
-      g_waterStats.avgDrySpeed = lerp(g_waterStats.avgDrySpeed, speed, 0.3f);
-    } else {
-      g_waterStats.avgDrySpeed = speed;
-    }
+  if (!g_zonesPrimed) {
+    memcpy(g_zones.lastWatering, g_zones.watering, n);
+    g_zonesPrimed = true;
   }
 
-  g_waterStats.lastDrySampleMs = now;
-  g_waterStats.lastDryMoisture = g_sensors.soilMoisture;
-}
-
-// ---------- адаптация по поливу ----------
+  for (uint8_t z = 0; z < n; ++z) {
+    const float sm = g_zones.soil[z];
 
-void adaptiveTuneWatering() {
-  if (isnan(g_waterStats.avgDrySpeed) ||
-      isnan(g_waterStats.avgDelta)) {
-    return;
-  }
-
-  const float FAST_DRY_SPEED = 8.0f; // %/час
-  const float SLOW_DRY_SPEED = 3.0f; // %/час
+    // --- скорость высыхания ---
+    if (!isnan(sm)) {
+      if (g_zones.lastDrySampleMs[z] == 0) {
+        g_zones.lastDrySampleMs[z] = now;
+        g_zones.lastDryMoisture[z] = sm;
+      } else {
+        uint32_t dtMs = now - g_zones.lastDrySampleMs[z];
+        if (dtMs >= 5UL * 60UL * 1000UL) {
+          float dtHours = float(dtMs) / 3600000.0f;
+          if (dtHours <= 0.0f) dtHours = 0.0001f;
+
+          float d = g_zones.lastDryMoisture[z] - sm;
+          if (d > 0.0f) {
+            float speed = d / dtHours; // %/час
+            g_zones.avgDrySpeed[z] = isnan(g_zones.avgDrySpeed[z])
+              ? speed : lerp(g_zones.avgDrySpeed[z], speed, 0.3f);
+          }
+
+          g_zones.lastDrySampleMs[z] = now;
+          g_zones.lastDryMoisture[z] = sm;
+        }
+      }
+    }
 
-  float offset = g_adapt.soilSetpointOffset;
+    // --- адаптация setpoint'а ---
+    if (!isnan(g_zones.avgDrySpeed[z]) && !isnan(g_zones.avgDelta[z])) {
+      float offset = g_zones.setpointOffset[z];
+      if (g_zones.avgDrySpeed[z] > FAST_DRY_SPEED) {
+        offset += 0.3f; // почва быстро высыхает — держим чуть влажнее
+      } else if (g_zones.avgDrySpeed[z] < SLOW_DRY_SPEED) {
+        offset -= 0.3f; // долго мокрая — держим чуть суше
+      }
+      g_zones.setpointOffset[z] = clampT(offset, g_limits.soilOffsetMin, g_limits.soilOffsetMax);
+    }
 
-  if (g_waterStats.avgDrySpeed > FAST_DRY_SPEED) {
-    offset += 0.3f; // почва быстро высыхает — держим чуть влажнее
-  } else if (g_waterStats.avgDrySpeed < SLOW_DRY_SPEED) {
-    offset -= 0.3f; // долго мокрая — держим чуть суше
+    // --- прирост за полив ---
+    const uint8_t w = g_zones.watering[z];
+    if (w != g_zones.lastWatering[z]) {
+      if (w) {
+        g_zones.beforeMoisture[z] = sm;   // полив начался
+      } else if (!isnan(g_zones.beforeMoisture[z]) && !isnan(sm)) {
+        float delta = sm - g_zones.beforeMoisture[z];
+        g_zones.avgDelta[z] = isnan(g_zones.avgDelta[z])
+          ? delta : lerp(g_zones.avgDelta[z], delta, 0.3f);
+      }
+      g_zones.lastWatering[z] = w;
+    }
   }
-
-  offset = clampT(offset, g_limits.soilOffsetMin, g_limits.soilOffsetMax);
-  g_adapt.soilSetpointOffset = offset;
 }
 
 // ---------- статистика света и адаптация ----------
 
-void updateLightStats() {
-  uint32_t now = millis();
+void integrateLight(const TickContext& ctx) {
+  uint32_t now = ctx.nowMs;
 
   if (g_light.lastSampleMs == 0) {
     g_light.lastSampleMs = now;
@@ -396,9 +452,9 @@ void updateLightStats() {
 
   g_light.lastSampleMs = now;
 
-  if (!isnan(g_sensors.lux)) {
+  if (!isnan(ctx.sensors.lux)) {
     float dtHours = float(dtMs) / 3600000.0f;
-    g_light.dailyLuxIntegral += g_sensors.lux * dtHours;
+    g_light.dailyLuxIntegral += ctx.sensors.lux * dtHours;
   }
 
   // примерно раз в час делаем подстройку порогов
@@ -436,75 +492,123 @@ void updateLightStats() {
 
 // ---------- стресс ----------
 
-void updateStress() {
-  const float t  = g_sensors.airTemp;
-  const float h  = g_sensors.airHum;
-  const float sm = g_sensors.soilMoisture;
-  const float lx = g_sensors.lux;
-
-  if (!isnan(t)) {
-    if (t < g_settings.comfortTempMin) {
-      g_stress.tempStress += (g_settings.comfortTempMin - t) * 0.1f;
-    } else if (t > g_settings.comfortTempMax) {
-      g_stress.tempStress += (t - g_settings.comfortTempMax) * 0.1f;
-    } else {
-      g_stress.tempStress *= 0.95f;
-    }
-  }
+// Модель нормирована на время: updateStress — свой этап планировщика,
+// шаг — реальное время с прошлого запуска, так что индекс не зависит от
+// того, как часто этап вызывают. Вклад фактора s за шаг dt:
+//   вне нормы   s += rate·dt            (rate = GAIN·отклонение)
+//   в норме     s *= e^(−dt/τ)
+//   нет данных  s не меняется          (rate = 0, keep = 1)
+// Факторы лежат подряд в StressState::level и считаются одним циклом;
+// почва — среднее по грядкам, которые считаются тем же ядром.
+
+// Множители для текущего dt: пересчёт только при смене dt,
+// в установившемся режиме этап идёт с одним и тем же шагом
+struct StressDecay {
+  float dt    = -1.0f;
+  float keep[SF_COUNT];      // e^(−dt/τ) по факторам
+  float a1h   = 0.0f;        // доля нового значения в 1-часовом EWMA
+  float a24h  = 0.0f;
+  float relax = 1.0f;        // возврат сдвигов setpoint'а при сильном стрессе
+};
 
-  if (!isnan(h)) {
-    if (h < g_settings.comfortHumMin) {
-      g_stress.humStress += (g_settings.comfortHumMin - h) * 0.05f;
-    } else if (h > g_settings.comfortHumMax) {
-      g_stress.humStress += (h - g_settings.comfortHumMax) * 0.05f;
-    } else {
-      g_stress.humStress *= 0.95f;
-    }
+StressDecay g_decay;
+
+void updateStressDecay(float dt) {
+  if (dt == g_decay.dt) return;
+  g_decay.dt = dt;
+  for (uint8_t f = 0; f < SF_COUNT; ++f) {
+    g_decay.keep[f] = expf(-dt / StressConfig::TAU_S[f]);
   }
+  g_decay.a1h   = 1.0f - expf(-dt / StressConfig::VIEW_1H_S);
+  g_decay.a24h  = 1.0f - expf(-dt / StressConfig::VIEW_24H_S);
+  g_decay.relax = expf(-dt / StressConfig::RELAX_TAU_S);
+}
 
-  if (!isnan(sm)) {
-    float sp = g_settings.soilMoistureSetpoint +
-               g_adapt.soilSetpointOffset;
-    sp = clampT(sp, 30.0f, 90.0f);
+// Насколько x вне [lo, hi]; 0 — в норме
+inline float outside(float x, float lo, float hi) {
+  return fmaxf(fmaxf(lo - x, x - hi), 0.0f);
+}
 
-    if (sm < sp - 15.0f) {
-      g_stress.soilStress += (sp - sm) * 0.08f;
-    } else if (sm > sp + 15.0f) {
-      g_stress.soilStress += (sm - sp) * 0.08f;
-    } else {
-      g_stress.soilStress *= 0.95f;
-    }
+// Ядро шага: s = s + rate·dt вне нормы, s·keep — в норме
+inline void integrate(float* s, const float* rate, const float* keep,
+                      uint8_t n, float dt) {
+  for (uint8_t i = 0; i < n; ++i) {
+    s[i] = rate[i] > 0.0f ? s[i] + rate[i] * dt : s[i] * keep[i];
   }
+}
 
-  if (!isnan(lx)) {
-    if (!SunPosition::isDaylight()) {
-      g_stress.lightStress *= 0.98f;
-    } else {
-      if (lx < 1000.0f) {
-        g_stress.lightStress += (1000.0f - lx) * 0.0005f;
-      } else if (lx > 40000.0f) {
-        g_stress.lightStress += (lx - 40000.0f) * 0.00002f;
-      } else {
-        g_stress.lightStress *= 0.97f;
-      }
-    }
-  }
+void accumulateStress(const TickContext& ctx, float dt) {
+  using namespace StressConfig;
+  updateStressDecay(dt);
 
-  g_stress.totalStress =
-    g_stress.tempStress +
-    g_stress.humStress  +
-    g_stress.soilStress +
-    g_stress.lightStress;
+  const float t  = ctx.sensors.airTemp;
+  const float h  = ctx.sensors.airHum;
+  const float lx = ctx.sensors.lux;
 
-  if (g_stress.totalStress > 300.0f) {
-    g_adapt.soilSetpointOffset *= 0.99f;
+  const CropProfiles::Params& cp = CropProfiles::active();
+
+  float rate[SF_SOIL];
+  float keep[SF_SOIL];
+  for (uint8_t f = 0; f < SF_SOIL; ++f) keep[f] = g_decay.keep[f];
+
+  rate[SF_TEMP] = isnan(t) ? 0.0f : outside(t, cp.tempMin, cp.tempMax) * TEMP_GAIN;
+  rate[SF_HUM]  = isnan(h) ? 0.0f : outside(h, cp.humMin, cp.humMax) * HUM_GAIN;
+  if (isnan(t)) keep[SF_TEMP] = 1.0f;
+  if (isnan(h)) keep[SF_HUM]  = 1.0f;
+
+  // ночью свет в норме
+  if (isnan(lx)) {
+    rate[SF_LIGHT] = 0.0f;
+    keep[SF_LIGHT] = 1.0f;
+  } else if (!ctx.daylight) {
+    rate[SF_LIGHT] = 0.0f;
+  } else {
+    rate[SF_LIGHT] = lx < LUX_LOW  ? (LUX_LOW - lx)  * LIGHT_LOW_GAIN
+                   : lx > LUX_HIGH ? (lx - LUX_HIGH) * LIGHT_HIGH_GAIN
+                   : 0.0f;
   }
-}
 
-// ---------- ночь по солнцу ----------
+  // воздух и свет — факторы до SF_SOIL
+  integrate(g_stress.level, rate, keep, SF_SOIL, dt);
+
+  // почва — по зонам, в общий индекс идёт среднее
+  loadZoneSoil(ctx);
+  const uint8_t n = g_zoneCount;
+  float zoneRate[MAX_ZONES];
+  float zoneKeep[MAX_ZONES];
+  for (uint8_t z = 0; z < n; ++z) {
+    const float sm = g_zones.soil[z];
+    if (isnan(sm)) {
+      zoneRate[z] = 0.0f;
+      zoneKeep[z] = 1.0f;
+      continue;
+    }
+    float sp = clampT(cp.soilSetpoint + g_zones.setpointOffset[z], 30.0f, 90.0f);
+    float dev = fabsf(sm - sp);
+    zoneRate[z] = dev > SOIL_BAND ? dev * SOIL_GAIN : 0.0f;
+    zoneKeep[z] = g_decay.keep[SF_SOIL];
+  }
+  integrate(g_zones.soilStress, zoneRate, zoneKeep, n, dt);
+
+  float soilSum = 0.0f;
+  for (uint8_t z = 0; z < n; ++z) soilSum += g_zones.soilStress[z];
+  g_stress.level[SF_SOIL] = (n == 1) ? soilSum : soilSum / n;
+
+  // сглаженные представления и сумма — один проход по всем факторам
+  float total = 0.0f;
+  for (uint8_t f = 0; f < SF_COUNT; ++f) {
+    const float s = g_stress.level[f];
+    g_stress.avg1h[f]  += (s - g_stress.avg1h[f])  * g_decay.a1h;
+    g_stress.avg24h[f] += (s - g_stress.avg24h[f]) * g_decay.a24h;
+    total += s;
+  }
+  g_stress.total = total;
 
-bool isNightBySun() {
-  return !SunPosition::isDaylight();
+  if (total > RELAX_ABOVE) {
+    for (uint8_t z = 0; z < n; ++z) {
+      g_zones.setpointOffset[z] *= g_decay.relax;
+    }
+  }
 }
 
 } // namespace
@@ -514,7 +618,7 @@ bool isNightBySun() {
 // -----------------------------------------------------------------------------
 
 void Automation::begin() {
-  applyCropProfile();
+  CropProfiles::begin();
 
   luxFiltered       = NAN;
   lightLastToggleMs = 0;
@@ -522,180 +626,163 @@ void Automation::begin() {
   g_light.dynamicLuxOn  = AutomationConfig::LIGHT_LUX_ON_THRESHOLD;
   g_light.dynamicLuxOff = AutomationConfig::LIGHT_LUX_OFF_THRESHOLD;
 
-  g_safety       = SafetyState{};
+  PumpGovernor::begin();
   g_climateHist  = ClimateHistory{};
-  g_waterStats   = WateringStats{};
+  g_vent         = VentState{};
+  PiController::reset(g_vent.pi, 0);
+  resetZones();
+  Automation::setZoneCount(ZoneConfig::ZONES);
   g_stress       = StressState{};
+  g_decay        = StressDecay{};
   g_adapt        = AdaptiveParams{};
   g_limits       = AdaptLimits{}; // вернёт значения по умолчанию
 }
 
-void Automation::stepCritical() {
+void Automation::stepCritical(const TickContext& ctx) {
   if (!g_settings.automationEnabled) return;
 
-  if (!isnan(g_sensors.airTemp)) {
-    if (g_sensors.airTemp > 40.0f) {
+  if (!isnan(ctx.sensors.airTemp)) {
+    if (ctx.sensors.airTemp > AIR_EMERGENCY_HOT) {
       DeviceManager::setFan(true);
       DeviceManager::setDoorAngle(100);
     }
-    if (g_sensors.airTemp < 5.0f) {
+    if (ctx.sensors.airTemp < AIR_EMERGENCY_COLD) {
       DeviceManager::setFan(false);
       DeviceManager::setDoorAngle(0);
     }
   }
 
-  updatePumpSafety();
-  updateStress();
 }
 
-void Automation::stepHigh() {
+void Automation::stepHigh(const TickContext& ctx) {
   if (!g_settings.automationEnabled) return;
 
-  updatePumpSafety();
-  updateDryingStats();
-  adaptiveTuneWatering();
-  updateWateringStatsOnPumpToggle();
+  loadZoneSoil(ctx);
+  syncWateringWithPump();
+  updateZoneStats(ctx);
 
-  if (g_safety.pumpLocked) {
-    if (g_sensors.pumpOn) {
-      DeviceManager::setPump(false);
-    }
-    updateStress();
-    return;
-  }
+  // насосом управляют правила — статистика зон копится, решения нет
+  if (Rules::drives(Actuator::Pump)) return;
 
-  if (isManualActive(manualPumpUntil)) {
-    updateStress();
-    return;
-  }
+  const uint8_t n = g_zoneCount;
+  bool stopAll = PumpGovernor::locked();
 
-  if (!isWithinWaterWindowInternal()) {
-    if (g_sensors.pumpOn) {
-      DeviceManager::setPump(false);
-    }
-    updateStress();
+  if (!stopAll && PumpGovernor::isManual(ctx.nowMs)) {
     return;
   }
-
-  if (isnan(g_sensors.soilMoisture)) {
-    if (g_sensors.pumpOn) {
-      DeviceManager::setPump(false);
-    }
-    updateStress();
-    return;
+  if (!isWithinWaterWindowInternal(ctx.localHour)) {
+    stopAll = true;
   }
 
-  float setpBase = float(g_settings.soilMoistureSetpoint);
-  float setp     = setpBase + g_adapt.soilSetpointOffset;
-  setp = clampT(setp, 30.0f, 90.0f);
-
-  float hyst = float(g_settings.soilMoistureHyst);
-  float lowThresh  = setp - hyst;
-  float highThresh = setp + hyst;
-
-  float sm = g_sensors.soilMoisture;
+  if (stopAll) {
+    memset(g_zones.watering, 0, n);
+  } else {
+    const CropProfiles::Params& cp = CropProfiles::active();
+    const float setpBase = float(cp.soilSetpoint);
+    const float hyst     = float(cp.soilHyst);
+
+    // гистерезис по каждой зоне; зона без данных не поливается
+    for (uint8_t z = 0; z < n; ++z) {
+      const float sm = g_zones.soil[z];
+      if (isnan(sm)) {
+        g_zones.watering[z] = 0;
+        continue;
+      }
 
-  if (!g_sensors.pumpOn && sm < lowThresh) {
-    DeviceManager::setPump(true);
-  } else if (g_sensors.pumpOn && sm > highThresh) {
-    DeviceManager::setPump(false);
+      float setp = clampT(setpBase + g_zones.setpointOffset[z], 30.0f, 90.0f);
+      if (!g_zones.watering[z] && sm < setp - hyst) {
+        g_zones.watering[z] = 1;
+      } else if (g_zones.watering[z] && sm > setp + hyst) {
+        g_zones.watering[z] = 0;
+      }
+    }
   }
 
-  updateStress();
+  // насос — пока поливается хоть одна зона; клапаны — по зонам
+  bool anyWatering = false;
+  for (uint8_t z = 0; z < n; ++z) {
+    anyWatering |= g_zones.watering[z] != 0;
+    DeviceManager::setValve(z, g_zones.watering[z] != 0);
+  }
+  if (anyWatering != g_sensors.pumpOn) {
+    PumpGovernor::request(anyWatering, ctx.nowMs);
+  }
 }
 
-void Automation::stepMedium() {
+void Automation::stepMedium(const TickContext& ctx) {
   if (!g_settings.automationEnabled) return;
 
-  updateClimateHistory();
+  updateClimateHistory(ctx);
 
-  if (isManualActive(manualFanUntil) ||
-      isManualActive(manualDoorUntil)) {
-    updateStress();
+  // выход удерживают руками или нет данных — регулятор ждёт с прежним
+  // выходом, интеграл не копит (после паузы шаг без интеграла)
+  if (isManualActive(manualFanUntil, ctx.nowMs) ||
+      isManualActive(manualDoorUntil, ctx.nowMs)) {
     return;
   }
 
-  if (isnan(g_sensors.airTemp) || isnan(g_sensors.airHum)) {
-    updateStress();
+  if (isnan(ctx.sensors.airTemp) || isnan(ctx.sensors.airHum)) {
     return;
   }
 
-  float t = g_sensors.airTemp;
-  float h = g_sensors.airHum;
+  const CropProfiles::Params& cp = CropProfiles::active();
+  const float t = ctx.sensors.airTemp;
+  const float h = ctx.sensors.airHum;
 
-  float tMin = g_settings.comfortTempMin;
-  float tMax = g_settings.comfortTempMax;
-  float hMin = g_settings.comfortHumMin;
-  float hMax = g_settings.comfortHumMax;
-
-  float tempOver  = 0.0f;
-  float tempUnder = 0.0f;
-  if (t > tMax) tempOver  = t - tMax;
-  if (t < tMin) tempUnder = tMin - t;
-
-  float humOver   = 0.0f;
-  float humUnder  = 0.0f;
-  if (h > hMax) humOver   = h - hMax;
-  if (h < hMin) humUnder  = hMin - h;
-
-  float trendBoost = 0.0f;
-  if (g_climateHist.dTdt > 1.0f) {
-    trendBoost += (g_climateHist.dTdt - 1.0f) * 0.5f;
-  }
-  if (g_climateHist.dHdt > 3.0f) {
-    trendBoost += (g_climateHist.dHdt - 3.0f) * 0.1f;
+  // аварийной вентиляцией правит stepCritical; регулятор встаёт на её
+  // выход, чтобы после аварии продолжить с него же (безударно)
+  if (isAirEmergency(t)) {
+    g_vent.demand = t > AIR_EMERGENCY_HOT ? 100 : 0;
+    g_vent.door   = g_vent.demand;
+    PiController::reset(g_vent.pi, PiController::fromInt(g_vent.demand));
+    return;
   }
 
-  float scoreHotHumid =
-    tempOver * 2.0f + humOver * 0.7f + trendBoost;
+  if (g_ventControl == VentControl::Heuristic) {
+    bool    needVent  = false;
+    uint8_t doorAngle = 0;
+    ventHeuristic(t, h, cp, needVent, doorAngle);
+    if (!Rules::drives(Actuator::Fan))  DeviceManager::setFan(needVent);
+    if (!Rules::drives(Actuator::Door)) DeviceManager::setDoorAngle(doorAngle);
+    return;
+  }
 
-  float scoreColdDry =
-    tempUnder * 2.0f + humUnder * 0.7f;
+  uint8_t mode = (uint8_t)g_settings.climateMode;
+  if (mode >= VENT_MODES) mode = (uint8_t)ClimateMode::Normal;
 
-  bool    needVent  = false;
-  uint8_t doorAngle = 0;
+  q16 u = PiController::step(g_vent.pi, VENT_GAINS[mode], VENT_LIMITS,
+                             PiController::fromFloat(ventError(t, h, cp)),
+                             ctx.nowMs, VentConfig::MAX_DT_MS);
+  g_vent.demand = (uint8_t)((u + PiController::ONE / 2) >> PiController::FRAC_BITS);
 
-  if (scoreHotHumid > 0.5f) {
-    needVent = true;
-    float norm = clampT(scoreHotHumid / 20.0f, 0.0f, 1.0f);
-    doorAngle = (uint8_t)(norm * 100.0f);
+  if (!Rules::drives(Actuator::Fan)) {
+    DeviceManager::setFanDuty(ventFanFor(g_vent.demand));
   }
-
-  if (scoreColdDry > 1.0f) {
-    needVent  = false;
-    doorAngle = 0;
+  if (!Rules::drives(Actuator::Door)) {
+    DeviceManager::setDoorAngle(ventDoorDeadband(ventDoorFor(g_vent.demand)));
   }
-
-  DeviceManager::setFan(needVent);
-  DeviceManager::setDoorAngle(doorAngle);
-
-  updateStress();
 }
 
-void Automation::stepLow() {
+void Automation::stepLow(const TickContext& ctx) {
   if (!g_settings.automationEnabled) return;
 
-  updateLightStats();
-
-  if (isManualActive(manualLightUntil)) {
-    updateStress();
+  if (isManualActive(manualLightUntil, ctx.nowMs)) {
     return;
   }
 
-  bool daylight = SunPosition::isDaylight();
-  bool night    = !daylight;
+  bool night = !ctx.daylight;
 
-  if (!isnan(g_sensors.lux)) {
+  if (!isnan(ctx.sensors.lux)) {
     if (isnan(luxFiltered)) {
-      luxFiltered = g_sensors.lux;
+      luxFiltered = ctx.sensors.lux;
     } else {
       luxFiltered = luxFiltered +
         AutomationConfig::LUX_FILTER_ALPHA *
-        (g_sensors.lux - luxFiltered);
+        (ctx.sensors.lux - luxFiltered);
     }
   }
 
-  uint32_t now = millis();
+  uint32_t now = ctx.nowMs;
   bool     wantLight = g_sensors.lightOn;
 
   if (night) {
@@ -723,6 +810,9 @@ void Automation::stepLow() {
     }
   }
 
+  // светом управляют правила — фильтр и статистика идут, реле не трогаем
+  if (Rules::drives(Actuator::Light)) return;
+
   if (wantLight != g_sensors.lightOn) {
     uint32_t dt = now - lightLastToggleMs;
 
@@ -737,51 +827,142 @@ void Automation::stepLow() {
       lightLastToggleMs = now;
     }
   }
+}
+
+void Automation::updateStress(const TickContext& ctx) {
+  // шаг отсчитываем и при выключенной автоматике, чтобы после включения
+  // не накопить весь простой разом
+  const bool started = g_stress.started;
+  float dt = (ctx.nowMs - g_stress.lastMs) / 1000.0f;
+  g_stress.lastMs  = ctx.nowMs;
+  g_stress.started = true;
+
+  if (!started || dt <= 0.0f) return;
+  if (!g_settings.automationEnabled) return;
+  if (dt > StressConfig::MAX_DT_S) dt = StressConfig::MAX_DT_S;
+  accumulateStress(ctx, dt);
+}
 
-  updateStress();
+void Automation::updateLightStats(const TickContext& ctx) {
+  if (!g_settings.automationEnabled) return;
+  integrateLight(ctx);
 }
 
 // ---------- ручной режим ----------
 
-void Automation::registerManualPump() {
-  manualPumpUntil = millis() + MANUAL_HOLD_MS;
+void Automation::registerManualLight(uint32_t holdMs) {
+  manualLightUntil = manualUntil(holdMs);
 }
 
-void Automation::registerManualLight() {
-  manualLightUntil = millis() + MANUAL_HOLD_MS;
+void Automation::registerManualFan(uint32_t holdMs) {
+  manualFanUntil = manualUntil(holdMs);
 }
 
-void Automation::registerManualFan() {
-  manualFanUntil = millis() + MANUAL_HOLD_MS;
+void Automation::registerManualDoor(uint32_t holdMs) {
+  manualDoorUntil = manualUntil(holdMs);
 }
 
-void Automation::registerManualDoor() {
-  manualDoorUntil = millis() + MANUAL_HOLD_MS;
+void Automation::setVentControl(VentControl c) {
+  if (c == g_ventControl) return;
+  g_ventControl = c;
+  // безударно: регулятор продолжит с текущего спроса
+  PiController::reset(g_vent.pi, PiController::fromInt(g_vent.demand));
+}
+
+bool Automation::isOutputHeld(Actuator a, const TickContext& ctx) {
+  switch (a) {
+    case Actuator::Light:
+      return isManualActive(manualLightUntil, ctx.nowMs);
+    case Actuator::Pump:
+      return PumpGovernor::isHeld(ctx.nowMs);
+    case Actuator::Fan:
+      return isAirEmergency(ctx.sensors.airTemp) ||
+             isManualActive(manualFanUntil, ctx.nowMs);
+    case Actuator::Door:
+      return isAirEmergency(ctx.sensors.airTemp) ||
+             isManualActive(manualDoorUntil, ctx.nowMs);
+    default:
+      return true;
+  }
 }
 
 // ---------- вспомогательные ----------
 
 bool Automation::isNightTime() {
-  return isNightBySun();
+  return !SunPosition::isDaylight();
 }
 
 bool Automation::isWithinWaterWindow() {
-  return isWithinWaterWindowInternal();
+  return isWithinWaterWindowInternal(TimeManager::getHour());
 }
 
 void Automation::updateDynamicWaterWindow() {
-  g_adapt.soilSetpointOffset = 0.0f;
-  g_waterStats = WateringStats{};
+  resetZoneStats();
+}
+
+// ---------- зоны ----------
+
+void Automation::setZoneCount(uint8_t n) {
+  if (n < 1) n = 1;
+  if (n > MAX_ZONES) n = MAX_ZONES;
+
+  // новые зоны начинают с чистого состояния
+  for (uint8_t z = g_zoneCount; z < n; ++z) {
+    g_zones.soil[z]            = NAN;
+    g_zones.setpointOffset[z]  = 0.0f;
+    g_zones.soilStress[z]      = 0.0f;
+    g_zones.beforeMoisture[z]  = NAN;
+    g_zones.avgDelta[z]        = NAN;
+    g_zones.avgDrySpeed[z]     = NAN;
+    g_zones.lastDryMoisture[z] = NAN;
+    g_zones.lastDrySampleMs[z] = 0;
+    g_zones.watering[z]        = 0;
+    g_zones.lastWatering[z]    = 0;
+  }
+  // у отключённых закрываем клапаны
+  for (uint8_t z = n; z < g_zoneCount; ++z) {
+    DeviceManager::setValve(z, false);
+  }
+  g_zoneCount = n;
+}
+
+uint8_t Automation::zoneCount() {
+  return g_zoneCount;
+}
+
+void Automation::setZoneSoil(uint8_t zone, float pct) {
+  if (zone >= MAX_ZONES) return;
+  portENTER_CRITICAL(&g_zoneInMux);
+  g_zoneIn[zone] = pct;
+  portEXIT_CRITICAL(&g_zoneInMux);
+}
+
+bool Automation::getZoneInfo(uint8_t zone, ZoneInfo& out) {
+  if (zone >= g_zoneCount) return false;
+  out.soilMoisture       = g_zones.soil[zone];
+  out.soilSetpointOffset = g_zones.setpointOffset[zone];
+  out.avgDrySpeed        = g_zones.avgDrySpeed[zone];
+  out.avgDeltaMoisture   = g_zones.avgDelta[zone];
+  out.stressSoil         = g_zones.soilStress[zone];
+  out.watering           = g_zones.watering[zone] != 0;
+  return true;
 }
 
 // ---------- диагностика / адаптация ----------
 
+static_assert(sizeof(Automation::DiagInfo::pumpDutyHourly) == PumpDuty::HOURS,
+              "DiagInfo::pumpDutyHourly must match PumpDuty::HOURS");
+
 Automation::DiagInfo Automation::getDiagInfo() {
   DiagInfo d{};
-  d.pumpMsDay          = g_safety.pumpWindowMs;
-  d.pumpLocked         = g_safety.pumpLocked;
-
-  d.soilSetpointOffset = g_adapt.soilSetpointOffset;
+  PumpGovernor::Status ps = PumpGovernor::status(Clock::millis());
+  d.pumpMsDay          = ps.dayMs;
+  d.pumpLocked         = ps.lock != PumpGovernor::Lock::None;
+  d.pumpLock           = (uint8_t)ps.lock;
+  d.pumpLockLeftMs     = ps.lockLeftMs;
+  PumpDuty::hourlyDuty(d.pumpDutyHourly);
+
+  d.soilSetpointOffset = g_zones.setpointOffset[0];
   d.soilAdaptMin       = g_limits.soilOffsetMin;
   d.soilAdaptMax       = g_limits.soilOffsetMax;
 
@@ -790,18 +971,25 @@ Automation::DiagInfo Automation::getDiagInfo() {
   d.luxAdaptMin        = g_limits.luxOffsetMin;
   d.luxAdaptMax        = g_limits.luxOffsetMax;
 
-  d.avgDrySpeed        = g_waterStats.avgDrySpeed;
-  d.avgDeltaMoisture   = g_waterStats.avgDelta;
+  d.avgDrySpeed        = g_zones.avgDrySpeed[0];
+  d.avgDeltaMoisture   = g_zones.avgDelta[0];
 
   d.dailyLuxIntegral   = g_light.dailyLuxIntegral;
   d.dynamicLuxOn       = g_light.dynamicLuxOn;
   d.dynamicLuxOff      = g_light.dynamicLuxOff;
 
-  d.stressTemp         = g_stress.tempStress;
-  d.stressHum          = g_stress.humStress;
-  d.stressSoil         = g_stress.soilStress;
-  d.stressLight        = g_stress.lightStress;
-  d.stressTotal        = g_stress.totalStress;
+  d.stressTemp         = g_stress.level[SF_TEMP];
+  d.stressHum          = g_stress.level[SF_HUM];
+  d.stressSoil         = g_stress.level[SF_SOIL];
+  d.stressLight        = g_stress.level[SF_LIGHT];
+  d.stressTotal        = g_stress.total;
+  d.stressTotal1h      = 0.0f;
+  d.stressTotal24h     = 0.0f;
+  for (uint8_t f = 0; f < SF_COUNT; ++f) {
+    d.stressTotal1h  += g_stress.avg1h[f];
+    d.stressTotal24h += g_stress.avg24h[f];
+  }
+  d.ventDemand         = g_vent.demand;
 
   return d;
 }
@@ -821,9 +1009,11 @@ void Automation::setAdaptationLimits(float soilMin, float soilMax,
   g_limits.luxOffsetMax  = luxMax;
 
   // пересжимаем текущие оффсеты под новый диапазон
-  g_adapt.soilSetpointOffset = clampT(g_adapt.soilSetpointOffset,
-                                      g_limits.soilOffsetMin,
-                                      g_limits.soilOffsetMax);
+  for (uint8_t z = 0; z < g_zoneCount; ++z) {
+    g_zones.setpointOffset[z] = clampT(g_zones.setpointOffset[z],
+                                       g_limits.soilOffsetMin,
+                                       g_limits.soilOffsetMax);
+  }
   g_adapt.luxOnOffset  = clampT(g_adapt.luxOnOffset,
                                 g_limits.luxOffsetMin,
                                 g_limits.luxOffsetMax);
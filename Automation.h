@@ -1,20 +1,41 @@
 // === FILE: Automation.h ===
 #pragma once
 #include <stdint.h>
+#include "TickContext.h"
 
 namespace Automation {
 
   void begin();
 
-  void stepCritical();
-  void stepHigh();
-  void stepMedium();
-  void stepLow();
+  // Этапы планировщика; контекст собирается один раз на тик (Tick::build)
+  void stepCritical(const TickContext& ctx);
+  void stepHigh(const TickContext& ctx);
+  void stepMedium(const TickContext& ctx);
+  void stepLow(const TickContext& ctx);
 
-  void registerManualPump();
-  void registerManualLight();
-  void registerManualFan();
-  void registerManualDoor();
+  // Этап стресс-индекса (StressConfig::PERIOD_MS): шаг — реальное время
+  // с прошлого запуска, так что частота вызова на значение не влияет
+  void updateStress(const TickContext& ctx);
+
+  // Интеграл света за день и подстройка порогов досветки — отдельно от
+  // переключения света (stepLow), чтобы его можно было отложить
+  void updateLightStats(const TickContext& ctx);
+
+  // Ручное управление: автоматика не трогает выход holdMs миллисекунд
+  // (насос — PumpGovernor::manual)
+  void registerManualLight(uint32_t holdMs);
+  void registerManualFan(uint32_t holdMs);
+  void registerManualDoor(uint32_t holdMs);
+
+  // Выход сейчас удерживается не автоматикой: ручное удержание,
+  // блокировка насоса по safety, аварийная вентиляция (перегрев/холод).
+  // Правила (Rules) такой выход не трогают.
+  bool isOutputHeld(Actuator a, const TickContext& ctx);
+
+  // Регулятор проветривания (stepMedium): PI по умолчанию или прежняя
+  // эвристика — для сравнения на хосте (tests/vent_step) и отката
+  enum class VentControl : uint8_t { Pi, Heuristic };
+  void setVentControl(VentControl c);
 
   bool isNightTime();
   bool isWithinWaterWindow();
@@ -23,12 +44,33 @@ namespace Automation {
   // сбрасывает адаптивные сдвиги и статистику полива.
   void updateDynamicWaterWindow();
 
+  // Грядки (зоны полива). Зона 0 — штатный датчик почвы, зоны 1.. — свой
+  // датчик (setZoneSoil); у каждой клапан (DeviceManager::setValve).
+  // Насос включён, пока поливается хоть одна зона. begin() ставит
+  // ZoneConfig::ZONES (Config.h не даёт задать несколько зон без клапанов).
+  void    setZoneCount(uint8_t n);        // 1..ZoneConfig::MAX_ZONES
+  uint8_t zoneCount();
+  void    setZoneSoil(uint8_t zone, float pct);   // из задачи опроса, потокобезопасно
+
+  struct ZoneInfo {
+    float soilMoisture;          // последний отсчёт, %
+    float soilSetpointOffset;    // адаптивный сдвиг setpoint'а, %
+    float avgDrySpeed;           // %/час
+    float avgDeltaMoisture;      // % за полив
+    float stressSoil;
+    bool  watering;
+  };
+  bool getZoneInfo(uint8_t zone, ZoneInfo& out);
+
   // Структура с диагностической информацией для Web UI
   struct DiagInfo {
-    uint32_t pumpMsDay;          // сколько насос работал за ~последние 24ч (мс)
-    bool     pumpLocked;         // заблокирован ли насос по safety
+    uint32_t pumpMsDay;          // сколько насос работал за последние 24ч (мс)
+    bool     pumpLocked;         // заблокирован ли насос (PumpGovernor)
+    uint8_t  pumpLock;           // PumpGovernor::Lock
+    uint32_t pumpLockLeftMs;     // до снятия блокировки
+    uint8_t  pumpDutyHourly[24]; // % работы насоса по часам, [23] — последний час
 
-    float soilSetpointOffset;    // адаптивный сдвиг setpoint'а почвы, %
+    float soilSetpointOffset;    // адаптивный сдвиг setpoint'а почвы (зона 0), %
     float soilAdaptMin;          // текущий минимум диапазона адаптации (%)
     float soilAdaptMax;          // текущий максимум диапазона адаптации (%)
 
@@ -37,8 +79,8 @@ namespace Automation {
     float luxAdaptMin;           // минимальный допустимый сдвиг порогов света
     float luxAdaptMax;           // максимальный допустимый сдвиг порогов света
 
-    float avgDrySpeed;           // средняя скорость высыхания почвы, %/час
-    float avgDeltaMoisture;      // средний прирост % влажности после одного полива
+    float avgDrySpeed;           // средняя скорость высыхания почвы (зона 0), %/час
+    float avgDeltaMoisture;      // средний прирост % влажности после одного полива (зона 0)
 
     float dailyLuxIntegral;      // интеграл света за "день" (lux*часы)
     float dynamicLuxOn;          // текущий порог включения света, лк
@@ -46,9 +88,13 @@ namespace Automation {
 
     float stressTemp;            // вклад температуры в стресс
     float stressHum;             // вклад влажности воздуха
-    float stressSoil;            // вклад почвы
+    float stressSoil;            // вклад почвы (среднее по зонам)
     float stressLight;           // вклад света
     float stressTotal;           // суммарный стресс
+    float stressTotal1h;         // он же, сглаженный за ~1 ч
+    float stressTotal24h;        // и за ~24 ч
+
+    uint8_t ventDemand;          // выход регулятора проветривания, %
   };
 
   // Получить актуальную диагностику для веб-а
@@ -0,0 +1,40 @@
+// === FILE: Clock.cpp ===
+#include "Clock.h"
+
+namespace {
+
+  uint32_t systemMonoMs() {
+    return ::millis();
+  }
+
+  time_t systemWallUtc() {
+    return time(nullptr);
+  }
+
+  // до bind() работаем от системных часов
+  Clock::Source g_src = { systemMonoMs, systemWallUtc };
+
+  // всё, что меньше, — "времени ещё нет" (RTC/NTP не подняты)
+  constexpr time_t MIN_VALID_UTC = 100000;
+}
+
+void Clock::bind(const Source& src) {
+  if (src.monoMs)  g_src.monoMs  = src.monoMs;
+  if (src.wallUtc) g_src.wallUtc = src.wallUtc;
+}
+
+Clock::Source Clock::systemSource() {
+  return Source{ systemMonoMs, systemWallUtc };
+}
+
+uint32_t Clock::millis() {
+  return g_src.monoMs();
+}
+
+time_t Clock::now() {
+  return g_src.wallUtc();
+}
+
+bool Clock::isWallValid() {
+  return now() >= MIN_VALID_UTC;
+}
@@ -0,0 +1,29 @@
+// === FILE: Clock.h ===
+#pragma once
+#include <Arduino.h>
+#include <time.h>
+
+// Единый источник времени для автоматики.
+// Модули читают время только через Clock::millis()/Clock::now(),
+// а конкретный источник подключается один раз при старте:
+// на ESP32 — millis()/time(), на хосте — ручные/ускоренные часы,
+// чтобы прогонять сутки и сезоны за микросекунды.
+namespace Clock {
+
+  struct Source {
+    uint32_t (*monoMs)();   // монотонные миллисекунды (как millis())
+    time_t   (*wallUtc)();  // UNIX-время, секунды (UTC)
+  };
+
+  // Подключить источник (вызывается в setup() до begin() модулей)
+  void bind(const Source& src);
+
+  // Системные часы: millis() + time(nullptr)
+  Source systemSource();
+
+  uint32_t millis();
+  time_t   now();
+
+  // true, если настенное время уже выставлено (NTP/RTC)
+  bool isWallValid();
+}
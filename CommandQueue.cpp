@@ -0,0 +1,160 @@
+// === FILE: CommandQueue.cpp ===
+#include "CommandQueue.h"
+#include "Config.h"
+#include "Globals.h"
+#include "DeviceManager.h"
+#include "Automation.h"
+#include "PumpGovernor.h"
+#include "CropProfiles.h"
+#include "StateMachine.h"
+#include "Clock.h"
+#include <Arduino.h>
+
+#include <atomic>
+
+namespace {
+
+  using namespace CommandQueue;
+
+  constexpr uint32_t QUEUE_SIZE = AutomationConfig::COMMAND_QUEUE_SIZE;
+  constexpr uint32_t QUEUE_MASK = QUEUE_SIZE - 1;
+  static_assert((QUEUE_SIZE & QUEUE_MASK) == 0, "COMMAND_QUEUE_SIZE must be a power of two");
+
+  // Ячейка Вьюкова: seq == pos — свободна для записи на позиции pos,
+  // seq == pos + 1 — заполнена и готова к чтению
+  struct Cell {
+    std::atomic<uint32_t> seq;
+    Command               cmd;
+  };
+
+  Cell                  g_cells[QUEUE_SIZE];
+  std::atomic<uint32_t> g_enqueuePos{0};
+  uint32_t              g_dequeuePos = 0;   // один читатель — без атомиков
+
+  std::atomic<uint32_t> g_pushed{0};
+  std::atomic<uint32_t> g_dropped{0};
+  uint32_t              g_applied      = 0;
+  uint32_t              g_maxLatencyMs = 0;
+
+  bool pop(Command& out) {
+    Cell& c = g_cells[g_dequeuePos & QUEUE_MASK];
+    uint32_t seq = c.seq.load(std::memory_order_acquire);
+    if ((int32_t)(seq - (g_dequeuePos + 1)) < 0) return false;   // пусто
+
+    out = c.cmd;
+    c.seq.store(g_dequeuePos + QUEUE_SIZE, std::memory_order_release);
+    g_dequeuePos++;
+    return true;
+  }
+
+  // Тот же ID (после правки профиля) — только применить правку;
+  // новый — пересчитать окно полива, выбор сохранит loop()
+  void applyProfile(uint8_t id) {
+    CropProfiles::applyStaged();   // правки профилей из Web
+    const bool changed = id != CropProfiles::activeId();
+    if (!CropProfiles::select(id)) {
+      Serial.printf("[Cmd] profile %u not found\n", (unsigned)id);
+      CropProfiles::refresh();
+      return;
+    }
+    if (!changed) return;
+    CropProfiles::requestSave();
+    Automation::updateDynamicWaterWindow();
+  }
+
+  void apply(const Command& c) {
+    const uint32_t holdMs = c.holdMs < AutomationConfig::MANUAL_HOLD_MAX_MS
+                          ? c.holdMs : AutomationConfig::MANUAL_HOLD_MAX_MS;
+    switch (c.target) {
+      case Target::Light: {
+        bool on = (c.action == Action::Toggle) ? !g_sensors.lightOn : (c.action == Action::On);
+        Automation::registerManualLight(holdMs);
+        DeviceManager::setLight(on);
+        break;
+      }
+      case Target::Pump: {
+        bool on = (c.action == Action::Toggle) ? !g_sensors.pumpOn
+                                               : (c.action == Action::On || c.action == Action::Pulse);
+        PumpGovernor::manual(on, holdMs, Clock::millis());
+        break;
+      }
+      case Target::Fan: {
+        bool on = (c.action == Action::Toggle) ? !g_sensors.fanOn : (c.action == Action::On);
+        Automation::registerManualFan(holdMs);
+        DeviceManager::setFan(on);
+        break;
+      }
+      case Target::Door: {
+        uint8_t angle;
+        if (c.action == Action::Set)         angle = c.value;
+        else if (c.action == Action::Toggle) angle = g_sensors.doorOpen ? 0 : 100;
+        else                                 angle = (c.action == Action::On) ? 100 : 0;
+        Automation::registerManualDoor(holdMs);
+        DeviceManager::setDoorAngle(angle);
+        break;
+      }
+      case Target::Profile:
+        applyProfile(c.value);
+        break;
+    }
+  }
+
+} // namespace
+
+void CommandQueue::begin() {
+  for (uint32_t i = 0; i < QUEUE_SIZE; ++i) {
+    g_cells[i].seq.store(i, std::memory_order_relaxed);
+  }
+  g_enqueuePos.store(0, std::memory_order_relaxed);
+  g_dequeuePos = 0;
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+bool CommandQueue::push(const Command& cmd) {
+  uint32_t pos = g_enqueuePos.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell& c = g_cells[pos & QUEUE_MASK];
+    uint32_t seq = c.seq.load(std::memory_order_acquire);
+    int32_t  dif = (int32_t)(seq - pos);
+
+    if (dif == 0) {
+      if (g_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        c.cmd = cmd;
+        c.seq.store(pos + 1, std::memory_order_release);
+        break;
+      }
+    } else if (dif < 0) {
+      g_dropped.fetch_add(1, std::memory_order_relaxed);
+      Serial.println("[Cmd] queue full, command dropped");
+      return false;
+    } else {
+      pos = g_enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  g_pushed.fetch_add(1, std::memory_order_relaxed);
+  StateMachine::notify(StateMachine::EVENT_MANUAL);
+  return true;
+}
+
+uint8_t CommandQueue::applyPending() {
+  uint8_t n = 0;
+  Command c;
+  while (pop(c)) {
+    apply(c);
+    uint32_t lat = Clock::millis() - c.tsMs;
+    if (lat > g_maxLatencyMs) g_maxLatencyMs = lat;
+    g_applied++;
+    n++;
+  }
+  return n;
+}
+
+CommandQueue::Stats CommandQueue::getStats() {
+  Stats s;
+  s.pushed       = g_pushed.load(std::memory_order_relaxed);
+  s.dropped      = g_dropped.load(std::memory_order_relaxed);
+  s.applied      = g_applied;
+  s.maxLatencyMs = g_maxLatencyMs;
+  return s;
+}
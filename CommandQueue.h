@@ -0,0 +1,51 @@
+// === FILE: CommandQueue.h ===
+#pragma once
+#include <stdint.h>
+
+// Очередь команд исполнительным устройствам: Web UI (задача AsyncTCP)
+// и Telegram (loop()) только кладут команду, выполняет её automationTask.
+// Ограниченная lock-free MPMC-очередь (Вьюков), здесь — много писателей,
+// один читатель. Порядок выполнения = порядок успешных push().
+namespace CommandQueue {
+
+  // Profile — выбрать профиль культуры (Action::Set, value = ID):
+  // g_settings и действующие диапазоны меняются только в automationTask
+  enum class Target : uint8_t { Light, Pump, Fan, Door, Profile };
+
+  enum class Action : uint8_t {
+    Off,
+    On,
+    Toggle,   // инвертировать состояние на момент выполнения
+    Pulse,    // насос: включить, выключит safety/автоматика
+    Set       // дверь: value = 0..100 %; профиль: value = ID
+  };
+
+  enum class Source : uint8_t { WebUi, Telegram, Host };
+
+  struct Command {
+    Target   target;
+    Action   action;
+    Source   source;
+    uint8_t  value;    // для Action::Set
+    uint32_t tsMs;     // Clock::millis() постановки
+    uint32_t holdMs;   // сколько автоматика не трогает выход (≤ MANUAL_HOLD_MAX_MS)
+  };
+
+  // До запуска задач (setup)
+  void begin();
+
+  // false — очередь полна, команда отброшена
+  bool push(const Command& cmd);
+
+  // Выполнить всё накопленное; только из automationTask. Возвращает число команд.
+  uint8_t applyPending();
+
+  struct Stats {
+    uint32_t pushed;
+    uint32_t dropped;
+    uint32_t applied;
+    uint32_t maxLatencyMs;   // push → выполнение
+  };
+
+  Stats getStats();
+}
@@ -4,11 +4,17 @@
 
 // Пины — подправь под своё железо при необходимости
 namespace Pins {
+  constexpr uint8_t NO_PIN        = 0xFF;  // не подключено
+
   // Реле
   constexpr uint8_t RELAY_LIGHT   = 4;
   constexpr uint8_t RELAY_PUMP    = 17;
   constexpr uint8_t RELAY_FAN     = 16;
 
+  // ШИМ скорости вентилятора (MOSFET-драйвер). NO_PIN — только реле:
+  // скорость сводится к вкл/выкл с гистерезисом (VentConfig::FAN_RELAY_*)
+  constexpr uint8_t FAN_PWM       = NO_PIN;
+
   // Серво двери
   constexpr uint8_t SERVO_DOOR    = 19;
 
@@ -32,11 +38,54 @@ namespace StorageConfig {
   constexpr uint32_t MAGIC         = 0x594F544B; // 'YOTK'
   // Версия настроек — поднята, т.к. добавляли soilTempOffset и прочее
   constexpr uint16_t SETTINGS_VER  = 0x0005;
+
+  // Пользовательские профили культур — своя область EEPROM после настроек,
+  // чтобы правка профиля не трогала блок настроек и наоборот
+  constexpr uint32_t PROFILES_MAGIC    = 0x594F5043; // 'YOPC'
+  constexpr uint16_t PROFILES_VER      = 0x0001;
+  constexpr size_t   PROFILES_ADDR     = 512;
+  constexpr uint8_t  USER_PROFILES_MAX = 8;
+
+  // Кольцо наработки насоса (PumpDuty) — файл в SPIFFS
+  constexpr uint32_t PUMP_DUTY_MAGIC   = 0x594F5044; // 'YOPD'
+  constexpr uint16_t PUMP_DUTY_VER     = 0x0001;
 }
 
 namespace AutomationConfig {
   constexpr uint32_t AUTOMATION_INTERVAL_MS = 1000;
 
+  // Планировщик этапов (StateMachine): базовый тик и периоды этапов.
+  // Периоды кратны базовому тику, короче период — выше приоритет.
+  constexpr uint32_t SCHED_TICK_MS        = 100;
+  constexpr uint32_t SENSOR_PERIOD_MS     = 2000;            // задача опроса датчиков
+
+  // Бюджет одного тика планировщика; при превышении низкоприоритетные
+  // этапы (статистика света, диагностика, телеметрия) откладываются на
+  // OVERLOAD_HOLD_TICKS тиков сетки
+  constexpr uint32_t TICK_BUDGET_US       = 20000;
+  constexpr uint8_t  OVERLOAD_HOLD_TICKS  = 10;
+
+  // Ручная команда удерживает выход от автоматики (по умолчанию 5 минут)
+  constexpr uint32_t MANUAL_HOLD_MS       = 5UL * 60UL * 1000UL;
+  // Потолок удержания из команды (holdMs от Web API): дольше выход без
+  // автоматики не остаётся; держит holdMs далеко от 2^31 мс, предела
+  // сравнения "до" через разность со знаком
+  constexpr uint32_t MANUAL_HOLD_MAX_MS   = 4UL * 60UL * 60UL * 1000UL;
+  constexpr uint8_t  COMMAND_QUEUE_SIZE   = 16;              // степень двойки
+  constexpr uint32_t SAFETY_PERIOD_MS     = 100;             // защита насоса/перегрева
+  constexpr uint32_t CLIMATE_PERIOD_MS    = 1000;            // полив, вентиляция
+  constexpr uint32_t LIGHT_PERIOD_MS      = 5000;            // досветка
+  constexpr uint32_t DIAG_PERIOD_MS       = 10UL * 1000UL;
+  constexpr uint32_t TELEMETRY_PERIOD_MS  = 5UL * 60UL * 1000UL;
+
+  // Суточная таблица солнца: достраивается этапом SunTable по
+  // SUN_TABLE_CHUNK точек за запуск. Пока её нет, прямой расчёт
+  // повторяется не чаще SUN_REFRESH_S (за минуту высота меняется
+  // не больше чем на ~0.25°)
+  constexpr uint32_t SUN_TABLE_PERIOD_MS  = 1000;
+  constexpr uint16_t SUN_TABLE_CHUNK      = 48;
+  constexpr uint32_t SUN_REFRESH_S        = 60;
+
   // Пороги освещённости (включение/выключение с гистерезисом)
   constexpr float    LIGHT_LUX_ON_THRESHOLD  = 60.0f;  // включать досветку, если ниже
   constexpr float    LIGHT_LUX_OFF_THRESHOLD = 80.0f;  // выключать досветку, если выше
@@ -52,14 +101,192 @@ namespace AutomationConfig {
   constexpr uint8_t  NIGHT_START_HOUR = 20; // вечер
   constexpr uint8_t  NIGHT_END_HOUR   = 7;  // утро
 
-  // Ограничения насоса
-  constexpr uint32_t MAX_PUMP_RUN_MS  = 60UL * 1000UL;        // макс. разовый запуск
-  constexpr uint32_t MAX_PUMP_DAY_MS  = 15UL * 60UL * 1000UL; // макс. за сутки
-
   constexpr uint8_t  DEFAULT_WATER_START = 7;
   constexpr uint8_t  DEFAULT_WATER_END   = 21;
 }
 
+// Грядки (зоны полива): у каждой свой датчик влажности почвы и клапан,
+// насос общий. Зона 0 — штатный датчик (Pins::SOIL_ANALOG). Теплица с
+// одной грядкой (ZONES = 1) может обойтись без клапана — только насос;
+// при нескольких грядках клапан нужен каждой, иначе грядка без клапана
+// поливается вместе с любой другой.
+#ifndef YOTIK_MAX_ZONES
+#define YOTIK_MAX_ZONES 4
+#endif
+
+namespace ZoneConfig {
+  constexpr uint8_t MAX_ZONES = YOTIK_MAX_ZONES;  // ёмкость массивов состояния
+  constexpr uint8_t ZONES     = 1;                // сколько грядок подключено
+
+  // Пины грядок: АЦП датчика почвы (для зоны 0 не используется — у неё
+  // Pins::SOIL_ANALOG) и реле клапана. NO_PIN — не подключено.
+  constexpr uint8_t NO_PIN      = Pins::NO_PIN;
+  constexpr uint8_t SOIL_PINS[]  = { NO_PIN, NO_PIN, NO_PIN, NO_PIN };
+  constexpr uint8_t VALVE_PINS[] = { NO_PIN, NO_PIN, NO_PIN, NO_PIN };
+  constexpr bool    VALVE_ACTIVE_HIGH = true;
+
+  constexpr uint8_t soilPin(uint8_t z) {
+    return z < sizeof(SOIL_PINS) ? SOIL_PINS[z] : NO_PIN;
+  }
+  constexpr uint8_t valvePin(uint8_t z) {
+    return z < sizeof(VALVE_PINS) ? VALVE_PINS[z] : NO_PIN;
+  }
+
+  // У зон 0..n-1 есть клапаны (или зона одна)
+  constexpr bool valvesWired(uint8_t n) {
+    return n <= 1 || (valvePin(n - 1) != NO_PIN && valvesWired(n - 1));
+  }
+
+  static_assert(ZONES >= 1 && ZONES <= MAX_ZONES, "ZONES out of range");
+  static_assert(valvesWired(ZONES), "every zone needs a valve when ZONES > 1");
+}
+
+// Проветривание (Automation::stepMedium): PI-регулятор в Q16.16.
+// Ошибка — перегрев над верхней границей комфорта, °C; избыток влажности
+// пересчитывается в градусы с весом HUM_WEIGHT. Выход — "спрос на
+// проветривание" 0..100 %: сначала открывается дверь (полностью при
+// DOOR_FULL_AT), с FAN_FROM подключается вентилятор.
+namespace VentConfig {
+  struct Gains {
+    float kp;        // % выхода на 1 °C ошибки
+    float ki;        // % выхода на 1 °C·с
+    float rateMax;   // макс. скорость изменения выхода, %/с
+  };
+
+  // Расписание коэффициентов по ClimateMode: Eco, Normal, Aggressive
+  constexpr Gains GAINS[] = {
+    {  8.0f, 0.04f, 1.0f },
+    { 15.0f, 0.10f, 2.0f },
+    { 25.0f, 0.20f, 4.0f },
+  };
+
+  constexpr float   HUM_WEIGHT        = 0.2f;   // °C на 1 % RH сверх нормы
+  constexpr uint8_t DOOR_FULL_AT      = 70;     // % выхода — дверь открыта полностью
+  constexpr uint8_t FAN_FROM          = 50;     // % выхода — старт вентилятора
+  constexpr uint8_t DOOR_DEADBAND     = 4;      // % угла: мельче шаги серво не делаем
+  constexpr uint32_t MAX_DT_MS        = 10000;  // дольше — считаем паузой, без интеграла
+
+  // Вентилятор без ШИМ: реле по скважности с гистерезисом
+  constexpr uint8_t FAN_RELAY_ON      = 50;     // % скважности — включить
+  constexpr uint8_t FAN_RELAY_OFF     = 20;     // % — выключить
+}
+
+// Стресс-индекс (Automation::updateStress): свой этап планировщика, шаг —
+// реальное время с прошлого запуска. Вне нормы вклад фактора растёт на
+// GAIN·отклонение в секунду, в норме спадает с постоянной времени TAU_S.
+namespace StressConfig {
+  constexpr uint32_t PERIOD_MS      = 1000;
+  constexpr float    MAX_DT_S       = 60.0f;    // после долгой паузы не накапливаем скачком
+
+  constexpr float    TEMP_GAIN      = 0.1f;     // на 1 °C вне [tempMin, tempMax]
+  constexpr float    HUM_GAIN       = 0.05f;    // на 1 % RH вне [humMin, humMax]
+  constexpr float    SOIL_GAIN      = 0.08f;    // на 1 % от setpoint'а грядки
+  constexpr float    SOIL_BAND      = 15.0f;    // ± % вокруг setpoint'а — норма
+  constexpr float    LUX_LOW        = 1000.0f;  // днём темнее — недосвет
+  constexpr float    LUX_HIGH       = 40000.0f; // светлее — пересвет
+  constexpr float    LIGHT_LOW_GAIN  = 0.0005f; // на 1 лк недосвета
+  constexpr float    LIGHT_HIGH_GAIN = 0.00002f;// на 1 лк пересвета
+
+  // Спад в норме, с: температура, влажность, свет, почва
+  constexpr float    TAU_S[]        = { 20.0f, 20.0f, 33.0f, 20.0f };
+
+  // Сглаженные представления: EWMA с постоянной 1 ч и 24 ч
+  constexpr float    VIEW_1H_S      = 3600.0f;
+  constexpr float    VIEW_24H_S     = 86400.0f;
+
+  // Сильный стресс — сдвиги setpoint'ов почвы плавно возвращаются к нулю
+  constexpr float    RELAX_ABOVE    = 300.0f;
+  constexpr float    RELAX_TAU_S    = 100.0f;
+}
+
+// Лимиты насоса (PumpGovernor) — общие для автоматики, правил и ручных команд
+namespace PumpConfig {
+  constexpr uint32_t MAX_RUN_MS   = 60UL * 1000UL;          // макс. разовый запуск
+  constexpr uint32_t MAX_DAY_MS   = 15UL * 60UL * 1000UL;   // макс. за скользящие сутки
+  constexpr uint32_t COOLDOWN_MS  = 5UL * 60UL * 1000UL;    // пауза после остановки по MAX_RUN_MS
+  // суточная блокировка снимается, когда в окне снова есть место на полный запуск
+  static_assert(MAX_RUN_MS < MAX_DAY_MS, "run limit must be below day limit");
+}
+
+// Скользящее окно работы насоса (PumpDuty): кольцо корзин по BUCKET_MS,
+// на одну больше, чем помещается в сутки, — окно никогда не короче 24 ч.
+// Кольцо сохраняется в SPIFFS, после перезагрузки лимиты помнят сутки.
+// Пока настенное время не выставлено, сохранённые корзины считаются
+// записанными в момент старта (лимит строже, но не мягче).
+namespace PumpDutyConfig {
+  constexpr uint32_t WINDOW_MS      = 24UL * 60UL * 60UL * 1000UL;
+  constexpr uint32_t BUCKET_MS      = 5UL * 60UL * 1000UL;
+  constexpr uint16_t BUCKETS        = WINDOW_MS / BUCKET_MS + 1;
+
+  constexpr const char* PATH        = "/pumpduty.bin";
+  constexpr uint32_t SERVICE_PERIOD_MS = 10UL * 1000UL;    // этап сохранения
+  constexpr uint32_t SAVE_MIN_GAP_MS   = 60UL * 1000UL;    // не чаще раза в минуту
+  constexpr uint32_t SAVE_RUN_MS       = 10UL * 60UL * 1000UL; // во время работы насоса
+
+  static_assert(WINDOW_MS % BUCKET_MS == 0, "window must be whole buckets");
+}
+
+// Статистика каналов датчиков (SensorStats): на каждое окно — кольцо
+// корзин по BUCKET_MS, на одну больше, чем помещается в окно, как у
+// PumpDuty. Окна: 1 ч, 24 ч, 7 суток.
+namespace SensorStatsConfig {
+  constexpr uint32_t PERIOD_MS      = 1000;   // этап: чаще кадров датчиков (SENSOR_PERIOD_MS)
+  constexpr uint8_t  WINDOWS        = 3;
+  constexpr uint32_t WINDOW_MS[]    = { 3600UL * 1000UL, 24UL * 3600UL * 1000UL, 7UL * 24UL * 3600UL * 1000UL };
+  constexpr uint32_t BUCKET_MS[]    = { 5UL * 60UL * 1000UL, 3600UL * 1000UL, 6UL * 3600UL * 1000UL };
+
+  constexpr uint16_t buckets(uint8_t w) {
+    return (uint16_t)(WINDOW_MS[w] / BUCKET_MS[w] + 1);
+  }
+
+  static_assert(WINDOW_MS[0] % BUCKET_MS[0] == 0 &&
+                WINDOW_MS[1] % BUCKET_MS[1] == 0 &&
+                WINDOW_MS[2] % BUCKET_MS[2] == 0, "windows must be whole buckets");
+}
+
+// Проверка отсчётов датчиков (SensorHealth) перед публикацией кадра.
+// Недостоверный отсчёт канала заменяется на NAN — автоматика видит
+// "нет данных" и ведёт себя так же, как при отвале датчика.
+namespace SensorHealthConfig {
+  struct Limits {
+    float    min, max;   // физически возможный диапазон
+    float    maxRate;    // макс. скорость изменения, ед./с; 0 — не проверять
+    uint32_t flatMs;     // то же самое значение дольше — залип; 0 — не проверять
+  };
+
+  // В порядке SensorStats::Channel
+  constexpr Limits LIMITS[] = {
+    { -40.0f,    85.0f, 1.0f, 30UL * 60UL * 1000UL },        // airTemp, °C (предел BME280)
+    {   0.0f,   100.0f, 5.0f, 30UL * 60UL * 1000UL },        // airHum, %
+    { 300.0f,  1100.0f, 1.0f, 2UL * 3600UL * 1000UL },       // airPressure, гПа
+    // почва меняется медленно и квантуется АЦП — залипание только за 6 ч
+    {   0.0f,   100.0f, 5.0f, 6UL * 3600UL * 1000UL },       // soilMoisture, %
+    { -20.0f,    60.0f, 0.5f, 6UL * 3600UL * 1000UL },       // soilTemp, °C
+    // lux: облака меняют свет мгновенно; BH1750 с малым MTreg — до ~120 клк
+    {   0.0f, 120000.0f, 0.0f, 2UL * 3600UL * 1000UL },
+  };
+
+  // Скачок принимается как новый уровень, если следующие отсчёты его
+  // подтверждают (идут от него с допустимой скоростью)
+  constexpr uint8_t  CONFIRM_SAMPLES   = 3;
+
+  // Почва и воздух: расхождение больше — датчик почвы под подозрением
+  constexpr float    SOIL_AIR_MAX_DIFF = 25.0f;
+
+  // Diagnostics: тревога, если канал недостоверен дольше
+  constexpr uint32_t ALERT_AFTER_MS    = 60UL * 1000UL;
+}
+
+// Пользовательские правила (Rules): исходник во flash (SPIFFS),
+// байткод — в RAM, два буфера (действующий и следующий)
+namespace RulesConfig {
+  constexpr const char* SOURCE_PATH = "/rules.txt";
+  constexpr size_t   SOURCE_MAX  = 16384;  // байт исходника
+  constexpr uint16_t MAX_RULES   = 128;
+  constexpr uint16_t CODE_BYTES  = 4096;   // байткод условий всех правил
+  constexpr uint8_t  STACK_DEPTH = 32;     // глубина стека логических значений
+}
+
 // Координаты теплицы для SunPosition (пример: Москва)
 // поменяй под себя при желании
 namespace LocationConfig {
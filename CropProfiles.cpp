@@ -0,0 +1,262 @@
+// === FILE: CropProfiles.cpp ===
+#include "CropProfiles.h"
+#include "Globals.h"
+#include "Storage.h"
+
+#include <string.h>
+#include <math.h>
+#include <atomic>
+
+namespace {
+
+  using CropProfiles::Params;
+
+  struct Builtin {
+    uint8_t     id;
+    const char* name;
+    const char* hint;
+    Params      params;
+  };
+
+  // tempMin, tempMax, humMin, humMax, почва %, гистерезис, полив с, по
+  constexpr Builtin BUILTIN[] = {
+    { (uint8_t)CropProfile::Tomatoes,  "🍅 Томаты",
+      "Томаты любят тёплый и более сухой воздух, почва — достаточно влажная.",
+      { 22.0f, 28.0f, 55.0f, 75.0f, 65, 5, 7, 20 } },
+    { (uint8_t)CropProfile::Cucumbers, "🥒 Огурцы",
+      "Огурцы любят высокую влажность воздуха и более влажную почву.",
+      { 23.0f, 29.0f, 65.0f, 85.0f, 70, 5, 6, 21 } },
+    { (uint8_t)CropProfile::Greens,    "🥬 Зелень",
+      "Листовая зелень чувствительна к перегреву, предпочитает умеренный климат.",
+      { 18.0f, 24.0f, 50.0f, 70.0f, 60, 5, 7, 19 } },
+    { (uint8_t)CropProfile::Hibiscus,  "🌺 Гибискус",
+      "Гибискус любит тепло и умеренную влажность, не терпит переохлаждения.",
+      { 20.0f, 26.0f, 45.0f, 65.0f, 55, 5, 8, 19 } },
+  };
+
+  constexpr uint8_t BUILTIN_COUNT = sizeof(BUILTIN) / sizeof(BUILTIN[0]);
+
+  // ID встроенного профиля = индекс + 1: поиск — обращение по индексу
+  constexpr bool tableOk(uint8_t i) {
+    return i >= BUILTIN_COUNT ||
+           (BUILTIN[i].id == i + 1 && CropProfiles::valid(BUILTIN[i].params) && tableOk(i + 1));
+  }
+
+  static_assert(tableOk(0), "crop profile table: bad id order or out-of-range params");
+  static_assert(BUILTIN_COUNT == (uint8_t)CropProfile::Hibiscus,
+                "every CropProfile needs a row in BUILTIN");
+  static_assert(BUILTIN_COUNT < CropProfiles::USER_ID_BASE,
+                "built-in ids overlap user profile ids");
+
+  const char* CUSTOM_NAME = "⚙️ Своя настройка";
+  const char* CUSTOM_HINT = "Настройки заданы вручную под вашу культуру.";
+  const char* USER_HINT   = "Пользовательский профиль.";
+
+  // Пользовательские профили: запись во flash + раскодированные параметры.
+  // g_userParams читает автоматика через g_active, поэтому пишет их только
+  // automationTask (applyStaged); правка из Web ждёт в g_staged.
+  UserCropProfile g_userRec[CropProfiles::USER_MAX];
+  Params          g_userParams[CropProfiles::USER_MAX];
+
+  Params          g_staged[CropProfiles::USER_MAX];
+  uint8_t         g_stagedMask = 0;   // бит слота — в g_staged новая правка
+  portMUX_TYPE    g_stageMux   = portMUX_INITIALIZER_UNLOCKED;
+  static_assert(CropProfiles::USER_MAX <= 8, "g_stagedMask is one byte");
+
+  std::atomic<bool> g_savePending{false};   // выбор сменился, настройки не сохранены
+
+  Params          g_custom = {};          // копия диапазонов из g_settings
+  const Params*   g_active = &BUILTIN[0].params;
+  uint8_t         g_activeId = (uint8_t)CropProfile::Tomatoes;
+
+  Params decode(const UserCropProfile& r) {
+    Params p;
+    p.tempMin        = r.tempMinDeci / 10.0f;
+    p.tempMax        = r.tempMaxDeci / 10.0f;
+    p.humMin         = r.humMin;
+    p.humMax         = r.humMax;
+    p.soilSetpoint   = r.soilSetpoint;
+    p.soilHyst       = r.soilHyst;
+    p.waterStartHour = r.waterStartHour;
+    p.waterEndHour   = r.waterEndHour;
+    return p;
+  }
+
+  void encode(const Params& p, UserCropProfile& r) {
+    r.tempMinDeci    = (int16_t)lroundf(p.tempMin * 10.0f);
+    r.tempMaxDeci    = (int16_t)lroundf(p.tempMax * 10.0f);
+    r.humMin         = (uint8_t)lroundf(p.humMin);
+    r.humMax         = (uint8_t)lroundf(p.humMax);
+    r.soilSetpoint   = p.soilSetpoint;
+    r.soilHyst       = p.soilHyst;
+    r.waterStartHour = p.waterStartHour;
+    r.waterEndHour   = p.waterEndHour;
+  }
+
+  void loadCustom() {
+    g_custom.tempMin        = g_settings.comfortTempMin;
+    g_custom.tempMax        = g_settings.comfortTempMax;
+    g_custom.humMin         = g_settings.comfortHumMin;
+    g_custom.humMax         = g_settings.comfortHumMax;
+    g_custom.soilSetpoint   = g_settings.soilMoistureSetpoint;
+    g_custom.soilHyst       = g_settings.soilMoistureHyst;
+    g_custom.waterStartHour = g_settings.waterStartHour;
+    g_custom.waterEndHour   = g_settings.waterEndHour;
+  }
+
+  inline bool isUser(uint8_t id) {
+    return id >= CropProfiles::USER_ID_BASE && id < CropProfiles::ID_END;
+  }
+
+  // nullptr — нет такого профиля
+  const Params* resolve(uint8_t id) {
+    if (id == CropProfiles::CUSTOM_ID) return &g_custom;
+    if (id <= BUILTIN_COUNT)           return &BUILTIN[id - 1].params;
+    if (isUser(id)) {
+      uint8_t slot = id - CropProfiles::USER_ID_BASE;
+      if (g_userRec[slot].id == id) return &g_userParams[slot];
+    }
+    return nullptr;
+  }
+
+} // namespace
+
+void CropProfiles::begin() {
+  Storage::loadCropProfiles(g_userRec, USER_MAX);
+
+  for (uint8_t i = 0; i < USER_MAX; ++i) {
+    UserCropProfile& r = g_userRec[i];
+    if (r.id == 0) continue;
+
+    r.name[NAME_LEN - 1] = '\0';
+    g_userParams[i] = decode(r);
+    if (r.id != USER_ID_BASE + i || !valid(g_userParams[i])) {
+      Serial.printf("[Crop] user profile slot %u invalid, dropped\n", i);
+      r.id = 0;
+    }
+  }
+
+  portENTER_CRITICAL(&g_stageMux);
+  g_stagedMask = 0;
+  portEXIT_CRITICAL(&g_stageMux);
+
+  refresh();
+  Serial.printf("[Crop] active profile %u\n", g_activeId);
+}
+
+const CropProfiles::Params& CropProfiles::active() {
+  return *g_active;
+}
+
+uint8_t CropProfiles::activeId() {
+  return g_activeId;
+}
+
+bool CropProfiles::select(uint8_t id) {
+  loadCustom();
+  const Params* p = resolve(id);
+  if (!p) return false;
+
+  g_settings.cropProfile = (CropProfile)id;
+  g_activeId = id;
+  g_active   = p;
+  return true;
+}
+
+void CropProfiles::requestSave() {
+  g_savePending.store(true, std::memory_order_release);
+}
+
+void CropProfiles::loop() {
+  if (!g_savePending.exchange(false, std::memory_order_acquire)) return;
+  Storage::saveSettings(g_settings);
+}
+
+void CropProfiles::refresh() {
+  if (!select((uint8_t)g_settings.cropProfile)) {
+    Serial.printf("[Crop] profile %u not found, using custom\n", (unsigned)g_settings.cropProfile);
+    select(CUSTOM_ID);
+  }
+}
+
+bool CropProfiles::get(uint8_t id, Info& out) {
+  if (id == CUSTOM_ID) {
+    loadCustom();
+    out.id      = id;
+    out.builtin = true;
+    out.name    = CUSTOM_NAME;
+    out.hint    = CUSTOM_HINT;
+    out.params  = g_custom;
+    return true;
+  }
+  if (id <= BUILTIN_COUNT) {
+    const Builtin& b = BUILTIN[id - 1];
+    out.id      = id;
+    out.builtin = true;
+    out.name    = b.name;
+    out.hint    = b.hint;
+    out.params  = b.params;
+    return true;
+  }
+
+  const Params* p = isUser(id) ? resolve(id) : nullptr;
+  if (!p) return false;
+  const uint8_t slot = id - USER_ID_BASE;
+  out.id      = id;
+  out.builtin = false;
+  out.name    = g_userRec[slot].name;
+  out.hint    = USER_HINT;
+
+  // ещё не применённая правка — показываем её
+  portENTER_CRITICAL(&g_stageMux);
+  out.params  = (g_stagedMask & (1u << slot)) ? g_staged[slot] : *p;
+  portEXIT_CRITICAL(&g_stageMux);
+  return true;
+}
+
+uint8_t CropProfiles::saveUser(uint8_t id, const char* name, const Params& p) {
+  if (!valid(p) || !name || !name[0]) return 0;
+
+  uint8_t slot = USER_MAX;
+  if (id == 0) {
+    for (uint8_t i = 0; i < USER_MAX; ++i) {
+      if (g_userRec[i].id == 0) { slot = i; break; }
+    }
+  } else if (isUser(id)) {
+    slot = id - USER_ID_BASE;
+  }
+  if (slot >= USER_MAX) return 0;
+
+  UserCropProfile r{};
+  r.id = USER_ID_BASE + slot;
+  strncpy(r.name, name, NAME_LEN - 1);
+  encode(p, r);
+
+  // то же округление, что после перезагрузки; в g_userParams перенесёт
+  // applyStaged() в automationTask
+  portENTER_CRITICAL(&g_stageMux);
+  g_staged[slot] = decode(r);
+  g_stagedMask  |= 1u << slot;
+  portEXIT_CRITICAL(&g_stageMux);
+
+  g_userRec[slot] = r;
+  Storage::saveCropProfiles(g_userRec, USER_MAX);
+  return r.id;
+}
+
+void CropProfiles::applyStaged() {
+  portENTER_CRITICAL(&g_stageMux);
+  for (uint8_t i = 0; i < USER_MAX; ++i) {
+    if (g_stagedMask & (1u << i)) g_userParams[i] = g_staged[i];
+  }
+  g_stagedMask = 0;
+  portEXIT_CRITICAL(&g_stageMux);
+}
+
+bool CropProfiles::removeUser(uint8_t id) {
+  if (!isUser(id) || g_userRec[id - USER_ID_BASE].id != id) return false;
+
+  g_userRec[id - USER_ID_BASE] = UserCropProfile{};
+  Storage::saveCropProfiles(g_userRec, USER_MAX);
+  return true;
+}
@@ -0,0 +1,90 @@
+// === FILE: CropProfiles.h ===
+#pragma once
+#include "Types.h"
+#include "Config.h"
+
+// Профили культур: целевые диапазоны климата, почвы и окна полива.
+// Встроенные профили — constexpr-таблица (проверяется при компиляции),
+// пользовательские — во flash через Storage. Выбор профиля не трогает
+// g_settings: автоматика читает действующие диапазоны через active().
+namespace CropProfiles {
+
+  struct Params {
+    float   tempMin;          // комфорт воздуха, °C
+    float   tempMax;
+    float   humMin;           // %
+    float   humMax;
+    uint8_t soilSetpoint;     // целевая влажность почвы, %
+    uint8_t soilHyst;         // гистерезис, %
+    uint8_t waterStartHour;   // окно полива, локальные часы
+    uint8_t waterEndHour;
+  };
+
+  // Допустимые диапазоны — общие для таблицы (static_assert)
+  // и для профилей, присланных через Web API
+  constexpr float   TEMP_MIN_C   = 0.0f;
+  constexpr float   TEMP_MAX_C   = 45.0f;
+  constexpr uint8_t SOIL_SP_MIN  = 20;
+  constexpr uint8_t SOIL_SP_MAX  = 95;
+  constexpr uint8_t SOIL_HYST_MAX = 20;
+
+  constexpr bool valid(const Params& p) {
+    return p.tempMin >= TEMP_MIN_C && p.tempMax <= TEMP_MAX_C && p.tempMin < p.tempMax &&
+           p.humMin >= 0.0f && p.humMax <= 100.0f && p.humMin < p.humMax &&
+           p.soilSetpoint >= SOIL_SP_MIN && p.soilSetpoint <= SOIL_SP_MAX &&
+           p.soilHyst >= 1 && p.soilHyst <= SOIL_HYST_MAX &&
+           p.waterStartHour < 24 && p.waterEndHour < 24;
+  }
+
+  // ID: 0 — своя настройка (диапазоны из g_settings), 1.. — встроенные
+  // (CropProfile), USER_ID_BASE.. — пользовательские слоты во flash
+  constexpr uint8_t CUSTOM_ID    = (uint8_t)CropProfile::Custom;
+  constexpr uint8_t USER_ID_BASE = 16;
+  constexpr uint8_t USER_MAX     = StorageConfig::USER_PROFILES_MAX;
+  constexpr uint8_t ID_END       = USER_ID_BASE + USER_MAX;   // для перебора get()
+
+  constexpr size_t  NAME_LEN     = sizeof(UserCropProfile::name);
+
+  struct Info {
+    uint8_t     id;
+    bool        builtin;      // встроенный или "своя настройка" — не редактируется
+    const char* name;
+    const char* hint;
+    Params      params;
+  };
+
+  // Загрузить пользовательские профили и выбрать g_settings.cropProfile
+  void begin();
+
+  // Действующие диапазоны. Ссылка остаётся валидной до следующего
+  // select()/refresh(); вызов — одно чтение указателя.
+  const Params& active();
+  uint8_t       activeId();
+
+  // Выбрать профиль (false — нет такого ID). Пишет g_settings.cropProfile,
+  // но не сохраняет настройки — это делает вызывающий.
+  bool select(uint8_t id);
+
+  // Сохранить выбор позже, в loop(): EEPROM.commit перезаписывает сектор
+  // flash целиком (десятки мс), в тике automationTask ему не место
+  void requestSave();
+  void loop();
+
+  // Перечитать g_settings (после правки настроек): "своя настройка"
+  // берёт диапазоны оттуда, пропавший профиль сменяется на неё.
+  void refresh();
+
+  bool get(uint8_t id, Info& out);
+
+  // Завести (id == 0) или изменить пользовательский профиль; сохраняет
+  // только область профилей во flash. Возвращает ID или 0 при ошибке.
+  // Действующий профиль не переключают: после правки или удаления
+  // действующего вызывающий ставит выбор профиля в CommandQueue.
+  // Новые диапазоны ждут applyStaged(), get() показывает их сразу.
+  uint8_t saveUser(uint8_t id, const char* name, const Params& p);
+  bool    removeUser(uint8_t id);
+
+  // Перенести правки saveUser() в действующие диапазоны; только из
+  // automationTask (CommandQueue, выбор профиля) — active() читают там же
+  void applyStaged();
+}
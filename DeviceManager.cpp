@@ -3,6 +3,12 @@
 #include "Config.h"
 #include "Globals.h"
 #include "Storage.h"
+#include "Clock.h"
+#include "StateMachine.h"
+#include "Perf.h"
+#include "SensorBus.h"
+#include "Automation.h"
+#include "SensorHealth.h"
 
 #include <Wire.h>
 #include <Adafruit_BME280.h>
@@ -19,6 +25,8 @@ namespace {
   constexpr bool PUMP_ACTIVE_HIGH  = true;
   constexpr bool FAN_ACTIVE_HIGH   = true;
 
+  constexpr bool FAN_HAS_PWM       = Pins::FAN_PWM != Pins::NO_PIN;
+
   inline void relayWritePolarity(uint8_t pin, bool on, bool activeHigh) {
     if (activeHigh) {
       digitalWrite(pin, on ? HIGH : LOW);
@@ -45,7 +53,8 @@ namespace {
 
   bool ledInitDone = false;
 
-  void applyLedFromSettings(bool on) {
+  // Яркость 0–255 и цвет уже посчитаны из настроек (ledFromSettings)
+  void writeLed(uint8_t br, uint8_t r, uint8_t g, uint8_t b) {
     if (!LED_MATRIX_ENABLED) return;
 
     if (!ledInitDone) {
@@ -54,20 +63,7 @@ namespace {
       ledInitDone = true;
     }
 
-    // Яркость из настроек 0–100 → 0–255
-    uint8_t br = g_settings.lightBrightness;
-    if (br > 100) br = 100;
-    uint8_t neoBr = map(br, 0, 100, 0, 255);
-    ledStrip.setBrightness(neoBr);
-
-    // Цвет из настроек
-    uint8_t r = 0, g = 0, b = 0;
-    if (on) {
-      r = g_settings.lightColorR;
-      g = g_settings.lightColorG;
-      b = g_settings.lightColorB;
-    }
-
+    ledStrip.setBrightness(br);
     for (uint16_t i = 0; i < LED_COUNT; ++i) {
       ledStrip.setPixelColor(i, ledStrip.Color(r, g, b));
     }
@@ -78,14 +74,96 @@ namespace {
   uint16_t soilDryRaw = 3500;
   uint16_t soilWetRaw = 1800;
 
-  // ---------- ПЕРИОДИКА ОПРОСА ----------
-  uint32_t lastSensorMs                 = 0;
-  constexpr uint32_t SENSOR_INTERVAL_MS = 2000;
+  // ---------- ПУБЛИКАЦИЯ КАДРА ДАТЧИКОВ ----------
+  // sensorTask читает шину в свой буфер и одной записью SensorBus
+  // переносит кадр в g_sensors; читатели берут SensorBus::snapshot().
+  uint32_t g_frameSeq = 0;
+
+  struct SensorFrame {
+    float airTemp, airHum, airPressure;
+    float soilMoisture, soilTemp;
+    float lux;
+  };
+
+  using Channel = SensorHealth::Channel;
+  inline uint8_t ch(Channel c) { return (uint8_t)c; }
+
+  void publishFrame(const SensorFrame& f, uint32_t sampleMs) {
+    SensorBus::writeBegin();
+    g_sensors.airTemp      = f.airTemp;
+    g_sensors.airHum       = f.airHum;
+    g_sensors.airPressure  = f.airPressure;
+    g_sensors.soilMoisture = f.soilMoisture;
+    g_sensors.soilTemp     = f.soilTemp;
+    g_sensors.lux          = f.lux;
+    g_sensors.sampleMs     = sampleMs;
+    g_sensors.frameSeq     = ++g_frameSeq;
+    SensorBus::writeEnd();
+  }
 
-  // ---------- ЛИМИТЫ НАСОСА ----------
-  uint32_t pumpStartMs    = 0;
-  uint32_t pumpDayMs      = 0;
-  uint32_t pumpDayStartMs = 0;
+  void sensorTask(void*) {
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+      DeviceManager::acquireSensors();
+      vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(AutomationConfig::SENSOR_PERIOD_MS));
+    }
+  }
+
+  // ---------- СОСТОЯНИЕ ИСПОЛНИТЕЛЕЙ ----------
+  // g_want — что задали этапы в текущем тике (последний запрос побеждает),
+  // g_applied — что сейчас выведено на железо. Все set*() работают в задаче
+  // автоматики, так что блокировки не нужны.
+  constexpr uint8_t DOOR_UNKNOWN = 0xFF;   // серво ещё ни разу не выставлялось
+
+  struct Outputs {
+    bool     light;
+    bool     pump;
+    bool     fan;       // реле вентилятора
+    uint8_t  fanDuty;   // 0-100 %, на ШИМ (если Pins::FAN_PWM подключён)
+    uint8_t  door;      // 0-100 %
+    uint64_t valves;    // бит z — клапан грядки z открыт
+  };
+
+  static_assert(ZoneConfig::MAX_ZONES <= 64, "valve bitmask holds 64 zones");
+
+  Outputs g_want    = {};
+  Outputs g_applied = {};
+
+  // Что выведено на LED-матрицу: яркость 0–255 и цвет (нули, когда свет
+  // выключен). Меняется и от света, и от настроек цвета/яркости.
+  struct LedState {
+    uint8_t br, r, g, b;
+    bool operator!=(const LedState& o) const {
+      return br != o.br || r != o.r || g != o.g || b != o.b;
+    }
+  };
+
+  LedState g_ledApplied = {};
+
+  DeviceManager::OutputStats g_outStats = {};
+
+  LedState ledFromSettings(bool on) {
+    uint8_t br = g_settings.lightBrightness;
+    if (br > 100) br = 100;
+
+    LedState s = {};
+    s.br = map(br, 0, 100, 0, 255);
+    if (on) {
+      s.r = g_settings.lightColorR;
+      s.g = g_settings.lightColorG;
+      s.b = g_settings.lightColorB;
+    }
+    return s;
+  }
+
+  // Флаг выхода в g_sensors — только при изменении, чтобы повторные
+  // одинаковые запросы не гоняли версию SensorBus
+  void publishOutput(bool& field, bool value) {
+    if (field == value) return;
+    SensorBus::writeBegin();
+    field = value;
+    SensorBus::writeEnd();
+  }
 
 } // namespace
 
@@ -99,20 +177,40 @@ void DeviceManager::begin() {
   pinMode(Pins::RELAY_PUMP,  OUTPUT);
   pinMode(Pins::RELAY_FAN,   OUTPUT);
 
+  // клапаны грядок (у единственной грядки клапана может не быть)
+  for (uint8_t z = 0; z < ZoneConfig::MAX_ZONES; ++z) {
+    uint8_t pin = ZoneConfig::valvePin(z);
+    if (pin == ZoneConfig::NO_PIN) continue;
+    pinMode(pin, OUTPUT);
+    relayWritePolarity(pin, false, ZoneConfig::VALVE_ACTIVE_HIGH);
+  }
+
   relayWritePolarity(Pins::RELAY_LIGHT, false, LIGHT_ACTIVE_HIGH);
   relayWritePolarity(Pins::RELAY_PUMP,  false, PUMP_ACTIVE_HIGH);
   relayWritePolarity(Pins::RELAY_FAN,   false, FAN_ACTIVE_HIGH);
 
+  if (FAN_HAS_PWM) {
+    pinMode(Pins::FAN_PWM, OUTPUT);
+    analogWrite(Pins::FAN_PWM, 0);
+  }
+
   g_sensors.lightOn = false;
   g_sensors.pumpOn  = false;
   g_sensors.fanOn   = false;
 
   // --- СЕРВО ДВЕРИ ---
+  // положение выставит первый commitOutputs() (по умолчанию — закрыто)
   doorServo.attach(Pins::SERVO_DOOR);
   g_sensors.doorOpen = false;
 
+  g_want    = {};
+  g_applied = {};
+  g_applied.door = DOOR_UNKNOWN;
+  g_outStats = {};
+
   // --- I2C и датчики ---
   Wire.begin(Pins::I2C_SDA, Pins::I2C_SCL);
+  SensorHealth::begin();
 
   g_sensors.bmeOk        = false;
   g_sensors.bhOk         = false;
@@ -183,12 +281,8 @@ void DeviceManager::begin() {
   }
 
   // --- LED-матрица ---
-  applyLedFromSettings(false);
-
-  // --- Счётчики насоса ---
-  pumpDayStartMs = millis();
-  pumpDayMs      = 0;
-  pumpStartMs    = 0;
+  g_ledApplied = ledFromSettings(false);
+  writeLed(g_ledApplied.br, 0, 0, 0);
 
   Serial.println("[DeviceManager] init done");
 }
@@ -197,79 +291,108 @@ void DeviceManager::begin() {
 // ПЕРИОДИЧЕСКИЙ ОПРОС
 // -----------------------------------------------------------------------------
 
-void DeviceManager::loopFast() {
-  uint32_t now = millis();
-
-  // --- Опрос датчиков раз в SENSOR_INTERVAL_MS ---
-  if (now - lastSensorMs >= SENSOR_INTERVAL_MS) {
-    lastSensorMs = now;
+void DeviceManager::acquireSensors() {
+  uint32_t c0 = Perf::cycles();
+  SensorFrame f;
 
-    // BME280: температура, влажность, давление
-    if (g_sensors.bmeOk) {
-      g_sensors.airTemp     = bme.readTemperature();
-      g_sensors.airHum      = bme.readHumidity();
-      g_sensors.airPressure = bme.readPressure() / 100.0f; // Па → гПа
-    } else {
-      g_sensors.airTemp     = NAN;
-      g_sensors.airHum      = NAN;
-      g_sensors.airPressure = NAN;
-    }
+  // BME280: температура, влажность, давление
+  if (g_sensors.bmeOk) {
+    f.airTemp     = bme.readTemperature();
+    f.airHum      = bme.readHumidity();
+    f.airPressure = bme.readPressure() / 100.0f; // Па → гПа
+  } else {
+    f.airTemp     = NAN;
+    f.airHum      = NAN;
+    f.airPressure = NAN;
+  }
 
-    // BH1750: освещённость
-    if (g_sensors.bhOk) {
-      g_sensors.lux = bh.readLightLevel();
-    } else {
-      g_sensors.lux = NAN;
-    }
+  // BH1750: освещённость
+  if (g_sensors.bhOk) {
+    f.lux = bh.readLightLevel();
+  } else {
+    f.lux = NAN;
+  }
 
-    // Датчик почвы: влажность + температура
-    if (g_sensors.soilOk) {
-      // --- Влажность ---
-      int raw = analogRead(Pins::SOIL_ANALOG);
-      if (soilDryRaw != soilWetRaw) {
-        float norm = (float)(raw - soilWetRaw) / (float)(soilDryRaw - soilWetRaw);
-        norm = constrain(norm, 0.0f, 1.0f);
-        g_sensors.soilMoisture = (1.0f - norm) * 100.0f;
-      } else {
-        g_sensors.soilMoisture = NAN;
-      }
-
-      // --- Температура почвы ---
-      // Простая модель: считаем напряжение на АЦП и переводим в °C.
-      // Например, для LM35-подобного выхода: 10 мВ/°C, 0.5 В при 0 °C.
-      // T(°C) = (V - 0.5) * 100
-      int rawT = analogRead(Pins::SOIL_TEMP_ANALOG);
-      const float vRef = 3.3f; // опорное для АЦП ESP32
-      float voltage = (rawT / 4095.0f) * vRef;
-      float temp    = (voltage - 0.5f) * 100.0f;
-
-      // Калибровочный оффсет из настроек (можно задать +10.0 °C, если надо)
-      g_sensors.soilTemp = temp + g_settings.soilTempOffset;
+  // Датчик почвы: влажность + температура
+  if (g_sensors.soilOk) {
+    // --- Влажность ---
+    int raw = analogRead(Pins::SOIL_ANALOG);
+    if (soilDryRaw != soilWetRaw) {
+      float norm = (float)(raw - soilWetRaw) / (float)(soilDryRaw - soilWetRaw);
+      norm = constrain(norm, 0.0f, 1.0f);
+      f.soilMoisture = (1.0f - norm) * 100.0f;
     } else {
-      g_sensors.soilMoisture = NAN;
-      g_sensors.soilTemp     = NAN;
+      f.soilMoisture = NAN;
     }
 
-    // Вывод на TM1637 — просто температура воздуха
-    int tInt = isnan(g_sensors.airTemp) ? 0 : (int)lroundf(g_sensors.airTemp);
-    display.showNumberDec(tInt, true);
+    // --- Температура почвы ---
+    // Простая модель: считаем напряжение на АЦП и переводим в °C.
+    // Например, для LM35-подобного выхода: 10 мВ/°C, 0.5 В при 0 °C.
+    // T(°C) = (V - 0.5) * 100
+    int rawT = analogRead(Pins::SOIL_TEMP_ANALOG);
+    const float vRef = 3.3f; // опорное для АЦП ESP32
+    float voltage = (rawT / 4095.0f) * vRef;
+    float temp    = (voltage - 0.5f) * 100.0f;
+
+    // Калибровочный оффсет из настроек (можно задать +10.0 °C, если надо)
+    f.soilTemp = temp + g_settings.soilTempOffset;
+  } else {
+    f.soilMoisture = NAN;
+    f.soilTemp     = NAN;
   }
 
-  // --- Ограничение времени работы насоса за цикл ---
-  if (g_sensors.pumpOn) {
-    if (pumpStartMs == 0) pumpStartMs = now;
-    uint32_t runMs = now - pumpStartMs;
-    if (runMs > AutomationConfig::MAX_PUMP_RUN_MS) {
-      Serial.println("[Pump] Max run per cycle exceeded, stopping");
-      setPump(false);
+  // выбросы, залипание и несогласованность — в NAN до публикации кадра
+  const uint32_t sampleMs = Clock::millis();
+
+  // датчики остальных грядок — той же калибровкой и теми же проверками,
+  // что и штатный; недостоверный отсчёт зоны уходит в автоматику как NAN
+  for (uint8_t z = 1; z < Automation::zoneCount(); ++z) {
+    uint8_t pin = ZoneConfig::soilPin(z);
+    float   pct = NAN;
+    if (pin != ZoneConfig::NO_PIN && soilDryRaw != soilWetRaw) {
+      int raw = analogRead(pin);
+      float norm = (float)(raw - soilWetRaw) / (float)(soilDryRaw - soilWetRaw);
+      pct = (1.0f - constrain(norm, 0.0f, 1.0f)) * 100.0f;
     }
+    Automation::setZoneSoil(z, SensorHealth::checkZone(z, pct, sampleMs));
   }
 
-  // --- Суточный лимит насоса ---
-  if (now - pumpDayStartMs > 24UL * 60UL * 60UL * 1000UL) {
-    pumpDayStartMs = now;
-    pumpDayMs      = 0;
-  }
+  float v[SensorHealth::CHANNELS];
+  v[ch(Channel::AirTemp)]      = f.airTemp;
+  v[ch(Channel::AirHum)]       = f.airHum;
+  v[ch(Channel::AirPressure)]  = f.airPressure;
+  v[ch(Channel::SoilMoisture)] = f.soilMoisture;
+  v[ch(Channel::SoilTemp)]     = f.soilTemp;
+  v[ch(Channel::Lux)]          = f.lux;
+  SensorHealth::check(v, sampleMs);
+  f.airTemp      = v[ch(Channel::AirTemp)];
+  f.airHum       = v[ch(Channel::AirHum)];
+  f.airPressure  = v[ch(Channel::AirPressure)];
+  f.soilMoisture = v[ch(Channel::SoilMoisture)];
+  f.soilTemp     = v[ch(Channel::SoilTemp)];
+  f.lux          = v[ch(Channel::Lux)];
+
+  publishFrame(f, sampleMs);
+  Perf::record(Perf::Stage::Sensors, Perf::cycles() - c0);
+
+  // Вывод на TM1637 — просто температура воздуха
+  int tInt = isnan(f.airTemp) ? 0 : (int)lroundf(f.airTemp);
+  display.showNumberDec(tInt, true);
+
+  // климат реагирует на свежий отсчёт, не дожидаясь своего периода
+  StateMachine::notify(StateMachine::EVENT_SENSORS);
+}
+
+void DeviceManager::startSensorTask() {
+  xTaskCreatePinnedToCore(
+    sensorTask,
+    "sensorTask",
+    4096,
+    nullptr,
+    1,
+    nullptr,
+    0
+  );
 }
 
 // -----------------------------------------------------------------------------
@@ -277,52 +400,121 @@ void DeviceManager::loopFast() {
 // -----------------------------------------------------------------------------
 
 void DeviceManager::setLight(bool on) {
-  relayWritePolarity(Pins::RELAY_LIGHT, on, LIGHT_ACTIVE_HIGH);
-  g_sensors.lightOn = on;
-
-  applyLedFromSettings(on);
-
-  Serial.printf("[Light] %s (pin=%d)\n", on ? "ON" : "OFF", Pins::RELAY_LIGHT);
+  g_outStats.requests++;
+  g_want.light = on;
+  publishOutput(g_sensors.lightOn, on);
 }
 
 void DeviceManager::setPump(bool on) {
-  uint32_t now = millis();
-
-  if (on) {
-    if (pumpDayMs >= AutomationConfig::MAX_PUMP_DAY_MS) {
-      Serial.println("[Pump] Daily limit exceeded, cannot start");
-      g_sensors.pumpOn = false;
-      relayWritePolarity(Pins::RELAY_PUMP, false, PUMP_ACTIVE_HIGH);
-      return;
-    }
-    pumpStartMs = now;
-    relayWritePolarity(Pins::RELAY_PUMP, true, PUMP_ACTIVE_HIGH);
-    g_sensors.pumpOn = true;
-    Serial.println("[Pump] ON");
-  } else {
-    if (g_sensors.pumpOn && pumpStartMs > 0) {
-      uint32_t runMs = now - pumpStartMs;
-      pumpDayMs += runMs;
-    }
-    pumpStartMs = 0;
-    relayWritePolarity(Pins::RELAY_PUMP, false, PUMP_ACTIVE_HIGH);
-    g_sensors.pumpOn = false;
-    Serial.println("[Pump] OFF");
-  }
+  g_outStats.requests++;
+  g_want.pump = on;
+  publishOutput(g_sensors.pumpOn, on);
 }
 
 void DeviceManager::setFan(bool on) {
-  relayWritePolarity(Pins::RELAY_FAN, on, FAN_ACTIVE_HIGH);
-  g_sensors.fanOn = on;
-  Serial.printf("[Fan] %s (pin=%d)\n", on ? "ON" : "OFF", Pins::RELAY_FAN);
+  setFanDuty(on ? 100 : 0);
+}
+
+void DeviceManager::setFanDuty(uint8_t pct) {
+  g_outStats.requests++;
+  if (pct > 100) pct = 100;
+  g_want.fanDuty = pct;
+
+  // с ШИМ реле просто подаёт питание; без него — гистерезис по скважности
+  bool on;
+  if (FAN_HAS_PWM) {
+    on = pct > 0;
+  } else {
+    on = g_want.fan ? pct >= VentConfig::FAN_RELAY_OFF
+                    : pct >= VentConfig::FAN_RELAY_ON;
+  }
+  g_want.fan = on;
+  publishOutput(g_sensors.fanOn, on);
 }
 
 void DeviceManager::setDoorAngle(uint8_t angle) {
+  g_outStats.requests++;
   angle = constrain(angle, 0, 100);
-  int servoAngle = map(angle, 0, 100, 0, 180);
-  doorServo.write(servoAngle);
-  g_sensors.doorOpen = (angle > 10);
-  Serial.printf("[Door] angle=%u (open=%d)\n", angle, g_sensors.doorOpen ? 1 : 0);
+  g_want.door = angle;
+  publishOutput(g_sensors.doorOpen, angle > 10);
+}
+
+// Клапан зоны, считая с 0; реле переключит commitOutputs()
+void DeviceManager::setValve(uint8_t zone, bool on) {
+  if (zone >= ZoneConfig::MAX_ZONES) return;
+  g_outStats.requests++;
+  uint64_t bit = 1ULL << zone;
+  g_want.valves = on ? (g_want.valves | bit) : (g_want.valves & ~bit);
+}
+
+// Вывести заданное состояние на железо. Несколько запросов за тик
+// (например, stepCritical включил вентилятор, stepMedium выключил)
+// схлопываются в одно итоговое значение; неизменившиеся выходы
+// не трогаются вовсе — ни GPIO, ни серво, ни лог.
+void DeviceManager::commitOutputs() {
+  g_outStats.commits++;
+
+  if (g_want.light != g_applied.light) {
+    relayWritePolarity(Pins::RELAY_LIGHT, g_want.light, LIGHT_ACTIVE_HIGH);
+    g_applied.light = g_want.light;
+    g_outStats.light++;
+    Serial.printf("[Light] %s (pin=%d)\n", g_want.light ? "ON" : "OFF", Pins::RELAY_LIGHT);
+  }
+
+  // матрицу перерисовываем и при смене цвета/яркости в настройках
+  LedState led = ledFromSettings(g_want.light);
+  if (led != g_ledApplied) {
+    writeLed(led.br, led.r, led.g, led.b);
+    g_ledApplied = led;
+    g_outStats.ledRefreshes++;
+  }
+
+  if (g_want.pump != g_applied.pump) {
+    relayWritePolarity(Pins::RELAY_PUMP, g_want.pump, PUMP_ACTIVE_HIGH);
+    g_applied.pump = g_want.pump;
+    g_outStats.pump++;
+    Serial.println(g_want.pump ? "[Pump] ON" : "[Pump] OFF");
+  }
+
+  if (g_want.fan != g_applied.fan) {
+    relayWritePolarity(Pins::RELAY_FAN, g_want.fan, FAN_ACTIVE_HIGH);
+    g_applied.fan = g_want.fan;
+    g_outStats.fan++;
+    Serial.printf("[Fan] %s (pin=%d)\n", g_want.fan ? "ON" : "OFF", Pins::RELAY_FAN);
+  }
+
+  if (FAN_HAS_PWM && g_want.fanDuty != g_applied.fanDuty) {
+    analogWrite(Pins::FAN_PWM, (uint16_t)g_want.fanDuty * 255 / 100);
+    g_applied.fanDuty = g_want.fanDuty;
+    g_outStats.fanDuty++;
+  }
+
+  uint64_t valveDiff = g_want.valves ^ g_applied.valves;
+  for (uint8_t z = 0; valveDiff != 0 && z < ZoneConfig::MAX_ZONES; ++z) {
+    uint64_t bit = 1ULL << z;
+    if (!(valveDiff & bit)) continue;
+    valveDiff &= ~bit;
+
+    bool    on  = (g_want.valves & bit) != 0;
+    uint8_t pin = ZoneConfig::valvePin(z);
+    if (pin != ZoneConfig::NO_PIN) {
+      relayWritePolarity(pin, on, ZoneConfig::VALVE_ACTIVE_HIGH);
+      Serial.printf("[Valve] zone %u %s (pin=%d)\n", z, on ? "OPEN" : "CLOSED", pin);
+    }
+    g_outStats.valves++;
+  }
+  g_applied.valves = g_want.valves;
+
+  if (g_want.door != g_applied.door) {
+    doorServo.write(map(g_want.door, 0, 100, 0, 180));
+    g_applied.door = g_want.door;
+    g_outStats.door++;
+    Serial.printf("[Door] angle=%u (open=%d)\n", g_want.door, g_want.door > 10 ? 1 : 0);
+  }
+}
+
+DeviceManager::OutputStats DeviceManager::getOutputStats() {
+  return g_outStats;
 }
 
 // -----------------------------------------------------------------------------
@@ -4,12 +4,38 @@
 
 namespace DeviceManager {
   void begin();
-  void loopFast();   // опрос датчиков/ограничения помпы
 
+  // Опрос датчиков в отдельной задаче (ядро 0), период SENSOR_PERIOD_MS.
+  // acquireSensors() — один опрос + публикация кадра; его же зовут
+  // хост-прогоны, где задач нет.
+  void startSensorTask();
+  void acquireSensors();
+
+  // Исполнители. set*() только запоминают заданное состояние (и сразу
+  // отражают его в g_sensors.*On/doorOpen, чтобы Toggle и проверки внутри
+  // тика видели его); на реле, серво и LED-матрицу оно выводится одним
+  // commitOutputs() в конце тика и только если действительно изменилось.
   void setLight(bool on);
-  void setPump(bool on);
-  void setFan(bool on);
+  void setPump(bool on);             // без лимитов — зовёт только PumpGovernor
+  void setFan(bool on);              // = setFanDuty(on ? 100 : 0)
+  void setFanDuty(uint8_t pct);      // 0-100 %; без ШИМ — реле с гистерезисом
   void setDoorAngle(uint8_t angle); // 0-100 %
+  void setValve(uint8_t zone, bool on);   // клапан грядки 0..MAX_ZONES-1
+
+  void commitOutputs();
+
+  struct OutputStats {
+    uint32_t requests;      // вызовов set*()
+    uint32_t commits;       // вызовов commitOutputs()
+    uint32_t light;         // переключений реле света
+    uint32_t pump;          // переключений реле насоса
+    uint32_t fan;           // переключений реле вентилятора
+    uint32_t fanDuty;       // записей скважности ШИМ вентилятора
+    uint32_t door;          // записей в серво двери
+    uint32_t valves;        // переключений клапанов грядок
+    uint32_t ledRefreshes;  // перерисовок LED-матрицы
+  };
+  OutputStats getOutputStats();
 
   void setSoilCalibration(uint16_t dry, uint16_t wet);
   void getSoilCalibration(uint16_t& dry, uint16_t& wet);
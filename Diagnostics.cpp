@@ -1,39 +1,76 @@
 // === FILE: Diagnostics.cpp ===
 #include "Diagnostics.h"
 #include "Globals.h"
+#include "SensorBus.h"
 #include "TelegramAsync.h"
+#include "SensorHealth.h"
+#include "Clock.h"
+#include "Config.h"
 #include <Arduino.h>
 
 namespace {
   uint32_t lastDiagMs = 0;
-  const uint32_t DIAG_INTERVAL_MS = 10000;
+  const uint32_t DIAG_INTERVAL_MS = AutomationConfig::DIAG_PERIOD_MS;
   bool bmeAlertSent = false;
   bool bhAlertSent  = false;
+  bool faultAlertSent[SensorHealth::CHANNELS] = {};
+
+  // Канал недостоверен дольше ALERT_AFTER_MS — тревога; снова в норме — отбой
+  void checkSensorFaults(uint32_t now) {
+    for (uint8_t c = 0; c < SensorHealth::CHANNELS; ++c) {
+      const SensorHealth::Channel ch = (SensorHealth::Channel)c;
+      SensorHealth::Status st = SensorHealth::status(ch, now);
+
+      if (st.faults && st.badForMs >= SensorHealthConfig::ALERT_AFTER_MS &&
+          !faultAlertSent[c]) {
+        String msg = "Датчик ";
+        msg += SensorStats::channelName(ch);
+        msg += ": ";
+        msg += SensorHealth::faultName(st.faults);
+        msg += ", отсчёты отбрасываются";
+        TelegramAsync::sendAlert(msg);
+        faultAlertSent[c] = true;
+      } else if (!st.faults && faultAlertSent[c]) {
+        String msg = "Датчик ";
+        msg += SensorStats::channelName(ch);
+        msg += " снова в норме";
+        TelegramAsync::sendAlert(msg);
+        faultAlertSent[c] = false;
+      }
+    }
+  }
 }
 
 void Diagnostics::begin() {
-  lastDiagMs = millis();
+  lastDiagMs = Clock::millis();
 }
 
 void Diagnostics::loop() {
-  uint32_t now = millis();
+  uint32_t now = Clock::millis();
   if (now - lastDiagMs < DIAG_INTERVAL_MS) return;
-  lastDiagMs = now;
 
-  if (!g_sensors.bmeOk && !bmeAlertSent) {
+  // сетка без дрейфа (планировщик запускает нас ровно раз в период)
+  lastDiagMs += DIAG_INTERVAL_MS;
+  if (now - lastDiagMs >= DIAG_INTERVAL_MS) lastDiagMs = now;
+
+  const SensorData s = SensorBus::snapshot();
+
+  if (!s.bmeOk && !bmeAlertSent) {
     TelegramAsync::sendAlert("BME280 не найден");
     bmeAlertSent = true;
   }
-  if (!g_sensors.bhOk && !bhAlertSent) {
+  if (!s.bhOk && !bhAlertSent) {
     TelegramAsync::sendAlert("BH1750 не найден");
     bhAlertSent = true;
   }
 
-  if (!isnan(g_sensors.airTemp)) {
-    if (g_sensors.airTemp > g_settings.safetyTempMax + 2) {
+  checkSensorFaults(now);
+
+  if (!isnan(s.airTemp)) {
+    if (s.airTemp > g_settings.safetyTempMax + 2) {
       TelegramAsync::sendAlert("Перегрев теплицы!");
     }
-    if (g_sensors.airTemp < g_settings.safetyTempMin - 2) {
+    if (s.airTemp < g_settings.safetyTempMin - 2) {
       TelegramAsync::sendAlert("Переохлаждение теплицы!");
     }
   }
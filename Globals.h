@@ -2,5 +2,7 @@
 #pragma once
 #include "Types.h"
 
+// Пишется только внутри SensorBus::writeBegin()/writeEnd();
+// из других задач читать через SensorBus::snapshot()
 extern SensorData     g_sensors;
 extern SystemSettings g_settings;
\ No newline at end of file
@@ -0,0 +1,96 @@
+// === FILE: Perf.cpp ===
+#include "Perf.h"
+
+namespace {
+
+  Perf::StageStats g_stats[Perf::STAGE_COUNT];
+  portMUX_TYPE     g_mux = portMUX_INITIALIZER_UNLOCKED;
+  uint32_t         g_mhz = 0;
+
+  const char* const STAGE_NAMES[Perf::STAGE_COUNT] = {
+    "stepCritical",
+    "stepHigh",
+    "stepMedium",
+    "stepLow",
+    "pumpGov",
+    "telemetry",
+    "diagnostics",
+    "taskmon",
+    "suntable",
+    "rules",
+    "pumpduty",
+    "stress",
+    "sensorstats",
+    "lightstats",
+    "sensors",
+    "tick",
+  };
+
+  void clearStats(Perf::StageStats& s) {
+    s = Perf::StageStats{};
+    s.minCycles = UINT32_MAX;
+  }
+
+  uint8_t bucketFor(uint32_t us) {
+    uint8_t b = 0;
+    while (us > 1 && b < Perf::HIST_BUCKETS - 1) {
+      us >>= 1;
+      ++b;
+    }
+    return b;
+  }
+
+} // namespace
+
+uint32_t Perf::cycles() {
+  return ESP.getCycleCount();
+}
+
+uint32_t Perf::cpuMHz() {
+  if (g_mhz == 0) {
+    g_mhz = ESP.getCpuFreqMHz();
+    if (g_mhz == 0) g_mhz = 1;
+  }
+  return g_mhz;
+}
+
+void Perf::record(Stage st, uint32_t c) {
+  uint8_t idx = (uint8_t)st;
+  if (idx >= STAGE_COUNT) return;
+
+  uint8_t b = bucketFor(c / cpuMHz());
+
+  portENTER_CRITICAL(&g_mux);
+  StageStats& s = g_stats[idx];
+  if (s.count == 0) s.minCycles = UINT32_MAX;
+  s.count++;
+  s.sumCycles += c;
+  if (c < s.minCycles) s.minCycles = c;
+  if (c > s.maxCycles) s.maxCycles = c;
+  s.hist[b]++;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void Perf::reset() {
+  portENTER_CRITICAL(&g_mux);
+  for (auto& s : g_stats) clearStats(s);
+  portEXIT_CRITICAL(&g_mux);
+}
+
+Perf::StageStats Perf::get(Stage st) {
+  StageStats out{};
+  uint8_t idx = (uint8_t)st;
+  if (idx >= STAGE_COUNT) return out;
+
+  portENTER_CRITICAL(&g_mux);
+  out = g_stats[idx];
+  portEXIT_CRITICAL(&g_mux);
+
+  if (out.count == 0) out.minCycles = 0;
+  return out;
+}
+
+const char* Perf::stageName(Stage st) {
+  uint8_t idx = (uint8_t)st;
+  return idx < STAGE_COUNT ? STAGE_NAMES[idx] : "?";
+}
@@ -0,0 +1,52 @@
+// === FILE: Perf.h ===
+#pragma once
+#include <Arduino.h>
+
+// Профилировщик этапов automationTask по счётчику тактов CPU.
+// На каждый этап: число вызовов, min/avg/max и гистограмма
+// с логарифмическими корзинами по микросекундам.
+namespace Perf {
+
+  enum class Stage : uint8_t {
+    StepCritical = 0,
+    StepHigh,
+    StepMedium,
+    StepLow,
+    PumpGovernor,  // учёт и лимиты насоса
+    Telemetry,
+    Diagnostics,
+    TaskMonitor,
+    SunTable,      // достройка суточной таблицы солнца
+    Rules,         // пользовательские правила (Rules)
+    PumpDuty,      // сохранение окна наработки насоса
+    Stress,        // стресс-индекс
+    SensorStats,   // статистика каналов датчиков
+    LightStats,    // интеграл света и адаптация порогов досветки
+    Sensors,       // опрос датчиков (sensorTask, другое ядро)
+    Tick,          // вся итерация целиком
+    Count
+  };
+
+  constexpr uint8_t STAGE_COUNT  = (uint8_t)Stage::Count;
+
+  // Корзина b: [2^b, 2^(b+1)) мкс; 0 — всё, что < 2 мкс; последняя — всё, что дольше
+  constexpr uint8_t HIST_BUCKETS = 16;
+
+  struct StageStats {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t sumCycles;
+    uint32_t hist[HIST_BUCKETS];
+  };
+
+  uint32_t cycles();      // текущий счётчик тактов
+  uint32_t cpuMHz();      // тактов в микросекунде
+
+  void record(Stage st, uint32_t cycles);
+  void reset();
+
+  // Копия статистики этапа (под коротким критическим участком)
+  StageStats get(Stage st);
+  const char* stageName(Stage st);
+}
@@ -0,0 +1,60 @@
+// === FILE: PiController.cpp ===
+#include "PiController.h"
+
+namespace {
+
+  using PiController::q16;
+
+  inline q16 clampQ(int64_t v, q16 lo, q16 hi) {
+    if (v < lo) return lo;
+    if (v > hi) return hi;
+    return (q16)v;
+  }
+
+} // namespace
+
+void PiController::reset(State& s, q16 output) {
+  s.integral = output;
+  s.output   = output;
+  s.lastMs   = 0;
+  s.primed   = false;
+}
+
+PiController::q16 PiController::step(State& s, const Gains& g, const Limits& lim,
+                                     q16 error, uint32_t nowMs, uint32_t maxDtMs) {
+  if (!s.primed) {
+    s.lastMs = nowMs;
+    s.primed = true;
+    return s.output;
+  }
+
+  uint32_t dtMs  = nowMs - s.lastMs;
+  s.lastMs       = nowMs;
+  const bool pause = dtMs > maxDtMs;
+  if (pause) dtMs = maxDtMs;
+
+  // dt в секундах, Q16.16
+  const q16 dt = (q16)(((int64_t)dtMs << FRAC_BITS) / 1000);
+
+  const q16 p = mul(g.kp, error);
+  q16 integral = s.integral;
+  if (!pause) {
+    integral = clampQ((int64_t)integral + mul(mul(g.ki, error), dt), lim.outMin, lim.outMax);
+  }
+
+  const int64_t unsat = (int64_t)p + integral;
+  q16 out = clampQ(unsat, lim.outMin, lim.outMax);
+
+  if (g.rateMax > 0) {
+    const q16 maxStep = mul(g.rateMax, dt);
+    out = clampQ(out, s.output - maxStep, s.output + maxStep);
+  }
+
+  // выход упёрся (предел или скорость) в сторону ошибки — интеграл не копим
+  const bool heldUp   = error > 0 && unsat > out;
+  const bool heldDown = error < 0 && unsat < out;
+  if (!heldUp && !heldDown) s.integral = integral;
+
+  s.output = out;
+  return out;
+}
@@ -0,0 +1,52 @@
+// === FILE: PiController.h ===
+#pragma once
+#include <stdint.h>
+
+// PI-регулятор в фиксированной точке Q16.16 (без float в шаге).
+// Защита от насыщения интеграла — условным интегрированием: интеграл
+// не растёт, пока выход упёрт в предел или в ограничение скорости
+// в сторону ошибки. Выход ограничен по скорости (rateMax в секунду).
+namespace PiController {
+
+  using q16 = int32_t;
+
+  constexpr int     FRAC_BITS = 16;
+  constexpr q16     ONE       = (q16)1 << FRAC_BITS;
+
+  constexpr q16 fromFloat(float v) {
+    return (q16)(v * (float)ONE + (v >= 0.0f ? 0.5f : -0.5f));
+  }
+  constexpr q16 fromInt(int32_t v) { return v * ONE; }
+  constexpr float toFloat(q16 v)  { return (float)v / (float)ONE; }
+
+  inline q16 mul(q16 a, q16 b) {
+    return (q16)(((int64_t)a * b) >> FRAC_BITS);
+  }
+
+  struct Gains {
+    q16 kp;        // выход на единицу ошибки
+    q16 ki;        // выход на единицу ошибки за секунду
+    q16 rateMax;   // макс. изменение выхода за секунду; 0 — без ограничения
+  };
+
+  struct Limits {
+    q16 outMin;
+    q16 outMax;
+  };
+
+  struct State {
+    q16      integral;
+    q16      output;
+    uint32_t lastMs;
+    bool     primed;     // был хоть один шаг (есть lastMs)
+  };
+
+  // Начать с выхода output (безударное включение: интеграл = выход)
+  void reset(State& s, q16 output);
+
+  // Шаг в момент nowMs. error > 0 — выход должен расти.
+  // Первый шаг после reset только запоминает время. Пауза дольше
+  // maxDtMs (регулятор не вызывали) считается за maxDtMs и без интеграла.
+  q16 step(State& s, const Gains& g, const Limits& lim,
+           q16 error, uint32_t nowMs, uint32_t maxDtMs);
+}
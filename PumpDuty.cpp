@@ -0,0 +1,198 @@
+// === FILE: PumpDuty.cpp ===
+#include "PumpDuty.h"
+#include "Config.h"
+#include "Clock.h"
+#include "Storage.h"
+#include <string.h>
+
+namespace {
+
+  using namespace PumpDutyConfig;
+
+  // Корзина head — текущая, началась в g_bucketStartMs; (head + 1) % BUCKETS —
+  // самая старая, её обнуляем при переходе в следующую корзину
+  uint32_t g_buckets[BUCKETS];
+  uint16_t g_head          = 0;
+  uint32_t g_total         = 0;   // сумма всех корзин = наработка в окне
+  uint32_t g_bucketStartMs = 0;
+  uint32_t g_lastMs        = 0;   // до какого момента время уже учтено
+  bool     g_on            = false;
+  bool     g_started       = false;
+
+  // Сохранение
+  bool     g_dirty         = false;   // наработка менялась после сохранения
+  uint32_t g_lastSaveMs    = 0;
+
+  // Восстановленные корзины считаются записанными в момент старта, пока
+  // не известен настоящий возраст файла (настенное время)
+  bool     g_agePending    = false;
+  uint32_t g_savedUtc      = 0;
+  uint32_t g_bootMs        = 0;
+  uint16_t g_sinceBoot     = 0;   // сколько корзин прошло со старта
+
+  void addOn(uint32_t ms) {
+    if (ms == 0) return;
+    g_buckets[g_head] += ms;
+    g_total           += ms;
+    g_dirty            = true;
+  }
+
+  void nextBucket() {
+    g_head = (uint16_t)((g_head + 1) % BUCKETS);
+    g_total -= g_buckets[g_head];
+    g_buckets[g_head] = 0;
+    g_bucketStartMs  += BUCKET_MS;
+    if (g_sinceBoot < BUCKETS) g_sinceBoot++;
+  }
+
+  // Корзина, которая на k корзин старше текущей
+  inline uint16_t olderBy(uint16_t k) {
+    return (uint16_t)((g_head + BUCKETS - k % BUCKETS) % BUCKETS);
+  }
+
+  // Возраст файла стал известен: сдвинуть сохранённые корзины (те, что
+  // старше корзины старта) ещё на shift корзин в прошлое. Округление вниз —
+  // данные выглядят свежее, чем есть, лимит не ослабевает.
+  void ageRestored(time_t wallUtc) {
+    g_agePending = false;
+    if (g_savedUtc == 0 || wallUtc <= (time_t)g_savedUtc) return;
+
+    uint64_t fileAgeMs = (uint64_t)(wallUtc - g_savedUtc) * 1000ULL;
+    uint32_t uptimeMs  = Clock::millis() - g_bootMs;
+    if (fileAgeMs <= uptimeMs) return;
+
+    uint64_t shift64 = (fileAgeMs - uptimeMs) / BUCKET_MS;
+    uint16_t shift   = shift64 >= BUCKETS ? BUCKETS : (uint16_t)shift64;
+    if (shift == 0) return;
+
+    // корзины со сдвигом k > g_sinceBoot — сохранённые; идём от старых к новым,
+    // чтобы читать ещё не перезаписанные
+    for (uint16_t k = BUCKETS - 1; k > g_sinceBoot; --k) {
+      uint16_t dst = olderBy(k);
+      uint32_t v   = 0;
+      if (k >= shift && k - shift > g_sinceBoot) v = g_buckets[olderBy(k - shift)];
+      g_total += v - g_buckets[dst];
+      g_buckets[dst] = v;
+    }
+    Serial.printf("[PumpDuty] restored history aged by %u buckets, window %lu s\n",
+                  shift, (unsigned long)(g_total / 1000));
+  }
+
+  void save(const TickContext& ctx) {
+    PumpDutyHeader h{};
+    // пока возраст старых корзин не выяснен, время сохранения не пишем:
+    // иначе следующий старт состарит их от неверной точки
+    h.savedUtc  = ctx.wallValid && !g_agePending ? (uint32_t)ctx.wallUtc : 0;
+    h.headAgeMs = ctx.nowMs - g_bucketStartMs;
+    h.head      = g_head;
+    h.buckets   = BUCKETS;
+
+    Storage::savePumpDuty(h, g_buckets, BUCKETS);
+    g_dirty      = false;
+    g_lastSaveMs = ctx.nowMs;
+  }
+
+} // namespace
+
+void PumpDuty::begin() {
+  g_bootMs    = Clock::millis();
+  g_lastSaveMs = g_bootMs;
+  g_sinceBoot = 0;
+  g_started   = false;
+  g_on        = false;
+  g_dirty     = false;
+
+  PumpDutyHeader h{};
+  g_agePending = Storage::loadPumpDuty(h, g_buckets, BUCKETS);
+  g_total = 0;
+  for (uint16_t i = 0; i < BUCKETS; ++i) g_total += g_buckets[i];
+
+  if (g_agePending) {
+    g_head          = h.head;
+    g_savedUtc      = h.savedUtc;
+    // текущая корзина продолжается с того места, где её сохранили
+    g_bucketStartMs = g_bootMs - (h.headAgeMs < BUCKET_MS ? h.headAgeMs : 0);
+    Serial.printf("[PumpDuty] history loaded, window %lu s\n",
+                  (unsigned long)(g_total / 1000));
+  } else {
+    g_head          = 0;
+    g_savedUtc      = 0;
+    g_bucketStartMs = g_bootMs;
+  }
+  g_lastMs = g_bootMs;
+}
+
+void PumpDuty::account(bool on, uint32_t nowMs) {
+  if (!g_started) {
+    g_started = true;
+    g_lastMs  = nowMs;
+    g_on      = on;
+    return;
+  }
+
+  // простой дольше кольца: старые корзины всё равно обнулились бы, а
+  // последние BUCKETS - 1 корзин заполнит цикл ниже
+  uint32_t gap = nowMs - g_bucketStartMs;
+  if (gap >= (uint32_t)BUCKETS * BUCKET_MS) {
+    memset(g_buckets, 0, sizeof(g_buckets));
+    g_total          = 0;
+    g_bucketStartMs += (gap / BUCKET_MS - (BUCKETS - 1)) * BUCKET_MS;
+    g_lastMs         = g_bucketStartMs;
+    g_sinceBoot      = BUCKETS;
+  }
+
+  // интервал [g_lastMs, nowMs) режем по границам корзин
+  while (nowMs - g_bucketStartMs >= BUCKET_MS) {
+    uint32_t endMs = g_bucketStartMs + BUCKET_MS;
+    if (g_on) addOn(endMs - g_lastMs);
+    g_lastMs = endMs;
+    nextBucket();
+  }
+  if (g_on) addOn(nowMs - g_lastMs);
+  g_lastMs = nowMs;
+  g_on     = on;
+}
+
+uint32_t PumpDuty::windowMs() {
+  return g_total;
+}
+
+uint32_t PumpDuty::msUntilWithin(uint32_t limitMs, uint32_t nowMs) {
+  if (g_total <= limitMs) return 0;
+
+  // корзина со сдвигом k обнулится через (BUCKETS - 1 - k) смен корзины
+  // после конца текущей
+  uint32_t inHead  = nowMs - g_bucketStartMs;
+  uint32_t toNext  = inHead < BUCKET_MS ? BUCKET_MS - inHead : 0;
+  uint32_t total   = g_total;
+  for (uint16_t k = BUCKETS - 1; k > 0; --k) {
+    total -= g_buckets[olderBy(k)];
+    if (total <= limitMs) return toNext + (uint32_t)(BUCKETS - 1 - k) * BUCKET_MS;
+  }
+  return toNext + (uint32_t)(BUCKETS - 1) * BUCKET_MS;
+}
+
+void PumpDuty::service(const TickContext& ctx) {
+  if (g_agePending && ctx.wallValid) ageRestored(ctx.wallUtc);
+
+  if (!g_dirty) return;
+  uint32_t sinceSave = ctx.nowMs - g_lastSaveMs;
+  if (sinceSave < SAVE_MIN_GAP_MS) return;
+  // пока насос работает — не чаще SAVE_RUN_MS, после остановки — сразу
+  if (g_on && sinceSave < SAVE_RUN_MS) return;
+  save(ctx);
+}
+
+void PumpDuty::hourlyDuty(uint8_t out[HOURS]) {
+  constexpr uint16_t PER_HOUR = 3600000UL / BUCKET_MS;
+  static_assert(PER_HOUR * HOURS < BUCKETS, "ring shorter than histogram");
+
+  for (uint8_t h = 0; h < HOURS; ++h) {
+    uint32_t sum = 0;
+    for (uint16_t k = 0; k < PER_HOUR; ++k) {
+      sum += g_buckets[olderBy((uint16_t)(h * PER_HOUR + k))];
+    }
+    uint32_t pct = (sum + 18000UL) / 36000UL;   // % от часа с округлением
+    out[HOURS - 1 - h] = pct > 100 ? 100 : (uint8_t)pct;
+  }
+}
@@ -0,0 +1,35 @@
+// === FILE: PumpDuty.h ===
+#pragma once
+#include <Arduino.h>
+#include "TickContext.h"
+
+// Сколько насос работал за последние сутки — скользящее окно без
+// "обнуления раз в 24 ч". Время работы реле раскладывается по корзинам
+// PumpDutyConfig::BUCKET_MS; сумма по кольцу ведётся на ходу, так что
+// и учёт, и запрос — O(1). Окно — от 24 ч до 24 ч + BUCKET_MS.
+//
+// Учёт и лимиты — PumpGovernor, раз в тик. Всё — в automationTask.
+namespace PumpDuty {
+
+  void begin();
+
+  // Учесть время с прошлого вызова (насос был в состоянии прошлого
+  // вызова) и запомнить новое состояние реле
+  void account(bool on, uint32_t nowMs);
+
+  // Наработка насоса в окне, мс
+  uint32_t windowMs();
+
+  // Через сколько мс наработка в окне опустится до limitMs, если насос
+  // больше не включать (проход по кольцу — для диагностики)
+  uint32_t msUntilWithin(uint32_t limitMs, uint32_t nowMs);
+
+  // Этап планировщика: состарить восстановленное кольцо, когда станет
+  // известно настенное время, и сохранять его после работы насоса
+  void service(const TickContext& ctx);
+
+  // Гистограмма скважности: процент работы за каждый из последних 24 часов,
+  // out[0] — самый старый час, out[23] — последние 60 минут
+  constexpr uint8_t HOURS = 24;
+  void hourlyDuty(uint8_t out[HOURS]);
+}
@@ -0,0 +1,157 @@
+// === FILE: PumpGovernor.cpp ===
+#include "PumpGovernor.h"
+#include "PumpDuty.h"
+#include "DeviceManager.h"
+#include "Config.h"
+
+namespace {
+
+  using namespace PumpConfig;
+  using PumpGovernor::Lock;
+
+  bool     g_on              = false;   // что задано DeviceManager
+  uint32_t g_runStartMs      = 0;
+  Lock     g_lock            = Lock::None;
+  uint32_t g_cooldownUntilMs = 0;
+  uint32_t g_manualUntilMs   = 0;       // 0 — ручного удержания нет
+
+  uint32_t g_starts          = 0;
+  uint32_t g_forcedStops     = 0;
+  uint32_t g_refusals        = 0;
+
+  inline bool before(uint32_t nowMs, uint32_t untilMs) {
+    return (int32_t)(untilMs - nowMs) > 0;
+  }
+
+  void drive(bool on, uint32_t nowMs) {
+    if (on == g_on) return;
+    g_on = on;
+    if (on) {
+      g_runStartMs = nowMs;
+      g_starts++;
+    }
+    DeviceManager::setPump(on);
+  }
+
+  void engage(Lock l, uint32_t nowMs) {
+    g_lock = l;
+    if (l == Lock::Cooldown) g_cooldownUntilMs = nowMs + COOLDOWN_MS;
+    if (g_on) {
+      g_forcedStops++;
+      drive(false, nowMs);
+    }
+    Serial.printf("[Pump] Locked: %s\n", PumpGovernor::lockName(l));
+  }
+
+  void release() {
+    Serial.printf("[Pump] Lock released: %s\n", PumpGovernor::lockName(g_lock));
+    g_lock = Lock::None;
+  }
+
+} // namespace
+
+void PumpGovernor::begin() {
+  PumpDuty::begin();
+  g_on              = false;
+  g_runStartMs      = 0;
+  g_lock            = Lock::None;
+  g_cooldownUntilMs = 0;
+  g_manualUntilMs   = 0;
+  g_starts          = 0;
+  g_forcedStops     = 0;
+  g_refusals        = 0;
+  DeviceManager::setPump(false);
+}
+
+void PumpGovernor::tick(const TickContext& ctx) {
+  const uint32_t now = ctx.nowMs;
+
+  // прошлый тик закончился выводом на реле — g_on уже на железе
+  PumpDuty::account(g_on, now);
+  const uint32_t dayMs = PumpDuty::windowMs();
+
+  if (g_lock == Lock::Cooldown && !before(now, g_cooldownUntilMs)) {
+    release();
+  }
+  if (g_lock == Lock::DayLimit && dayMs + MAX_RUN_MS <= MAX_DAY_MS) {
+    release();
+  }
+  if (g_manualUntilMs != 0 && !before(now, g_manualUntilMs)) {
+    g_manualUntilMs = 0;
+  }
+
+  // суточный лимит главнее паузы: и после перезагрузки с полным окном
+  if (g_lock != Lock::DayLimit && dayMs >= MAX_DAY_MS) {
+    engage(Lock::DayLimit, now);
+  } else if (g_on && now - g_runStartMs >= MAX_RUN_MS) {
+    engage(Lock::Cooldown, now);
+  }
+}
+
+bool PumpGovernor::request(bool on, uint32_t nowMs) {
+  if (isManual(nowMs)) return false;
+  if (on && g_lock != Lock::None) {
+    g_refusals++;
+    return false;
+  }
+  drive(on, nowMs);
+  return true;
+}
+
+bool PumpGovernor::manual(bool on, uint32_t holdMs, uint32_t nowMs) {
+  if (on && g_lock != Lock::None) {
+    g_refusals++;
+    Serial.printf("[Pump] Manual start refused: %s\n", lockName(g_lock));
+    return false;
+  }
+  g_manualUntilMs = nowMs + holdMs;
+  if (g_manualUntilMs == 0) g_manualUntilMs = 1;
+  drive(on, nowMs);
+  return true;
+}
+
+bool PumpGovernor::locked() {
+  return g_lock != Lock::None;
+}
+
+bool PumpGovernor::isManual(uint32_t nowMs) {
+  return g_manualUntilMs != 0 && before(nowMs, g_manualUntilMs);
+}
+
+bool PumpGovernor::isHeld(uint32_t nowMs) {
+  return locked() || isManual(nowMs);
+}
+
+PumpGovernor::Status PumpGovernor::status(uint32_t nowMs) {
+  Status s{};
+  s.on           = g_on;
+  s.lock         = g_lock;
+  s.manual       = isManual(nowMs);
+  s.manualLeftMs = s.manual ? g_manualUntilMs - nowMs : 0;
+  s.runMs        = g_on ? nowMs - g_runStartMs : 0;
+  s.dayMs        = PumpDuty::windowMs();
+  s.dayLimitMs   = MAX_DAY_MS;
+  s.starts       = g_starts;
+  s.forcedStops  = g_forcedStops;
+  s.refusals     = g_refusals;
+
+  switch (g_lock) {
+    case Lock::Cooldown:
+      s.lockLeftMs = before(nowMs, g_cooldownUntilMs) ? g_cooldownUntilMs - nowMs : 0;
+      break;
+    case Lock::DayLimit:
+      s.lockLeftMs = PumpDuty::msUntilWithin(MAX_DAY_MS - MAX_RUN_MS, nowMs);
+      break;
+    default:
+      break;
+  }
+  return s;
+}
+
+const char* PumpGovernor::lockName(Lock l) {
+  switch (l) {
+    case Lock::Cooldown: return "cooldown";
+    case Lock::DayLimit: return "day limit";
+    default:             return "none";
+  }
+}
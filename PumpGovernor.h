@@ -0,0 +1,55 @@
+// === FILE: PumpGovernor.h ===
+#pragma once
+#include <Arduino.h>
+#include "TickContext.h"
+
+// Единственный хозяин насоса: учёт наработки (PumpDuty), лимит сессии,
+// суточный лимит по скользящему окну, пауза после принудительной
+// остановки и ручное удержание. Автоматика и правила просят насос через
+// request(), ручные команды (Web, Telegram через CommandQueue) — через
+// manual(); DeviceManager::setPump() напрямую больше никто не зовёт.
+// Лимиты — PumpConfig. Всё — в automationTask.
+namespace PumpGovernor {
+
+  enum class Lock : uint8_t {
+    None = 0,
+    Cooldown,    // пауза после остановки по PumpConfig::MAX_RUN_MS
+    DayLimit     // наработка за сутки достигла PumpConfig::MAX_DAY_MS
+  };
+
+  // Загрузить окно наработки и сбросить состояние (Automation::begin)
+  void begin();
+
+  // Этап планировщика, каждый тик: учесть наработку, остановить насос по
+  // лимитам, снять истёкшие блокировки
+  void tick(const TickContext& ctx);
+
+  // Автоматика и правила. false — отказано: блокировка или ручное удержание.
+  // Выключить при блокировке можно всегда.
+  bool request(bool on, uint32_t nowMs);
+
+  // Ручная команда: удерживает насос от автоматики на holdMs. Включение
+  // при блокировке отклоняется — лимиты действуют и на ручной полив.
+  bool manual(bool on, uint32_t holdMs, uint32_t nowMs);
+
+  bool locked();                    // Lock != None
+  bool isManual(uint32_t nowMs);    // идёт ручное удержание
+  bool isHeld(uint32_t nowMs);      // автоматике трогать насос нельзя
+
+  struct Status {
+    bool     on;
+    Lock     lock;
+    uint32_t lockLeftMs;     // до снятия; для DayLimit — оценка по окну
+    bool     manual;
+    uint32_t manualLeftMs;
+    uint32_t runMs;          // текущая сессия, 0 — насос выключен
+    uint32_t dayMs;          // наработка за скользящие сутки
+    uint32_t dayLimitMs;
+    uint32_t starts;         // включений с старта
+    uint32_t forcedStops;    // остановок по лимитам
+    uint32_t refusals;       // отклонённых запросов на включение
+  };
+  Status status(uint32_t nowMs);
+
+  const char* lockName(Lock l);
+}
@@ -0,0 +1,672 @@
+// === FILE: Rules.cpp ===
+#include "Rules.h"
+#include "Config.h"
+#include "Globals.h"
+#include "Storage.h"
+#include "Automation.h"
+#include "DeviceManager.h"
+#include "PumpGovernor.h"
+
+#include <atomic>
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+namespace {
+
+using namespace RulesConfig;
+
+// ---------- переменные ----------
+
+enum Var : uint8_t {
+  V_AIR_TEMP = 0,
+  V_AIR_HUM,
+  V_PRESSURE,
+  V_SOIL,
+  V_SOIL_TEMP,
+  V_LUX,
+  V_HOUR,
+  V_SUN_ALT,
+  V_DAY,
+  V_NIGHT,
+  V_LIGHT,
+  V_PUMP,
+  V_FAN,
+  V_DOOR,
+  V_COUNT
+};
+
+struct VarDef {
+  const char* name;
+  bool        flag;   // логическая: 0/1, можно без сравнения
+};
+
+constexpr VarDef VARS[V_COUNT] = {
+  { "airTemp",  false },
+  { "airHum",   false },
+  { "pressure", false },
+  { "soil",     false },
+  { "soilTemp", false },
+  { "lux",      false },
+  { "hour",     false },
+  { "sunAlt",   false },
+  { "day",      true  },
+  { "night",    true  },
+  { "light",    true  },
+  { "pump",     true  },
+  { "fan",      true  },
+  { "door",     true  },
+};
+
+// Значения переменных на тик: одно чтение контекста на все правила
+void loadVars(const TickContext& ctx, float* v) {
+  const SensorData& s = ctx.sensors;
+  v[V_AIR_TEMP]  = s.airTemp;
+  v[V_AIR_HUM]   = s.airHum;
+  v[V_PRESSURE]  = s.airPressure;
+  v[V_SOIL]      = s.soilMoisture;
+  v[V_SOIL_TEMP] = s.soilTemp;
+  v[V_LUX]       = s.lux;
+  // без настенного времени час и солнце неизвестны — сравнения ложны
+  v[V_HOUR]      = ctx.wallValid ? (float)ctx.localHour : NAN;
+  v[V_SUN_ALT]   = ctx.wallValid ? ctx.sunAltDeg : NAN;
+  v[V_DAY]       = ctx.daylight ? 1.0f : 0.0f;
+  v[V_NIGHT]     = ctx.daylight ? 0.0f : 1.0f;
+  v[V_LIGHT]     = s.lightOn  ? 1.0f : 0.0f;
+  v[V_PUMP]      = s.pumpOn   ? 1.0f : 0.0f;
+  v[V_FAN]       = s.fanOn    ? 1.0f : 0.0f;
+  v[V_DOOR]      = s.doorOpen ? 1.0f : 0.0f;
+}
+
+// ---------- байткод ----------
+
+// Условие правила — постфиксная запись на стеке логических значений.
+// Старшая тетрада опкода — вид инструкции, младшая — сравнение или
+// инверсия. not на этапе компиляции спускается до сравнений (законы
+// де Моргана), так что все сравнения монотонны по результату правила
+// и гистерезис можно применять к ним одинаково.
+enum : uint8_t {
+  OP_END    = 0x00,
+  OP_CMP_VC = 0x10,   // | Cmp; var, float32 — переменная с константой
+  OP_CMP_VV = 0x20,   // | Cmp; var, var
+  OP_FLAG   = 0x30,   // | 1 — инверсия; var — логическая переменная
+  OP_AND    = 0x40,
+  OP_OR     = 0x41,
+};
+
+enum Cmp : uint8_t { C_GT = 0, C_GE, C_LT, C_LE, C_EQ, C_NE };
+
+constexpr uint8_t NO_TARGET = 0xFF;
+
+struct Action {
+  uint8_t target;   // Actuator или NO_TARGET
+  uint8_t value;    // 0/1, для двери 0..100
+};
+
+struct Rule {
+  uint16_t codeOff;
+  uint16_t dwellS;
+  float    hyst;
+  Action   onTrue;
+  Action   onFalse;
+};
+
+struct Program {
+  uint16_t ruleCount;
+  uint16_t codeLen;
+  uint8_t  drives;   // биты Actuator, которыми управляют правила
+  Rule     rules[MAX_RULES];
+  uint8_t  code[CODE_BYTES];
+};
+
+// h — ослабление порога: > и >= сдвигаются вниз, < и <= — вверх.
+// NaN даёт false в любом сравнении, включая !=.
+inline bool compare(uint8_t c, float a, float b, float h) {
+  switch (c) {
+    case C_GT: return a >  b - h;
+    case C_GE: return a >= b - h;
+    case C_LT: return a <  b + h;
+    case C_LE: return a <= b + h;
+    case C_EQ: return a == b;
+    default:   return a == a && b == b && a != b;
+  }
+}
+
+// Стек — биты uint32_t, вершина в младшем бите; глубину проверил компилятор
+bool run(const uint8_t* pc, const float* vars, float h) {
+  uint32_t st = 0;
+  for (;;) {
+    const uint8_t op = *pc++;
+    switch (op & 0xF0) {
+      case OP_CMP_VC: {
+        float b;
+        memcpy(&b, pc + 1, sizeof(b));
+        st = (st << 1) | compare(op & 0x0F, vars[pc[0]], b, h);
+        pc += 1 + sizeof(b);
+        break;
+      }
+      case OP_CMP_VV:
+        st = (st << 1) | compare(op & 0x0F, vars[pc[0]], vars[pc[1]], h);
+        pc += 2;
+        break;
+      case OP_FLAG:
+        st = (st << 1) | ((vars[pc[0]] > 0.5f) ^ (op & 1));
+        pc += 1;
+        break;
+      case OP_AND & 0xF0: {
+        uint32_t top = st & 1;
+        st >>= 1;
+        st = (op == OP_AND) ? (st & (~1u | top)) : (st | top);
+        break;
+      }
+      default:
+        return st & 1;
+    }
+  }
+}
+
+// ---------- компилятор ----------
+
+enum TokKind : uint8_t { T_END, T_IDENT, T_NUM, T_CMP, T_LPAREN, T_RPAREN, T_BAD };
+
+struct Token {
+  TokKind     kind;
+  const char* text;
+  uint16_t    len;
+  float       num;
+  uint8_t     cmp;
+};
+
+struct Compiler {
+  const char* p;       // текущая позиция в строке
+  const char* end;     // конец строки (без '\n' и комментария)
+  Token       tok;
+  Program*    prog;
+  uint8_t     depth;   // текущая глубина стека
+  uint8_t     drives;
+  bool        failed;
+  char*       error;   // буфер CompileResult::error
+};
+
+constexpr size_t ERROR_LEN = sizeof(Rules::CompileResult::error);
+
+// Первая ошибка строки остаётся, остальные — следствия
+void fail(Compiler& c, const char* msg) {
+  if (c.failed) return;
+  c.failed = true;
+  snprintf(c.error, ERROR_LEN, "%s", msg);
+}
+
+// fmt с одним %.*s — текст лексемы
+void failAt(Compiler& c, const char* fmt, const Token& t) {
+  if (c.failed) return;
+  c.failed = true;
+  snprintf(c.error, ERROR_LEN, fmt, (int)t.len, t.text);
+}
+
+void next(Compiler& c) {
+  while (c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\r')) c.p++;
+
+  Token& t = c.tok;
+  t.text = c.p;
+  t.len  = 0;
+  if (c.p >= c.end) { t.kind = T_END; return; }
+
+  char ch = *c.p;
+  if (isalpha((unsigned char)ch) || ch == '_') {
+    while (c.p < c.end && (isalnum((unsigned char)*c.p) || *c.p == '_')) c.p++;
+    t.kind = T_IDENT;
+  } else if (isdigit((unsigned char)ch) || ch == '.' ||
+             (ch == '-' && c.p + 1 < c.end &&
+              (isdigit((unsigned char)c.p[1]) || c.p[1] == '.'))) {
+    // strtof не должен выйти за строку: копия числа в локальный буфер
+    char buf[24];
+    size_t n = 0;
+    while (c.p + n < c.end && n < sizeof(buf) - 1 &&
+           (isdigit((unsigned char)c.p[n]) || c.p[n] == '.' || (n == 0 && c.p[n] == '-'))) {
+      buf[n] = c.p[n];
+      n++;
+    }
+    buf[n] = '\0';
+    char* tail = nullptr;
+    t.num  = strtof(buf, &tail);
+    t.kind = (tail == buf + n && isfinite(t.num)) ? T_NUM : T_BAD;
+    c.p   += n;
+  } else if (ch == '(' || ch == ')') {
+    c.p++;
+    t.kind = (ch == '(') ? T_LPAREN : T_RPAREN;
+  } else if (ch == '<' || ch == '>' || ch == '=' || ch == '!') {
+    bool eq = (c.p + 1 < c.end && c.p[1] == '=');
+    t.kind  = T_CMP;
+    switch (ch) {
+      case '<': t.cmp = eq ? C_LE : C_LT; break;
+      case '>': t.cmp = eq ? C_GE : C_GT; break;
+      case '=': t.cmp = C_EQ; if (!eq) t.kind = T_BAD; break;
+      default:  t.cmp = C_NE; if (!eq) t.kind = T_BAD; break;
+    }
+    c.p += eq ? 2 : 1;
+  } else {
+    c.p++;
+    t.kind = T_BAD;
+  }
+  t.len = (uint16_t)(c.p - t.text);
+}
+
+bool isWord(const Token& t, const char* w) {
+  return t.kind == T_IDENT && strlen(w) == t.len && strncasecmp(t.text, w, t.len) == 0;
+}
+
+bool accept(Compiler& c, const char* w) {
+  if (!isWord(c.tok, w)) return false;
+  next(c);
+  return true;
+}
+
+int findVar(const Token& t) {
+  for (uint8_t i = 0; i < V_COUNT; ++i) {
+    if (isWord(t, VARS[i].name)) return i;
+  }
+  return -1;
+}
+
+void unexpected(Compiler& c, const char* what) {
+  char msg[ERROR_LEN];
+  if (c.tok.kind == T_END) {
+    snprintf(msg, sizeof(msg), "%s expected at end of line", what);
+  } else {
+    snprintf(msg, sizeof(msg), "%s expected, got '%.*s'", what, (int)c.tok.len, c.tok.text);
+  }
+  fail(c, msg);
+}
+
+void emit(Compiler& c, const void* data, size_t n) {
+  if (c.failed) return;
+  Program& pr = *c.prog;
+  if (pr.codeLen + n > CODE_BYTES) {
+    fail(c, "program too large");
+    return;
+  }
+  memcpy(pr.code + pr.codeLen, data, n);
+  pr.codeLen += (uint16_t)n;
+}
+
+void emitOp(Compiler& c, uint8_t op) { emit(c, &op, 1); }
+
+void push(Compiler& c) {
+  if (++c.depth > STACK_DEPTH) fail(c, "condition too deep");
+}
+
+uint8_t negateCmp(uint8_t cmp) {
+  static const uint8_t NEG[] = { C_LE, C_LT, C_GE, C_GT, C_NE, C_EQ };
+  return NEG[cmp];
+}
+
+uint8_t swapCmp(uint8_t cmp) {
+  static const uint8_t SWAP[] = { C_LT, C_LE, C_GT, C_GE, C_EQ, C_NE };
+  return SWAP[cmp];
+}
+
+void parseExpr(Compiler& c, bool neg);
+
+// операнд: переменная или число
+bool parseOperand(Compiler& c, int& var, float& num) {
+  var = -1;
+  if (c.tok.kind == T_NUM) {
+    num = c.tok.num;
+    next(c);
+    return true;
+  }
+  var = findVar(c.tok);
+  if (var < 0) {
+    if (c.tok.kind == T_IDENT) failAt(c, "unknown variable '%.*s'", c.tok);
+    else unexpected(c, "variable or number");
+    return false;
+  }
+  next(c);
+  return true;
+}
+
+void parseComparison(Compiler& c, bool neg) {
+  int   va, vb;
+  float na = 0.0f, nb = 0.0f;
+  const Token first = c.tok;
+  if (!parseOperand(c, va, na)) return;
+
+  if (c.tok.kind == T_BAD) {
+    failAt(c, "unexpected '%.*s'", c.tok);
+    return;
+  }
+  if (c.tok.kind != T_CMP) {
+    if (va < 0 || !VARS[va].flag) {
+      failAt(c, "comparison expected after '%.*s'", first);
+      return;
+    }
+    uint8_t ins[2] = { (uint8_t)(OP_FLAG | (neg ? 1 : 0)), (uint8_t)va };
+    emit(c, ins, sizeof(ins));
+    push(c);
+    return;
+  }
+
+  uint8_t cmp = c.tok.cmp;
+  next(c);
+  if (!parseOperand(c, vb, nb)) return;
+
+  if (va < 0 && vb < 0) {
+    fail(c, "comparison of two constants");
+    return;
+  }
+  if (va < 0) {              // 30 < airTemp  ->  airTemp > 30
+    cmp = swapCmp(cmp);
+    va  = vb;
+    vb  = -1;
+    nb  = na;
+  }
+  if (neg) cmp = negateCmp(cmp);
+
+  if (vb < 0) {
+    uint8_t ins[2 + sizeof(float)] = { (uint8_t)(OP_CMP_VC | cmp), (uint8_t)va };
+    memcpy(ins + 2, &nb, sizeof(float));
+    emit(c, ins, sizeof(ins));
+  } else {
+    uint8_t ins[3] = { (uint8_t)(OP_CMP_VV | cmp), (uint8_t)va, (uint8_t)vb };
+    emit(c, ins, sizeof(ins));
+  }
+  push(c);
+}
+
+void parseFactor(Compiler& c, bool neg) {
+  if (c.failed) return;
+  if (accept(c, "not")) {
+    parseFactor(c, !neg);
+    return;
+  }
+  if (c.tok.kind == T_LPAREN) {
+    next(c);
+    parseExpr(c, neg);
+    if (c.failed) return;
+    if (c.tok.kind != T_RPAREN) { unexpected(c, "')'"); return; }
+    next(c);
+    return;
+  }
+  parseComparison(c, neg);
+}
+
+// Под инверсией and и or меняются местами (де Морган)
+void parseTerm(Compiler& c, bool neg) {
+  parseFactor(c, neg);
+  while (!c.failed && accept(c, "and")) {
+    parseFactor(c, neg);
+    emitOp(c, neg ? OP_OR : OP_AND);
+    c.depth--;
+  }
+}
+
+void parseExpr(Compiler& c, bool neg) {
+  parseTerm(c, neg);
+  while (!c.failed && accept(c, "or")) {
+    parseTerm(c, neg);
+    emitOp(c, neg ? OP_AND : OP_OR);
+    c.depth--;
+  }
+}
+
+bool parseAction(Compiler& c, Action& a) {
+  static const char*    SWITCHES[] = { "light", "pump", "fan" };
+  static const Actuator TARGETS[]  = { Actuator::Light, Actuator::Pump, Actuator::Fan };
+
+  for (uint8_t i = 0; i < 3; ++i) {
+    if (!accept(c, SWITCHES[i])) continue;
+    a.target = (uint8_t)TARGETS[i];
+    if (accept(c, "on"))       a.value = 1;
+    else if (accept(c, "off")) a.value = 0;
+    else { unexpected(c, "on/off"); return false; }
+    return true;
+  }
+
+  if (accept(c, "door")) {
+    a.target = (uint8_t)Actuator::Door;
+    if (accept(c, "open"))       a.value = 100;
+    else if (accept(c, "close")) a.value = 0;
+    else if (c.tok.kind == T_NUM && c.tok.num >= 0.0f && c.tok.num <= 100.0f) {
+      a.value = (uint8_t)lroundf(c.tok.num);
+      next(c);
+    } else { unexpected(c, "door 0..100"); return false; }
+    return true;
+  }
+
+  unexpected(c, "action (light/pump/fan/door)");
+  return false;
+}
+
+void parseRule(Compiler& c) {
+  Program& pr = *c.prog;
+  if (pr.ruleCount >= MAX_RULES) {
+    fail(c, "too many rules");
+    return;
+  }
+
+  Rule r{};
+  r.codeOff = pr.codeLen;
+  r.onFalse.target = NO_TARGET;
+
+  if (!accept(c, "if")) { unexpected(c, "'if'"); return; }
+  c.depth = 0;
+  parseExpr(c, false);
+  if (c.failed) return;
+  emitOp(c, OP_END);
+
+  if (!accept(c, "then")) { unexpected(c, "'then'"); return; }
+  if (!parseAction(c, r.onTrue)) return;
+  if (accept(c, "else") && !parseAction(c, r.onFalse)) return;
+
+  while (c.tok.kind != T_END && !c.failed) {
+    if (accept(c, "hyst")) {
+      if (c.tok.kind != T_NUM || c.tok.num < 0.0f) { unexpected(c, "hyst >= 0"); return; }
+      r.hyst = c.tok.num;
+      next(c);
+    } else if (accept(c, "dwell")) {
+      if (c.tok.kind != T_NUM || c.tok.num < 0.0f || c.tok.num > 65535.0f) {
+        unexpected(c, "dwell 0..65535 s");
+        return;
+      }
+      r.dwellS = (uint16_t)lroundf(c.tok.num);
+      next(c);
+    } else {
+      unexpected(c, "hyst/dwell or end of line");
+      return;
+    }
+  }
+  if (c.failed) return;
+
+  c.drives |= 1u << r.onTrue.target;
+  if (r.onFalse.target != NO_TARGET) c.drives |= 1u << r.onFalse.target;
+  pr.rules[pr.ruleCount++] = r;
+}
+
+bool compile(const char* src, size_t len, Program& out, Rules::CompileResult& res) {
+  out.ruleCount = 0;
+  out.codeLen   = 0;
+  out.drives    = 0;
+
+  Compiler c{};
+  c.prog  = &out;
+  c.error = res.error;
+
+  const char* p   = src;
+  const char* end = src + len;
+  uint16_t    line = 0;
+
+  while (p < end && !c.failed) {
+    line++;
+    const char* eol = (const char*)memchr(p, '\n', end - p);
+    if (!eol) eol = end;
+    const char* hash = (const char*)memchr(p, '#', eol - p);
+
+    c.p   = p;
+    c.end = hash ? hash : eol;
+    next(c);
+    if (c.tok.kind != T_END) parseRule(c);
+
+    p = eol + 1;
+  }
+
+  if (c.failed) {
+    out.ruleCount = 0;
+    out.codeLen   = 0;
+    res.ok        = false;
+    res.line      = line;
+    return false;
+  }
+
+  out.drives    = c.drives;
+  res.ok        = true;
+  res.line      = 0;
+  res.rules     = out.ruleCount;
+  res.codeBytes = out.codeLen + out.ruleCount * sizeof(Rule);
+  return true;
+}
+
+// ---------- программа и состояние правил ----------
+
+// Два буфера: automationTask выполняет g_prog[g_active], веб компилирует
+// в другой и поднимает g_swapReady; подмена — в начале evaluate().
+Program              g_prog[2];
+std::atomic<uint8_t> g_active{0};
+std::atomic<bool>    g_swapReady{false};
+
+constexpr uint8_t RULE_UNKNOWN = 0xFF;   // правило ещё не вычислялось
+
+// Состояние правил действующей программы (только automationTask)
+uint8_t  g_ruleOn[MAX_RULES];
+uint32_t g_ruleChangedMs[MAX_RULES];
+uint16_t g_activeRules = 0;
+uint32_t g_evals       = 0;
+uint32_t g_switches    = 0;
+
+void takePending() {
+  if (!g_swapReady.load(std::memory_order_acquire)) return;
+  g_active.store(g_active.load(std::memory_order_relaxed) ^ 1, std::memory_order_release);
+  memset(g_ruleOn, RULE_UNKNOWN, sizeof(g_ruleOn));
+  g_activeRules = 0;
+  g_swapReady.store(false, std::memory_order_release);
+}
+
+void applyAction(Actuator a, uint8_t value, const TickContext& ctx) {
+  if (Automation::isOutputHeld(a, ctx)) return;
+  switch (a) {
+    case Actuator::Light: DeviceManager::setLight(value != 0);  break;
+    case Actuator::Pump:  PumpGovernor::request(value != 0, ctx.nowMs); break;
+    case Actuator::Fan:   DeviceManager::setFan(value != 0);    break;
+    case Actuator::Door:  DeviceManager::setDoorAngle(value);   break;
+    default: break;
+  }
+}
+
+} // namespace
+
+void Rules::begin() {
+  memset(g_ruleOn, RULE_UNKNOWN, sizeof(g_ruleOn));
+
+  String src;
+  if (!Storage::loadRules(src)) {
+    Serial.println("[Rules] No rules in flash");
+    return;
+  }
+
+  CompileResult res;
+  if (!install(src.c_str(), src.length(), false, res)) {
+    Serial.printf("[Rules] Line %u: %s — rules disabled\n", res.line, res.error);
+    return;
+  }
+  // задача автоматики ещё не запущена — подменяем сразу
+  takePending();
+}
+
+void Rules::evaluate(const TickContext& ctx) {
+  takePending();
+
+  const Program& pr = g_prog[g_active.load(std::memory_order_acquire)];
+  if (pr.ruleCount == 0 || !g_settings.automationEnabled) return;
+
+  float vars[V_COUNT];
+  loadVars(ctx, vars);
+
+  // итоговое действие по каждому устройству: последнее правило побеждает
+  constexpr uint8_t N = (uint8_t)Actuator::Count;
+  uint8_t want[N];
+  memset(want, NO_TARGET, sizeof(want));
+
+  uint16_t active = 0;
+  for (uint16_t i = 0; i < pr.ruleCount; ++i) {
+    const Rule& r  = pr.rules[i];
+    uint8_t     on = g_ruleOn[i];
+    bool cond = run(pr.code + r.codeOff, vars, on == 1 ? r.hyst : 0.0f);
+
+    if (on == RULE_UNKNOWN) {
+      on = cond;
+      g_ruleChangedMs[i] = ctx.nowMs;
+    } else if (cond != (on != 0) &&
+               ctx.nowMs - g_ruleChangedMs[i] >= r.dwellS * 1000UL) {
+      on = cond;
+      g_ruleChangedMs[i] = ctx.nowMs;
+      g_switches++;
+    }
+    g_ruleOn[i] = on;
+    active += on;
+
+    const Action& a = on ? r.onTrue : r.onFalse;
+    if (a.target != NO_TARGET) want[a.target] = a.value;
+  }
+
+  for (uint8_t a = 0; a < N; ++a) {
+    if (want[a] != NO_TARGET) applyAction((Actuator)a, want[a], ctx);
+  }
+
+  g_activeRules = active;
+  g_evals++;
+}
+
+bool Rules::drives(Actuator a) {
+  return (g_prog[g_active.load(std::memory_order_acquire)].drives >> (uint8_t)a) & 1;
+}
+
+bool Rules::install(const char* src, size_t len, bool save, CompileResult& out) {
+  memset(&out, 0, sizeof(out));
+
+  if (len > SOURCE_MAX) {
+    snprintf(out.error, sizeof(out.error), "source too large (max %u bytes)", (unsigned)SOURCE_MAX);
+    return false;
+  }
+  if (g_swapReady.load(std::memory_order_acquire)) {
+    snprintf(out.error, sizeof(out.error), "busy, previous rules not applied yet");
+    return false;
+  }
+
+  Program& spare = g_prog[g_active.load(std::memory_order_acquire) ^ 1];
+  if (!compile(src, len, spare, out)) return false;
+
+  if (save && !Storage::saveRules(src, len)) {
+    out.ok = false;
+    snprintf(out.error, sizeof(out.error), "flash write failed");
+    return false;
+  }
+
+  g_swapReady.store(true, std::memory_order_release);
+  Serial.printf("[Rules] %u rules, %u bytes of bytecode\n", out.rules, out.codeBytes);
+  return true;
+}
+
+Rules::Status Rules::status() {
+  const Program& pr = g_prog[g_active.load(std::memory_order_acquire)];
+  Status s;
+  s.rules       = pr.ruleCount;
+  s.codeBytes   = pr.codeLen + pr.ruleCount * sizeof(Rule);
+  s.activeRules = g_activeRules;
+  s.evals       = g_evals;
+  s.switches    = g_switches;
+  s.pending     = g_swapReady.load(std::memory_order_acquire);
+  return s;
+}
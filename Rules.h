@@ -0,0 +1,69 @@
+// === FILE: Rules.h ===
+#pragma once
+#include <Arduino.h>
+#include "TickContext.h"
+#include "Types.h"
+
+// Пользовательские правила поверх встроенной автоматики.
+// Текст компилируется на устройстве в компактный байткод, который
+// этап планировщика выполняет каждый тик.
+//
+//   # комментарий до конца строки, одно правило на строку
+//   if airTemp > 30 and hour >= 8 then fan on else fan off hyst 1 dwell 60
+//   if not day or lux > 20000 then light off else light on dwell 300
+//   if (airHum > 85 or airTemp > 32) and not pump then door 60 else door 0
+//
+// Условие: сравнения (< <= > >= == !=) переменных с числами или друг
+// с другом, and / or / not, скобки; and связывает сильнее or.
+// Логические переменные (day, night, light, pump, fan, door) можно
+// писать без сравнения. Переменные: airTemp airHum pressure soil
+// soilTemp lux hour sunAlt day night light pump fan door.
+// Датчик без отсчёта (NaN) делает любое сравнение с ним ложным; hour и
+// sunAlt ведут себя так же, пока настенное время не выставлено.
+//
+// Действия: light|pump|fan on|off, door 0..100 (door open = 100,
+// door close = 0). then выполняется, пока условие истинно, else — пока
+// ложно. Несколько правил на одно устройство — побеждает последнее.
+//
+// hyst X — пока правило сработало, пороги сравнений ослаблены на X
+// (выключится на X ниже/выше порога включения). dwell S — не менять
+// состояние правила чаще, чем раз в S секунд.
+//
+// Устройство, которым управляет хоть одно правило, встроенная логика
+// Automation не трогает (drives()); ручное удержание и блокировка
+// насоса по safety действуют и на правила.
+namespace Rules {
+
+  // Загрузить исходник из flash и скомпилировать (при старте)
+  void begin();
+
+  // Этап планировщика: подхватить новую программу и выполнить правила
+  void evaluate(const TickContext& ctx);
+
+  // Управляет ли действующая программа устройством
+  bool drives(Actuator a);
+
+  struct CompileResult {
+    bool     ok;
+    uint16_t line;        // строка с ошибкой (с 1), 0 — ошибка не в строке
+    uint16_t rules;
+    uint16_t codeBytes;   // байткод + заголовки правил
+    char     error[64];
+  };
+
+  // Скомпилировать текст в запасной буфер; при успехе сохранить во flash
+  // (save) и передать automationTask на подмену в начале следующего тика.
+  // Вызывается из одной задачи (веб); пока прошлая подмена не
+  // подхвачена, возвращает ошибку "busy".
+  bool install(const char* src, size_t len, bool save, CompileResult& out);
+
+  struct Status {
+    uint16_t rules;
+    uint16_t codeBytes;
+    uint16_t activeRules;   // сколько правил сейчас в состоянии "истинно"
+    uint32_t evals;         // выполнений программы
+    uint32_t switches;      // смен состояния правил
+    bool     pending;       // новая программа ждёт подмены
+  };
+  Status status();
+}
@@ -0,0 +1,50 @@
+// === FILE: SensorBus.cpp ===
+#include "SensorBus.h"
+#include "Globals.h"
+
+#include <atomic>
+#include <string.h>
+
+namespace {
+
+  // Нечётное значение — идёт запись
+  std::atomic<uint32_t> g_seq{0};
+  std::atomic<uint32_t> g_retries{0};
+
+  // Писатели сериализуются между собой; секция — несколько присваиваний,
+  // читатели этот спинлок не берут
+  portMUX_TYPE g_writeMux = portMUX_INITIALIZER_UNLOCKED;
+
+} // namespace
+
+void SensorBus::writeBegin() {
+  portENTER_CRITICAL(&g_writeMux);
+  g_seq.store(g_seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void SensorBus::writeEnd() {
+  g_seq.store(g_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  portEXIT_CRITICAL(&g_writeMux);
+}
+
+SensorData SensorBus::snapshot() {
+  SensorData out;
+  for (;;) {
+    uint32_t s1 = g_seq.load(std::memory_order_acquire);
+    if ((s1 & 1) == 0) {
+      memcpy(&out, (const void*)&g_sensors, sizeof(out));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (g_seq.load(std::memory_order_relaxed) == s1) return out;
+    }
+    g_retries.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+uint32_t SensorBus::version() {
+  return g_seq.load(std::memory_order_acquire) >> 1;
+}
+
+uint32_t SensorBus::readRetries() {
+  return g_retries.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,22 @@
+// === FILE: SensorBus.h ===
+#pragma once
+#include "Types.h"
+
+// Seqlock вокруг g_sensors: писатели (sensorTask, DeviceManager::set*)
+// оборачивают изменения в writeBegin()/writeEnd(), читатели из других
+// задач и ядер берут snapshot() — согласованную копию без мьютекса.
+// Читатель не задерживает писателя: при пересечении с записью он просто
+// повторяет копирование.
+namespace SensorBus {
+  // Секция записи. Коротко: только присваивания полей, без I/O и логов.
+  void writeBegin();
+  void writeEnd();
+
+  SensorData snapshot();
+
+  // Число завершённых записей (чётная половина счётчика seqlock)
+  uint32_t version();
+
+  // Сколько раз snapshot() повторял копирование из-за параллельной записи
+  uint32_t readRetries();
+}
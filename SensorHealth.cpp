@@ -0,0 +1,237 @@
+// === FILE: SensorHealth.cpp ===
+#include "SensorHealth.h"
+#include "Config.h"
+#include <math.h>
+
+namespace {
+
+  using namespace SensorHealthConfig;
+  using SensorHealth::CHANNELS;
+  using SensorHealth::Channel;
+
+  static_assert(sizeof(LIMITS) / sizeof(LIMITS[0]) == CHANNELS,
+                "SensorHealthConfig::LIMITS must list every channel");
+
+  struct ChannelState {
+    // последний принятый отсчёт — опора для проверки скорости
+    float    last;
+    uint32_t lastMs;
+    bool     have;
+
+    // кандидат в новый уровень после скачка
+    float    pending;
+    uint32_t pendingMs;
+    uint8_t  pendingCount;
+
+    // залипание: с какого момента держится flatValue
+    float    flatValue;
+    uint32_t flatSinceMs;
+    bool     flatArmed;
+
+    uint8_t  faults;
+    uint32_t badSinceMs;
+    uint32_t rejected;
+    uint32_t events;
+  };
+
+  ChannelState g_ch[CHANNELS];
+
+  // Почва грядок 1.. (checkZone): те же пороги, что у SoilMoisture.
+  // Элемент 0 не используется — датчик зоны 0 идёт каналом кадра.
+  constexpr uint8_t MAX_ZONES = ZoneConfig::MAX_ZONES;
+  ChannelState g_zone[MAX_ZONES];
+
+  // check()/checkZone() — в sensorTask, status() — из других задач
+  portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+  inline uint8_t idx(Channel c) { return (uint8_t)c; }
+
+  // Скачок: не дальше maxRate от опоры. Иначе ждём, пока новые отсчёты
+  // подтвердят уровень, — тогда это настоящая смена, а не выброс.
+  bool spike(ChannelState& s, const Limits& lim, float x, uint32_t nowMs) {
+    if (!s.have || lim.maxRate <= 0.0f) return false;
+
+    float dt = (nowMs - s.lastMs) / 1000.0f;
+    if (fabsf(x - s.last) <= lim.maxRate * dt) return false;
+
+    float dtp = (nowMs - s.pendingMs) / 1000.0f;
+    if (s.pendingCount > 0 && fabsf(x - s.pending) <= lim.maxRate * dtp) {
+      s.pendingCount++;
+    } else {
+      s.pendingCount = 1;
+    }
+    s.pending   = x;
+    s.pendingMs = nowMs;
+    return s.pendingCount < CONFIRM_SAMPLES;
+  }
+
+  // Залипание: ровно то же значение дольше flatMs. Значение на краю
+  // диапазона — не залипание: 0 лк ночью, 100 % RH в тумане, почва суше
+  // калибровки (acquireSensors обрезает до 0 %) держатся часами честно.
+  bool stuck(ChannelState& s, const Limits& lim, float x, uint32_t nowMs) {
+    if (lim.flatMs == 0 || x <= lim.min || x >= lim.max) {
+      s.flatArmed = false;
+      return false;
+    }
+    if (!s.flatArmed || x != s.flatValue) {
+      s.flatValue   = x;
+      s.flatSinceMs = nowMs;
+      s.flatArmed   = true;
+      return false;
+    }
+    return nowMs - s.flatSinceMs >= lim.flatMs;
+  }
+
+  // Диапазон, скачок, залипание одного отсчёта; биты Fault.
+  // NAN — датчика нет, это не ошибка отсчёта (bmeOk/bhOk/soilOk).
+  uint8_t sampleFaults(ChannelState& s, const Limits& lim, float x, uint32_t nowMs) {
+    if (isnan(x)) {
+      s.flatArmed    = false;
+      s.pendingCount = 0;
+      return 0;
+    }
+
+    uint8_t f = 0;
+    if (x < lim.min || x > lim.max) {
+      f |= SensorHealth::FAULT_RANGE;
+    } else if (spike(s, lim, x, nowMs)) {
+      f |= SensorHealth::FAULT_SPIKE;
+    }
+    if (stuck(s, lim, x, nowMs)) {
+      f |= SensorHealth::FAULT_STUCK;
+    }
+    return f;
+  }
+
+  enum class Change : uint8_t { None, Raised, Cleared };
+
+  // Итог отсчёта: счётчики и опора для проверки скорости
+  Change settle(ChannelState& s, uint8_t faults, float x, uint32_t nowMs) {
+    Change ch = Change::None;
+    if (faults) {
+      s.rejected++;
+      if (!s.faults) {
+        s.badSinceMs = nowMs;
+        s.events++;
+        ch = Change::Raised;
+      }
+    } else {
+      if (s.faults) ch = Change::Cleared;
+      if (!isnan(x)) {
+        s.last         = x;
+        s.lastMs       = nowMs;
+        s.have         = true;
+        s.pendingCount = 0;
+      }
+    }
+    s.faults = faults;
+    return ch;
+  }
+
+  SensorHealth::Status statusOf(const ChannelState& s, uint32_t nowMs) {
+    SensorHealth::Status out;
+    out.faults   = s.faults;
+    out.badForMs = s.faults ? nowMs - s.badSinceMs : 0;
+    out.rejected = s.rejected;
+    out.events   = s.events;
+    return out;
+  }
+
+} // namespace
+
+void SensorHealth::begin() {
+  portENTER_CRITICAL(&g_mux);
+  for (uint8_t c = 0; c < CHANNELS; ++c) g_ch[c] = ChannelState{};
+  for (uint8_t z = 0; z < MAX_ZONES; ++z) g_zone[z] = ChannelState{};
+  portEXIT_CRITICAL(&g_mux);
+}
+
+uint8_t SensorHealth::check(float (&v)[CHANNELS], uint32_t nowMs) {
+  uint8_t faults[CHANNELS] = {};
+
+  portENTER_CRITICAL(&g_mux);
+  for (uint8_t c = 0; c < CHANNELS; ++c) {
+    faults[c] = sampleFaults(g_ch[c], LIMITS[c], v[c], nowMs);
+  }
+
+  // почва под плёнкой не уходит от воздуха на десятки градусов
+  const uint8_t at = idx(Channel::AirTemp);
+  const uint8_t st = idx(Channel::SoilTemp);
+  if (!faults[at] && !faults[st] && !isnan(v[at]) && !isnan(v[st]) &&
+      fabsf(v[st] - v[at]) > SOIL_AIR_MAX_DIFF) {
+    faults[st] |= FAULT_MISMATCH;
+  }
+
+  uint8_t mask    = 0;
+  uint8_t raised  = 0;
+  uint8_t cleared = 0;
+  for (uint8_t c = 0; c < CHANNELS; ++c) {
+    Change chg = settle(g_ch[c], faults[c], v[c], nowMs);
+    if (chg == Change::Raised)  raised  |= 1 << c;
+    if (chg == Change::Cleared) cleared |= 1 << c;
+    if (faults[c]) {
+      mask |= 1 << c;
+      v[c] = NAN;
+    }
+  }
+  portEXIT_CRITICAL(&g_mux);
+
+  // лог — вне критической секции
+  for (uint8_t c = 0; c < CHANNELS; ++c) {
+    if (raised & (1 << c)) {
+      Serial.printf("[SensorHealth] %s: %s\n",
+                    SensorStats::channelName((Channel)c), faultName(faults[c]));
+    } else if (cleared & (1 << c)) {
+      Serial.printf("[SensorHealth] %s: ok\n", SensorStats::channelName((Channel)c));
+    }
+  }
+  return mask;
+}
+
+float SensorHealth::checkZone(uint8_t zone, float x, uint32_t nowMs) {
+  if (zone == 0 || zone >= MAX_ZONES) return x;
+  const Limits& lim = LIMITS[idx(Channel::SoilMoisture)];
+
+  portENTER_CRITICAL(&g_mux);
+  ChannelState& s = g_zone[zone];
+  uint8_t f   = sampleFaults(s, lim, x, nowMs);
+  Change  chg = settle(s, f, x, nowMs);
+  portEXIT_CRITICAL(&g_mux);
+
+  if (chg == Change::Raised) {
+    Serial.printf("[SensorHealth] zone %u soil: %s\n", zone, faultName(f));
+  } else if (chg == Change::Cleared) {
+    Serial.printf("[SensorHealth] zone %u soil: ok\n", zone);
+  }
+  return f ? NAN : x;
+}
+
+SensorHealth::Status SensorHealth::status(Channel ch, uint32_t nowMs) {
+  Status out{};
+  const uint8_t c = idx(ch);
+  if (c >= CHANNELS) return out;
+
+  portENTER_CRITICAL(&g_mux);
+  out = statusOf(g_ch[c], nowMs);
+  portEXIT_CRITICAL(&g_mux);
+  return out;
+}
+
+SensorHealth::Status SensorHealth::zoneStatus(uint8_t zone, uint32_t nowMs) {
+  if (zone == 0) return status(Channel::SoilMoisture, nowMs);
+  Status out{};
+  if (zone >= MAX_ZONES) return out;
+
+  portENTER_CRITICAL(&g_mux);
+  out = statusOf(g_zone[zone], nowMs);
+  portEXIT_CRITICAL(&g_mux);
+  return out;
+}
+
+const char* SensorHealth::faultName(uint8_t faults) {
+  if (faults & FAULT_RANGE)    return "range";
+  if (faults & FAULT_STUCK)    return "stuck";
+  if (faults & FAULT_MISMATCH) return "mismatch";
+  if (faults & FAULT_SPIKE)    return "spike";
+  return "ok";
+}
@@ -0,0 +1,51 @@
+// === FILE: SensorHealth.h ===
+#pragma once
+#include <Arduino.h>
+#include "SensorStats.h"
+
+// Потоковая проверка отсчётов датчиков: диапазон, скорость изменения,
+// залипание (одно и то же значение дольше flatMs, кроме значений на
+// краях диапазона) и согласованность почвы с воздухом. Постоянное время
+// и память на отсчёт.
+//
+// check() зовёт DeviceManager::acquireSensors (sensorTask) до публикации
+// кадра: недостоверные отсчёты заменяются на NAN, так что автоматика их
+// не увидит. Датчики почвы грядок 1.. проходят те же проверки через
+// checkZone() со своим состоянием на зону. Состояние каналов читают
+// Diagnostics, Web и Telegram.
+// Каналы — SensorStats::Channel, пороги — SensorHealthConfig.
+namespace SensorHealth {
+
+  using Channel = SensorStats::Channel;
+  constexpr uint8_t CHANNELS = SensorStats::CHANNELS;
+
+  // Причины недостоверности отсчёта (биты)
+  enum Fault : uint8_t {
+    FAULT_RANGE    = 1 << 0,   // вне физического диапазона
+    FAULT_SPIKE    = 1 << 1,   // скачок быстрее maxRate, ещё не подтверждён
+    FAULT_STUCK    = 1 << 2,   // значение не меняется дольше flatMs
+    FAULT_MISMATCH = 1 << 3    // не согласуется с другим датчиком
+  };
+
+  void begin();
+
+  // v — отсчёты кадра в порядке Channel (NAN — датчика нет).
+  // Недостоверные заменяются на NAN; возвращает маску каналов с ошибкой.
+  uint8_t check(float (&v)[CHANNELS], uint32_t nowMs);
+
+  struct Status {
+    uint8_t  faults;     // биты Fault последнего отсчёта, 0 — в норме
+    uint32_t badForMs;   // сколько канал подряд недостоверен
+    uint32_t rejected;   // отброшенных отсчётов с начала работы
+    uint32_t events;     // переходов в неисправность
+  };
+  Status status(Channel ch, uint32_t nowMs);
+
+  // Почва грядки zone (1..ZoneConfig::MAX_ZONES-1), пороги SoilMoisture.
+  // Возвращает x или NAN, если отсчёт недостоверен; зона 0 — канал кадра.
+  float  checkZone(uint8_t zone, float x, uint32_t nowMs);
+  Status zoneStatus(uint8_t zone, uint32_t nowMs);
+
+  // Самая важная причина из маски: "range", "stuck", "mismatch", "spike"; "ok"
+  const char* faultName(uint8_t faults);
+}
@@ -0,0 +1,210 @@
+// === FILE: SensorStats.cpp ===
+#include "SensorStats.h"
+#include "Config.h"
+#include <math.h>
+
+namespace {
+
+  using namespace SensorStatsConfig;
+  using SensorStats::CHANNELS;
+
+  static_assert(SensorStats::WINDOWS == SensorStatsConfig::WINDOWS,
+                "SensorStats::Window must match SensorStatsConfig");
+
+  // Корзина: Welford (n, mean, m2) плюс экстремумы
+  struct Cell {
+    uint32_t n;
+    float    mean;
+    float    m2;
+    float    min;
+    float    max;
+  };
+
+  // Кольца всех окон лежат подряд: окно w — с ringOffset(w)
+  constexpr uint16_t ringOffset(uint8_t w) {
+    return w == 0 ? 0 : (uint16_t)(ringOffset(w - 1) + buckets(w - 1));
+  }
+  constexpr uint16_t CELLS = ringOffset(WINDOWS);
+
+  struct Ring {
+    uint16_t head;            // текущая корзина
+    uint32_t bucketStartMs;
+  };
+
+  Cell     g_cells[CHANNELS][CELLS];
+  Ring     g_rings[WINDOWS];
+
+  float    g_ewma[CHANNELS][WINDOWS];
+  uint32_t g_lastMs[CHANNELS];          // прошлый отсчёт канала, для EWMA
+  bool     g_seen[CHANNELS];
+
+  uint32_t g_lastFrame = 0;
+  bool     g_started   = false;
+
+  // Запись — в automationTask, чтение — из задач Web/Telegram
+  portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+  inline void clearCell(Cell& c) {
+    c.n    = 0;
+    c.mean = 0.0f;
+    c.m2   = 0.0f;
+    c.min  = INFINITY;
+    c.max  = -INFINITY;
+  }
+
+  void clearBucket(uint8_t w, uint16_t i) {
+    const uint16_t at = ringOffset(w) + i;
+    for (uint8_t ch = 0; ch < CHANNELS; ++ch) clearCell(g_cells[ch][at]);
+  }
+
+  // Довести кольцо окна до nowMs: устаревшие корзины обнуляются.
+  // Простой дольше кольца — всё кольцо сразу.
+  void advance(uint8_t w, uint32_t nowMs) {
+    Ring& r = g_rings[w];
+    const uint16_t n = buckets(w);
+    const uint32_t b = BUCKET_MS[w];
+
+    uint32_t gap = nowMs - r.bucketStartMs;
+    if (gap < b) return;
+    if (gap >= (uint32_t)n * b) {
+      for (uint16_t i = 0; i < n; ++i) clearBucket(w, i);
+      r.bucketStartMs += (gap / b) * b;
+      return;
+    }
+    while (nowMs - r.bucketStartMs >= b) {
+      r.head = (uint16_t)((r.head + 1) % n);
+      clearBucket(w, r.head);
+      r.bucketStartMs += b;
+    }
+  }
+
+  inline void addTo(Cell& c, float x) {
+    c.n++;
+    const float d = x - c.mean;
+    c.mean += d / (float)c.n;
+    c.m2   += d * (x - c.mean);
+    if (x < c.min) c.min = x;
+    if (x > c.max) c.max = x;
+  }
+
+  // Слияние корзин (Chan et al.): та же сумма, что по отсчётам подряд
+  inline void merge(Cell& a, const Cell& b) {
+    if (b.n == 0) return;
+    if (a.n == 0) {
+      a = b;
+      return;
+    }
+    const uint32_t n = a.n + b.n;
+    const float    d = b.mean - a.mean;
+    const float    k = (float)b.n / (float)n;
+    a.mean += d * k;
+    a.m2   += b.m2 + d * d * (float)a.n * k;
+    a.n     = n;
+    if (b.min < a.min) a.min = b.min;
+    if (b.max > a.max) a.max = b.max;
+  }
+
+  void add(uint8_t ch, float x, uint32_t nowMs) {
+    if (isnan(x)) return;
+
+    for (uint8_t w = 0; w < WINDOWS; ++w) {
+      addTo(g_cells[ch][ringOffset(w) + g_rings[w].head], x);
+    }
+
+    // EWMA по реальному шагу между отсчётами канала
+    if (!g_seen[ch]) {
+      for (uint8_t w = 0; w < WINDOWS; ++w) g_ewma[ch][w] = x;
+      g_seen[ch] = true;
+    } else {
+      const float dtMs = (float)(nowMs - g_lastMs[ch]);
+      for (uint8_t w = 0; w < WINDOWS; ++w) {
+        const float a = 1.0f - expf(-dtMs / (float)WINDOW_MS[w]);
+        g_ewma[ch][w] += (x - g_ewma[ch][w]) * a;
+      }
+    }
+    g_lastMs[ch] = nowMs;
+  }
+
+} // namespace
+
+void SensorStats::begin() {
+  portENTER_CRITICAL(&g_mux);
+  for (uint8_t ch = 0; ch < CHANNELS; ++ch) {
+    for (uint16_t i = 0; i < CELLS; ++i) clearCell(g_cells[ch][i]);
+    for (uint8_t w = 0; w < WINDOWS; ++w) g_ewma[ch][w] = NAN;
+    g_lastMs[ch] = 0;
+    g_seen[ch]   = false;
+  }
+  for (uint8_t w = 0; w < WINDOWS; ++w) g_rings[w] = Ring{};
+  g_lastFrame = 0;
+  g_started   = false;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void SensorStats::sample(const TickContext& ctx) {
+  const SensorData& s = ctx.sensors;
+  if (s.frameSeq == 0 || s.frameSeq == g_lastFrame) return;
+  g_lastFrame = s.frameSeq;
+
+  const uint32_t now = s.sampleMs;
+
+  portENTER_CRITICAL(&g_mux);
+  if (!g_started) {
+    for (uint8_t w = 0; w < WINDOWS; ++w) g_rings[w].bucketStartMs = now;
+    g_started = true;
+  }
+  for (uint8_t w = 0; w < WINDOWS; ++w) advance(w, now);
+
+  add((uint8_t)Channel::AirTemp,      s.airTemp,      now);
+  add((uint8_t)Channel::AirHum,       s.airHum,       now);
+  add((uint8_t)Channel::AirPressure,  s.airPressure,  now);
+  add((uint8_t)Channel::SoilMoisture, s.soilMoisture, now);
+  add((uint8_t)Channel::SoilTemp,     s.soilTemp,     now);
+  add((uint8_t)Channel::Lux,          s.lux,          now);
+  portEXIT_CRITICAL(&g_mux);
+}
+
+bool SensorStats::get(Channel ch, Window w, Summary& out) {
+  const uint8_t c  = (uint8_t)ch;
+  const uint8_t wi = (uint8_t)w;
+  if (c >= CHANNELS || wi >= WINDOWS) return false;
+
+  Cell acc;
+  clearCell(acc);
+
+  portENTER_CRITICAL(&g_mux);
+  const Cell* ring = &g_cells[c][ringOffset(wi)];
+  for (uint16_t i = 0; i < buckets(wi); ++i) merge(acc, ring[i]);
+  out.ewma = g_ewma[c][wi];
+  portEXIT_CRITICAL(&g_mux);
+
+  out.n = acc.n;
+  if (acc.n == 0) return false;
+
+  out.mean   = acc.mean;
+  out.stddev = acc.n > 1 ? sqrtf(acc.m2 / (float)(acc.n - 1)) : 0.0f;
+  out.min    = acc.min;
+  out.max    = acc.max;
+  return true;
+}
+
+const char* SensorStats::channelName(Channel ch) {
+  switch (ch) {
+    case Channel::AirTemp:      return "airTemp";
+    case Channel::AirHum:       return "airHum";
+    case Channel::AirPressure:  return "airPressure";
+    case Channel::SoilMoisture: return "soilMoisture";
+    case Channel::SoilTemp:     return "soilTemp";
+    case Channel::Lux:          return "lux";
+    default:                    return "?";
+  }
+}
+
+const char* SensorStats::windowName(Window w) {
+  switch (w) {
+    case Window::Hour: return "1h";
+    case Window::Day:  return "24h";
+    case Window::Week: return "7d";
+    default:           return "?";
+  }
+}
@@ -0,0 +1,58 @@
+// === FILE: SensorStats.h ===
+#pragma once
+#include <Arduino.h>
+#include "TickContext.h"
+
+// Потоковая статистика каналов датчиков за 1 ч, 24 ч и 7 суток:
+// среднее и разброс (Welford), min/max и EWMA с постоянной, равной окну.
+// Отсчёт раскладывается в текущую корзину каждого окна за O(1), корзины
+// окна сливаются только при запросе. Память — статические массивы.
+//
+// Окно — от WINDOW_MS до WINDOW_MS + BUCKET_MS (SensorStatsConfig).
+// Считается по Clock::millis(): после перезагрузки статистика пустая.
+//
+// sample() — этап планировщика (automationTask), get() можно звать
+// из любой задачи (Web, Telegram).
+namespace SensorStats {
+
+  enum class Channel : uint8_t {
+    AirTemp = 0,
+    AirHum,
+    AirPressure,
+    SoilMoisture,
+    SoilTemp,
+    Lux,
+    Count
+  };
+
+  enum class Window : uint8_t {
+    Hour = 0,
+    Day,
+    Week,
+    Count
+  };
+
+  constexpr uint8_t CHANNELS = (uint8_t)Channel::Count;
+  constexpr uint8_t WINDOWS  = (uint8_t)Window::Count;
+
+  struct Summary {
+    uint32_t n;        // отсчётов в окне
+    float    mean;
+    float    stddev;   // выборочное, 0 при n < 2
+    float    min;
+    float    max;
+    float    ewma;     // экспоненциальное среднее, τ = длина окна
+  };
+
+  void begin();
+
+  // Этап планировщика: новый кадр датчиков (ctx.sensors.frameSeq) —
+  // по отсчёту в каждый канал; NAN пропускается
+  void sample(const TickContext& ctx);
+
+  // false — в окне нет ни одного отсчёта канала
+  bool get(Channel ch, Window w, Summary& out);
+
+  const char* channelName(Channel ch);   // как в /api/sensors: "airTemp", …
+  const char* windowName(Window w);      // "1h", "24h", "7d"
+}
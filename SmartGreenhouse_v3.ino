@@ -8,6 +8,8 @@
 #include "TimeManager.h"
 #include "DeviceManager.h"
 #include "Automation.h"
+#include "SensorStats.h"
+#include "Rules.h"
 #include "StateMachine.h"
 #include "WebUiAsync.h"
 #include "TelemetryLogger.h"
@@ -16,12 +18,18 @@
 #include "TelegramAsync.h"
 #include "Diagnostics.h"
 #include "SunPosition.h"
+#include "Clock.h"
+#include "CommandQueue.h"
+#include "TaskMonitor.h"
+#include "CropProfiles.h"
 
 void setup() {
   Serial.begin(115200);
   delay(2000);
   Serial.println("\n[YotikM2 v3] Booting...");
 
+  Clock::bind(Clock::systemSource());
+
   if (!SPIFFS.begin(true)) {
     Serial.println("[FS] Failed to mount SPIFFS");
   }
@@ -29,16 +37,21 @@ void setup() {
   Storage::begin();
   Storage::loadSettings(g_settings);
   DeviceManager::begin();
+  CommandQueue::begin();
   TimeManager::begin();
   TimeManager::syncTimeAsync();
   TimeManager::loadTimeFromRTCIfNeeded();
   TelemetryLogger::begin();
   Automation::begin();
+  SensorStats::begin();
+  Rules::begin();
   Diagnostics::begin();
+  TaskMonitor::begin();
   SunPosition::begin();
   WebUiAsync::begin();
   OtaHandler::begin();
   TelegramAsync::begin();
+  DeviceManager::startSensorTask();
   StateMachine::startTask();
 
   Serial.println("[YotikM2 v3] Setup done");
@@ -48,5 +61,6 @@ void loop() {
   OtaHandler::loop();
   TelegramAsync::loop();
   WebUiAsync::loop();
+  CropProfiles::loop();
   delay(5);
 }
\ No newline at end of file
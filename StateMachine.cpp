@@ -4,34 +4,365 @@
 #include "DeviceManager.h"
 #include "TelemetryLogger.h"
 #include "Diagnostics.h"
+#include "CommandQueue.h"
+#include "TaskMonitor.h"
+#include "TickContext.h"
+#include "SunPosition.h"
+#include "Rules.h"
+#include "PumpDuty.h"
+#include "PumpGovernor.h"
+#include "SensorStats.h"
+#include "Perf.h"
+#include "Clock.h"
 #include "Config.h"
 #include <Arduino.h>
 
+// Rate-monotonic планировщик: у каждого этапа свой период, фаза и дедлайн.
+// Моменты запуска считаются от фиксированной сетки (release += period),
+// поэтому время выполнения не накапливается в дрейф периода.
+//
+// Между запусками задача спит в ulTaskNotifyTake до ближайшего release;
+// notify() будит её раньше, и этапы из маски события выполняются сразу.
+//
+// Перегрузка: если тик вышел за TICK_BUDGET_US, следующие
+// OVERLOAD_HOLD_TICKS тиков (и остаток текущего) этапы класса Deferrable
+// откладываются. Critical и Control выполняются всегда. Отложенный этап
+// повторяется на следующем тике сетки, а не сразу: иначе его release в
+// прошлом не даёт задаче уснуть. Удержание перегрузки и shedTicks
+// считаются по тикам сетки, а не по пробуждениям задачи.
+//
+// В начале тика один раз собирается TickContext (время, час, солнце,
+// снимок датчиков) и передаётся всем этапам.
+
 namespace {
-  void automationTask(void* pv) {
+
+  // Класс приоритета этапа при перегрузке
+  enum class Prio : uint8_t {
+    Critical,    // защита насоса/перегрева — всегда
+    Control,     // климат и полив — всегда, после Critical
+    Deferrable   // статистика света, диагностика, телеметрия — можно отложить
+  };
+
+  struct StageSlot {
+    Perf::Stage perf;
+    Prio        prio;
+    void      (*fn)(const TickContext&);
+    uint32_t    periodMs;
+    uint32_t    phaseMs;     // сдвиг первого запуска — разносим тяжёлые этапы по тикам
+    uint32_t    deadlineMs;  // относительно момента release
+
+    uint32_t    events;      // маска StateMachine::Event, запускающая этап вне сетки
+
+    // состояние — заполняет begin()
+    uint32_t    nextReleaseMs  = 0;
+    uint32_t    retryMs        = 0;   // отложенный этап — не раньше этого момента
+    uint32_t    runs           = 0;
+    uint32_t    deadlineMisses = 0;
+    uint32_t    skippedPeriods = 0;
+    uint32_t    deferrals      = 0;
+  };
+
+  using namespace AutomationConfig;
+  using namespace StateMachine;
+
+  // Этапы других модулей контекст не используют
+  void diagnosticsStage(const TickContext&) { Diagnostics::loop(); }
+  void telemetryStage(const TickContext&)   { TelemetryLogger::loop(); }
+  void taskMonitorStage(const TickContext&) { TaskMonitor::sample(); }
+
+  void sunTableStage(const TickContext& ctx) {
+    if (ctx.wallValid) SunPosition::service(ctx.wallUtc);
+  }
+
+  constexpr uint32_t EV_CONTROL = EVENT_MANUAL | EVENT_SENSORS | EVENT_SETTINGS;
+
+  // Порядок = приоритет: короче период — раньше в тике
+  StageSlot g_slots[] = {
+    { Perf::Stage::StepCritical, Prio::Critical,   Automation::stepCritical, SAFETY_PERIOD_MS,      0,   50, EV_CONTROL },
+    { Perf::Stage::PumpGovernor, Prio::Critical,   PumpGovernor::tick,       SAFETY_PERIOD_MS,      0,   50, 0 },
+    { Perf::Stage::StepHigh,     Prio::Control,    Automation::stepHigh,     CLIMATE_PERIOD_MS,     0,  200, EV_CONTROL },
+    { Perf::Stage::StepMedium,   Prio::Control,    Automation::stepMedium,   CLIMATE_PERIOD_MS,   500,  200, EV_CONTROL },
+    { Perf::Stage::StepLow,      Prio::Control,    Automation::stepLow,      LIGHT_PERIOD_MS,     200, 1000, EVENT_MANUAL | EVENT_SETTINGS },
+    // статистика и адаптация порогов света — можно отложить, реле — нет
+    { Perf::Stage::LightStats,   Prio::Deferrable, Automation::updateLightStats, LIGHT_PERIOD_MS, 200, 5000, 0 },
+    // стресс интегрируется по реальному времени — откладывать можно
+    { Perf::Stage::Stress,       Prio::Deferrable, Automation::updateStress, StressConfig::PERIOD_MS, 900, 1000, 0 },
+    // правила — после встроенных этапов, каждый тик
+    { Perf::Stage::Rules,        Prio::Control,    Rules::evaluate,          SCHED_TICK_MS,         0,  100, EV_CONTROL },
+    { Perf::Stage::Diagnostics,  Prio::Deferrable, diagnosticsStage,         DIAG_PERIOD_MS,      300, 5000, 0 },
+    { Perf::Stage::Telemetry,    Prio::Deferrable, telemetryStage,           TELEMETRY_PERIOD_MS, 400, 5000, 0 },
+    { Perf::Stage::TaskMonitor,  Prio::Deferrable, taskMonitorStage,         DIAG_PERIOD_MS,      600, 5000, 0 },
+    { Perf::Stage::SunTable,     Prio::Deferrable, sunTableStage,            SUN_TABLE_PERIOD_MS, 700, 1000, 0 },
+    { Perf::Stage::PumpDuty,     Prio::Deferrable, PumpDuty::service,        PumpDutyConfig::SERVICE_PERIOD_MS, 800, 5000, 0 },
+    { Perf::Stage::SensorStats,  Prio::Deferrable, SensorStats::sample,      SensorStatsConfig::PERIOD_MS, 100, 1000, 0 },
+  };
+
+  constexpr uint8_t SLOT_COUNT = sizeof(g_slots) / sizeof(g_slots[0]);
+
+  // Ожидающие события: notify() дописывает биты, runDue() забирает
+  portMUX_TYPE g_eventMux      = portMUX_INITIALIZER_UNLOCKED;
+  uint32_t     g_pendingEvents = 0;
+  // micros() первого необработанного notify. Не Perf::cycles(): notify
+  // зовут с другого ядра, а счётчики тактов ядер ESP32 не синхронны
+  uint32_t     g_firstEventUs  = 0;
+  TaskHandle_t g_taskHandle    = nullptr;
+
+  EventStats   g_eventStats    = {};
+
+  // Перегрузка тика
+  SchedStats   g_sched         = {};
+  bool         g_overloaded    = false;
+  uint32_t     g_overloadEndMs = 0;   // до какого момента откладывать Deferrable
+  uint32_t     g_shedTickMs    = 0;   // начало тика сетки, уже учтённого в shedTicks
+  bool         g_shedCounted   = false;
+
+  inline uint32_t elapsedUs(uint32_t c0) {
+    return (Perf::cycles() - c0) / Perf::cpuMHz();
+  }
+
+  inline bool reached(uint32_t now, uint32_t t) {
+    return (int32_t)(now - t) >= 0;
+  }
+
+  // Начало тика сетки, в который попадает nowMs
+  inline uint32_t tickStart(uint32_t nowMs) {
+    return nowMs - nowMs % SCHED_TICK_MS;
+  }
+
+  bool overloaded(uint32_t nowMs) {
+    if (g_overloaded && reached(nowMs, g_overloadEndMs)) g_overloaded = false;
+    return g_overloaded;
+  }
+
+  // Когда этап в следующий раз готов: release, а отложенный — не раньше retryMs
+  inline uint32_t dueMs(const StageSlot& s) {
+    return reached(s.retryMs, s.nextReleaseMs) ? s.retryMs : s.nextReleaseMs;
+  }
+
+  // Отложить этап: release остаётся в прошлом (дедлайн считается от него),
+  // повтор — на следующем тике сетки. Если отстали уже на целый период —
+  // этот запуск пропускаем совсем.
+  void deferSlot(StageSlot& s, uint32_t nowMs) {
+    s.deferrals++;
+    s.retryMs = tickStart(nowMs) + SCHED_TICK_MS;
+    while ((int32_t)(nowMs - s.nextReleaseMs) >= (int32_t)s.periodMs) {
+      s.nextReleaseMs += s.periodMs;
+      s.skippedPeriods++;
+    }
+  }
+
+  void runSlot(StageSlot& s, const TickContext& ctx) {
+    const uint32_t nowMs   = ctx.nowMs;
+    uint32_t       release = s.nextReleaseMs;
+
+    uint32_t c0 = Perf::cycles();
+    s.fn(ctx);
+    Perf::record(s.perf, Perf::cycles() - c0);
+    s.runs++;
+
+    uint32_t doneMs = Clock::millis();
+    if (!reached(release + s.deadlineMs, doneMs)) {
+      s.deadlineMisses++;
+    }
+
+    // следующий запуск — строго по сетке; если отстали больше чем на период,
+    // пропущенные запуски не догоняем, а считаем
+    s.nextReleaseMs = release + s.periodMs;
+    while (reached(nowMs, s.nextReleaseMs)) {
+      s.nextReleaseMs += s.periodMs;
+      s.skippedPeriods++;
+    }
+  }
+
+  // Внеочередной запуск по событию: сетка и счётчики периодов не трогаются.
+  // Этап, чей release уже наступил, выполнится штатно в этом же тике.
+  void runEvents(uint32_t events, const TickContext& ctx) {
+    for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+      StageSlot& s = g_slots[i];
+      if (!(s.events & events) || reached(ctx.nowMs, dueMs(s))) continue;
+      if (s.prio == Prio::Deferrable && overloaded(ctx.nowMs)) continue;
+
+      uint32_t c0 = Perf::cycles();
+      s.fn(ctx);
+      Perf::record(s.perf, Perf::cycles() - c0);
+    }
+  }
+
+  // Сколько можно спать до ближайшего release (не больше SCHED_TICK_MS)
+  uint32_t msUntilNextRelease(uint32_t nowMs) {
+    uint32_t wait = SCHED_TICK_MS;
+    for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+      int32_t d = (int32_t)(dueMs(g_slots[i]) - nowMs);
+      if (d <= 0) return 0;
+      if ((uint32_t)d < wait) wait = (uint32_t)d;
+    }
+    return wait;
+  }
+
+  void automationTask(void*) {
+    StateMachine::begin(Clock::millis());
+
     for (;;) {
-      Automation::stepCritical();
-      Automation::stepHigh();
-      Automation::stepMedium();
-      Automation::stepLow();
+      StateMachine::runDue(Clock::millis());
+
+      uint32_t waitMs = msUntilNextRelease(Clock::millis());
+      if (waitMs > 0) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+      }
+    }
+  }
+}
+
+void StateMachine::begin(uint32_t nowMs) {
+  for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+    StageSlot& s = g_slots[i];
+    s.nextReleaseMs  = nowMs + s.phaseMs;
+    s.retryMs        = s.nextReleaseMs;
+    s.runs           = 0;
+    s.deadlineMisses = 0;
+    s.skippedPeriods = 0;
+    s.deferrals      = 0;
+  }
+
+  g_sched         = {};
+  g_overloaded    = false;
+  g_shedCounted   = false;
+  Tick::reset();
+
+  portENTER_CRITICAL(&g_eventMux);
+  g_pendingEvents = 0;
+  g_eventStats    = {};
+  portEXIT_CRITICAL(&g_eventMux);
+}
+
+void StateMachine::notify(uint32_t events) {
+  portENTER_CRITICAL(&g_eventMux);
+  if (g_pendingEvents == 0) g_firstEventUs = micros();
+  g_pendingEvents |= events;
+  portEXIT_CRITICAL(&g_eventMux);
+
+  if (g_taskHandle) xTaskNotifyGive(g_taskHandle);
+}
+
+StateMachine::EventStats StateMachine::getEventStats() {
+  portENTER_CRITICAL(&g_eventMux);
+  EventStats out = g_eventStats;
+  portEXIT_CRITICAL(&g_eventMux);
+  return out;
+}
+
+void StateMachine::runDue(uint32_t nowMs) {
+  uint32_t tick0 = Perf::cycles();   // только для замеров на этом ядре
+  uint32_t us0   = micros();
+  bool     any   = false;
+  bool     shed  = false;
+
+  portENTER_CRITICAL(&g_eventMux);
+  uint32_t events = g_pendingEvents;
+  g_pendingEvents = 0;
+  if (events) {
+    uint32_t latUs = us0 - g_firstEventUs;
+    g_eventStats.wakeups++;
+    g_eventStats.lastLatencyUs = latUs;
+    if (latUs > g_eventStats.maxLatencyUs) g_eventStats.maxLatencyUs = latUs;
+  }
+  portEXIT_CRITICAL(&g_eventMux);
+
+  // ручные команды выполняются здесь, в задаче автоматики, в порядке постановки
+  if (events & EVENT_MANUAL) {
+    CommandQueue::applyPending();
+  }
 
-      DeviceManager::loopFast();
-      TelemetryLogger::loop();
-      Diagnostics::loop();
+  // контекст — только если в этом тике что-то выполнится
+  bool due = events != 0;
+  for (uint8_t i = 0; i < SLOT_COUNT && !due; ++i) {
+    due = reached(nowMs, dueMs(g_slots[i]));
+  }
+  if (!due) return;
+
+  TickContext ctx;
+  Tick::build(nowMs, ctx);
+
+  if (events) {
+    runEvents(events, ctx);
+    any = true;
+  }
+
+  for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+    StageSlot& s = g_slots[i];
+    if (!reached(nowMs, dueMs(s))) continue;
 
-      vTaskDelay(pdMS_TO_TICKS(AutomationConfig::AUTOMATION_INTERVAL_MS));
+    if (s.prio == Prio::Deferrable &&
+        (overloaded(nowMs) || elapsedUs(tick0) > TICK_BUDGET_US)) {
+      deferSlot(s, nowMs);
+      shed = true;
+      continue;
     }
+
+    runSlot(s, ctx);
+    any = true;
   }
+
+  // всё, что этапы и ручные команды задали за тик, — одним выводом на железо
+  DeviceManager::commitOutputs();
+
+  // несколько пробуждений в одном тике сетки — один shedTick
+  if (shed && !(g_shedCounted && g_shedTickMs == tickStart(nowMs))) {
+    g_sched.shedTicks++;
+    g_shedTickMs  = tickStart(nowMs);
+    g_shedCounted = true;
+  }
+  if (!any) return;
+
+  uint32_t tickCyc = Perf::cycles() - tick0;
+  uint32_t tickUs  = tickCyc / Perf::cpuMHz();
+  Perf::record(Perf::Stage::Tick, tickCyc);
+
+  g_sched.ticks++;
+  if (tickUs > g_sched.maxTickUs) g_sched.maxTickUs = tickUs;
+
+  // удержание отсчитывается по времени: снимается и без новых запусков
+  if (tickUs > TICK_BUDGET_US) {
+    g_sched.overruns++;
+    g_overloaded    = true;
+    g_overloadEndMs = tickStart(nowMs) + (OVERLOAD_HOLD_TICKS + 1) * SCHED_TICK_MS;
+  }
+}
+
+StateMachine::SchedStats StateMachine::getSchedStats() {
+  SchedStats out  = g_sched;
+  out.overloaded  = overloaded(Clock::millis());
+  return out;
+}
+
+bool StateMachine::getStageInfo(uint8_t index, StageInfo& out) {
+  for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+    const StageSlot& s = g_slots[i];
+    if ((uint8_t)s.perf != index) continue;
+    out.periodMs       = s.periodMs;
+    out.phaseMs        = s.phaseMs;
+    out.deadlineMs     = s.deadlineMs;
+    out.runs           = s.runs;
+    out.deadlineMisses = s.deadlineMisses;
+    out.skippedPeriods = s.skippedPeriods;
+    out.deferrals      = s.deferrals;
+    out.critical       = s.prio == Prio::Critical;
+    out.deferrable     = s.prio == Prio::Deferrable;
+    return true;
+  }
+  return false;
 }
 
 void StateMachine::startTask() {
+  Perf::reset();
+
   xTaskCreatePinnedToCore(
     automationTask,
     "automationTask",
     8192,
     nullptr,
     2,
-    nullptr,
+    &g_taskHandle,
     1
   );
-}
\ No newline at end of file
+}
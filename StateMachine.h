@@ -1,6 +1,59 @@
 // === FILE: StateMachine.h ===
 #pragma once
+#include <stdint.h>
 
 namespace StateMachine {
   void startTask();
-}
\ No newline at end of file
+
+  // Планировщик без задачи FreeRTOS (для хост-симулятора/реплея):
+  // begin() выставляет фазы относительно nowMs, runDue() выполняет
+  // все этапы, чьё время пришло. На ESP32 это делает automationTask.
+  void begin(uint32_t nowMs);
+  void runDue(uint32_t nowMs);
+
+  // Параметры и счётчики этапа для /api/perf
+  struct StageInfo {
+    uint32_t periodMs;
+    uint32_t phaseMs;
+    uint32_t deadlineMs;
+    uint32_t runs;
+    uint32_t deadlineMisses;   // завершился позже release + deadline
+    uint32_t skippedPeriods;   // пропущенные целиком периоды (отставание > периода)
+    uint32_t deferrals;        // сколько раз отложен из-за перегрузки
+    bool     critical;         // выполняется всегда, даже при перегрузке
+    bool     deferrable;       // откладывается при перегрузке
+  };
+
+  // index — порядковый номер Perf::Stage; false, если такого этапа нет
+  bool getStageInfo(uint8_t index, StageInfo& out);
+
+  // События, по которым automationTask просыпается вне сетки периодов
+  enum Event : uint32_t {
+    EVENT_MANUAL   = 1u << 0,  // ручная команда из Web UI / Telegram
+    EVENT_SENSORS  = 1u << 1,  // новый отсчёт датчиков
+    EVENT_SETTINGS = 1u << 2,  // изменены настройки
+  };
+
+  // Можно вызывать из любой задачи (не из ISR). Связанные этапы
+  // выполняются сразу, сетка периодических запусков не сдвигается.
+  void notify(uint32_t events);
+
+  struct EventStats {
+    uint32_t wakeups;        // обработанных пробуждений по событиям
+    uint32_t lastLatencyUs;  // notify() → начало обработки, по micros() (общие для ядер)
+    uint32_t maxLatencyUs;
+  };
+
+  EventStats getEventStats();
+
+  // Бюджет тика: превышение TICK_BUDGET_US включает режим перегрузки
+  struct SchedStats {
+    uint32_t ticks;       // тиков, в которых что-то выполнялось
+    uint32_t overruns;    // тиков дольше бюджета
+    uint32_t shedTicks;   // тиков, в которых Deferrable-этапы откладывались
+    uint32_t maxTickUs;
+    bool     overloaded;  // режим перегрузки активен сейчас
+  };
+
+  SchedStats getSchedStats();
+}
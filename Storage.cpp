@@ -2,12 +2,15 @@
 #include "Storage.h"
 #include "Config.h"
 #include <EEPROM.h>
+#include <SPIFFS.h>
+#include <string.h>
 
 namespace {
   constexpr size_t EEPROM_SIZE = 1024;
 
-  uint32_t crc32(const uint8_t* data, size_t len) {
-    uint32_t crc = 0xFFFFFFFF;
+  // crc — результат по предыдущему куску: crc32(b, crc32(a)) == crc32(a+b)
+  uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0) {
+    crc = ~crc;
     while (len--) {
       uint8_t b = *data++;
       crc ^= b;
@@ -19,6 +22,20 @@ namespace {
     return ~crc;
   }
 
+  constexpr const char* RULES_TMP_PATH     = "/rules.tmp";
+  constexpr const char* PUMP_DUTY_TMP_PATH = "/pumpduty.tmp";
+
+  // Файлы сохраняются через tmp: tmp пишется целиком, старый файл
+  // удаляется (SPIFFS не переименовывает поверх), tmp переименовывается.
+  // Сбой между remove и rename оставляет только полный tmp — доводим
+  // замену при чтении.
+  void finishReplace(const char* tmp, const char* path) {
+    if (SPIFFS.exists(path) || !SPIFFS.exists(tmp)) return;
+    if (SPIFFS.rename(tmp, path)) {
+      Serial.printf("[Storage] %s recovered from %s\n", path, tmp);
+    }
+  }
+
   struct EepromBlob {
     uint32_t      magic;
     uint16_t      version;
@@ -26,6 +43,26 @@ namespace {
     SystemSettings settings;
     uint32_t      crc;
   };
+
+  struct PumpDutyPrefix {
+    uint32_t       magic;
+    uint16_t       version;
+    uint16_t       reserved;
+    PumpDutyHeader header;
+  };
+
+  struct ProfilesBlob {
+    uint32_t        magic;
+    uint16_t        version;
+    uint16_t        count;
+    UserCropProfile slots[StorageConfig::USER_PROFILES_MAX];
+    uint32_t        crc;
+  };
+
+  static_assert(sizeof(EepromBlob) <= StorageConfig::PROFILES_ADDR,
+                "settings overlap crop profiles in EEPROM");
+  static_assert(StorageConfig::PROFILES_ADDR + sizeof(ProfilesBlob) <= EEPROM_SIZE,
+                "crop profiles do not fit into EEPROM");
 }
 
 void Storage::begin() {
@@ -89,4 +126,166 @@ bool Storage::saveSettings(const SystemSettings& in) {
   }
   Serial.println("[Storage] Settings saved");
   return true;
-}
\ No newline at end of file
+}
+
+bool Storage::loadCropProfiles(UserCropProfile* out, uint8_t count) {
+  memset(out, 0, sizeof(UserCropProfile) * count);
+  if (count > StorageConfig::USER_PROFILES_MAX) count = StorageConfig::USER_PROFILES_MAX;
+
+  ProfilesBlob blob;
+  EEPROM.get(StorageConfig::PROFILES_ADDR, blob);
+
+  // пустая область — обычное дело (профилей ещё не заводили), не пишем
+  if (blob.magic != StorageConfig::PROFILES_MAGIC ||
+      blob.version != StorageConfig::PROFILES_VER ||
+      blob.count != StorageConfig::USER_PROFILES_MAX) {
+    return false;
+  }
+
+  if (crc32((uint8_t*)blob.slots, sizeof(blob.slots)) != blob.crc) {
+    Serial.println("[Storage] Crop profiles CRC mismatch, ignored");
+    return false;
+  }
+
+  memcpy(out, blob.slots, sizeof(UserCropProfile) * count);
+  return true;
+}
+
+bool Storage::saveCropProfiles(const UserCropProfile* in, uint8_t count) {
+  if (count > StorageConfig::USER_PROFILES_MAX) count = StorageConfig::USER_PROFILES_MAX;
+
+  ProfilesBlob blob{};
+  blob.magic   = StorageConfig::PROFILES_MAGIC;
+  blob.version = StorageConfig::PROFILES_VER;
+  blob.count   = StorageConfig::USER_PROFILES_MAX;
+  memcpy(blob.slots, in, sizeof(UserCropProfile) * count);
+  blob.crc     = crc32((uint8_t*)blob.slots, sizeof(blob.slots));
+
+  EEPROM.put(StorageConfig::PROFILES_ADDR, blob);
+  if (!EEPROM.commit()) {
+    Serial.println("[Storage] EEPROM commit failed");
+    return false;
+  }
+  Serial.println("[Storage] Crop profiles saved");
+  return true;
+}
+
+bool Storage::loadRules(String& out) {
+  out = "";
+  finishReplace(RULES_TMP_PATH, RulesConfig::SOURCE_PATH);
+  File f = SPIFFS.open(RulesConfig::SOURCE_PATH, FILE_READ);
+  if (!f) return false;
+
+  size_t size = f.size();
+  if (size > RulesConfig::SOURCE_MAX) {
+    Serial.println("[Storage] Rules file too large, ignored");
+    f.close();
+    return false;
+  }
+
+  out.reserve(size);
+  char buf[128];
+  size_t n;
+  while ((n = f.read((uint8_t*)buf, sizeof(buf) - 1)) > 0) {
+    buf[n] = '\0';
+    out += buf;
+  }
+  f.close();
+  return true;
+}
+
+bool Storage::saveRules(const char* src, size_t len) {
+  if (len > RulesConfig::SOURCE_MAX) return false;
+
+  File f = SPIFFS.open(RULES_TMP_PATH, FILE_WRITE);
+  if (!f) {
+    Serial.println("[Storage] Rules file open failed");
+    return false;
+  }
+  size_t written = f.write((const uint8_t*)src, len);
+  f.close();
+
+  if (written != len) {
+    Serial.println("[Storage] Rules write failed");
+    SPIFFS.remove(RULES_TMP_PATH);
+    return false;
+  }
+
+  SPIFFS.remove(RulesConfig::SOURCE_PATH);
+  if (!SPIFFS.rename(RULES_TMP_PATH, RulesConfig::SOURCE_PATH)) {
+    Serial.println("[Storage] Rules rename failed");
+    return false;
+  }
+  Serial.println("[Storage] Rules saved");
+  return true;
+}
+
+bool Storage::loadPumpDuty(PumpDutyHeader& h, uint32_t* buckets, uint16_t count) {
+  const size_t bytes = (size_t)count * sizeof(uint32_t);
+  memset(buckets, 0, bytes);
+
+  finishReplace(PUMP_DUTY_TMP_PATH, PumpDutyConfig::PATH);
+  File f = SPIFFS.open(PumpDutyConfig::PATH, FILE_READ);
+  if (!f) return false;
+
+  PumpDutyPrefix pre;
+  uint32_t       crc = 0;
+  bool ok = f.size() == sizeof(pre) + bytes + sizeof(crc) &&
+            f.read((uint8_t*)&pre, sizeof(pre)) == sizeof(pre) &&
+            pre.magic == StorageConfig::PUMP_DUTY_MAGIC &&
+            pre.version == StorageConfig::PUMP_DUTY_VER &&
+            pre.header.buckets == count && pre.header.head < count &&
+            f.read((uint8_t*)buckets, bytes) == bytes &&
+            f.read((uint8_t*)&crc, sizeof(crc)) == sizeof(crc);
+  f.close();
+
+  if (ok) {
+    uint32_t calc = crc32((const uint8_t*)&pre.header, sizeof(pre.header));
+    calc = crc32((const uint8_t*)buckets, bytes, calc);
+    ok = calc == crc;
+  }
+  if (!ok) {
+    Serial.println("[Storage] Pump duty file invalid, ignored");
+    memset(buckets, 0, bytes);
+    return false;
+  }
+
+  h = pre.header;
+  return true;
+}
+
+bool Storage::savePumpDuty(const PumpDutyHeader& h, const uint32_t* buckets, uint16_t count) {
+  const size_t bytes = (size_t)count * sizeof(uint32_t);
+
+  PumpDutyPrefix pre{};
+  pre.magic          = StorageConfig::PUMP_DUTY_MAGIC;
+  pre.version        = StorageConfig::PUMP_DUTY_VER;
+  pre.header         = h;
+  pre.header.buckets = count;
+
+  uint32_t crc = crc32((const uint8_t*)&pre.header, sizeof(pre.header));
+  crc = crc32((const uint8_t*)buckets, bytes, crc);
+
+  File f = SPIFFS.open(PUMP_DUTY_TMP_PATH, FILE_WRITE);
+  if (!f) {
+    Serial.println("[Storage] Pump duty file open failed");
+    return false;
+  }
+  bool ok = f.write((const uint8_t*)&pre, sizeof(pre)) == sizeof(pre) &&
+            f.write((const uint8_t*)buckets, bytes) == bytes &&
+            f.write((const uint8_t*)&crc, sizeof(crc)) == sizeof(crc);
+  f.close();
+
+  if (!ok) {
+    Serial.println("[Storage] Pump duty write failed");
+    SPIFFS.remove(PUMP_DUTY_TMP_PATH);
+    return false;
+  }
+
+  SPIFFS.remove(PumpDutyConfig::PATH);
+  if (!SPIFFS.rename(PUMP_DUTY_TMP_PATH, PumpDutyConfig::PATH)) {
+    Serial.println("[Storage] Pump duty rename failed");
+    return false;
+  }
+  return true;
+}
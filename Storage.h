@@ -7,4 +7,22 @@ namespace Storage {
   bool loadSettings(SystemSettings& out);
   bool saveSettings(const SystemSettings& in);
   void resetDefaults(SystemSettings& out);
-}
\ No newline at end of file
+
+  // Пользовательские профили культур: USER_PROFILES_MAX слотов.
+  // load — false, если область пуста или битая (слоты обнулены).
+  bool loadCropProfiles(UserCropProfile* out, uint8_t count);
+  bool saveCropProfiles(const UserCropProfile* in, uint8_t count);
+
+  // Исходный текст правил (Rules) — файл RulesConfig::SOURCE_PATH в SPIFFS.
+  // load — false, если файла нет или он длиннее SOURCE_MAX.
+  // save пишет во временный файл и переименовывает: при сбое питания
+  // остаётся либо старый, либо новый текст целиком.
+  bool loadRules(String& out);
+  bool saveRules(const char* src, size_t len);
+
+  // Кольцо наработки насоса (PumpDuty) — файл PumpDutyConfig::PATH:
+  // заголовок, count корзин по uint32, CRC. load — false, если файла нет,
+  // он битый или другой длины (buckets тогда обнулены).
+  bool loadPumpDuty(PumpDutyHeader& h, uint32_t* buckets, uint16_t count);
+  bool savePumpDuty(const PumpDutyHeader& h, const uint32_t* buckets, uint16_t count);
+}
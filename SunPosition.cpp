@@ -1,6 +1,8 @@
 // === FILE: SunPosition.cpp ===
 #include "SunPosition.h"
 #include "Config.h"
+#include "Clock.h"
+#include <Arduino.h>
 
 #include <math.h>
 #include <time.h>
@@ -17,6 +19,191 @@ double norm360(double xDeg) {
   return r;
 }
 
+// ---------- float-ядро (calculateFast) ----------
+// У ESP32 FPU только одинарной точности: double-тригонометрия идёт
+// программно. Здесь всё во float, аргументы приводятся к малому отрезку,
+// sin/cos, asin и atan2 — полиномы; вековой рост углов (дни от J2000 × скорость)
+// приводится по модулю 360° в целых, чтобы не терять точность float.
+
+constexpr float F_PI       = 3.14159265f;
+constexpr float F_HALF_PI  = 1.57079633f;
+constexpr float F_DEG2RAD  = F_PI / 180.0f;
+constexpr float F_RAD2DEG  = 180.0f / F_PI;
+
+constexpr time_t  J2000_UTC = 946728000;            // 2000-01-01 12:00 UTC
+constexpr int64_t TURN_E8   = 36000000000LL;        // 360° в 1e-8 градуса
+
+// floorf без обращения к libm (аргументы здесь — единицы оборотов)
+inline float floorFast(float x) {
+  float t = (float)(int32_t)x;
+  return t > x ? t - 1.0f : t;
+}
+
+inline float red360f(float x) {
+  return x - 360.0f * floorFast(x * (1.0f / 360.0f));
+}
+
+// Угол base + rate·(days + frac), rateE8 — та же скорость в 1e-8 °/сутки
+inline float dailyAngle(float baseDeg, int64_t rateE8, int32_t days, float frac) {
+  int64_t a = ((int64_t)days * rateE8) % TURN_E8;
+  if (a < 0) a += TURN_E8;
+  return red360f(baseDeg + (float)a * 1e-8f + (float)rateE8 * 1e-8f * frac);
+}
+
+// sin и cos угла в градусах: квадрант по ближайшему кратному 90°,
+// остаток [-45°, 45°] — ряд до x^9 / x^10 (погрешность < 2e-9)
+inline void sinCosDeg(float deg, float& s, float& c) {
+  deg = red360f(deg);
+  int32_t k = (int32_t)(deg * (1.0f / 90.0f) + 0.5f);
+  float   r = (deg - 90.0f * k) * F_DEG2RAD;
+  float   r2 = r * r;
+
+  float sr = r * (1.0f + r2 * (-1.0f / 6 + r2 * (1.0f / 120 + r2 * (-1.0f / 5040 + r2 * (1.0f / 362880)))));
+  float cr = 1.0f + r2 * (-0.5f + r2 * (1.0f / 24 + r2 * (-1.0f / 720 + r2 * (1.0f / 40320 - r2 * (1.0f / 3628800)))));
+
+  switch (k & 3) {
+    case 0:  s =  sr; c =  cr; break;
+    case 1:  s =  cr; c = -sr; break;
+    case 2:  s = -sr; c = -cr; break;
+    default: s = -cr; c =  sr; break;
+  }
+}
+
+// acos, радианы: Абрамовиц–Стиган 4.4.46, |ошибка| <= 2e-8
+inline float acosFast(float x) {
+  if (x >  1.0f) x =  1.0f;
+  if (x < -1.0f) x = -1.0f;
+  float ax = fabsf(x);
+  float p = -0.0012624911f;
+  p = p * ax + 0.0066700901f;
+  p = p * ax - 0.0170881256f;
+  p = p * ax + 0.0308918810f;
+  p = p * ax - 0.0501743046f;
+  p = p * ax + 0.0889789874f;
+  p = p * ax - 0.2145988016f;
+  p = p * ax + 1.5707963050f;
+  float r = sqrtf(1.0f - ax) * p;
+  return x < 0.0f ? F_PI - r : r;
+}
+
+inline float asinFast(float x) {
+  return F_HALF_PI - acosFast(x);
+}
+
+// atan2, радианы: приведение к |x| <= 1 и ряд А–С 4.4.49, |ошибка| <= 2e-8
+inline float atan2Fast(float y, float x) {
+  float ax = fabsf(x), ay = fabsf(y);
+  if (ax == 0.0f && ay == 0.0f) return 0.0f;
+
+  bool  swap = ay > ax;
+  float z    = swap ? ax / ay : ay / ax;
+  float z2   = z * z;
+  float p = 0.0028662257f;
+  p = p * z2 - 0.0161657367f;
+  p = p * z2 + 0.0429096138f;
+  p = p * z2 - 0.0752896400f;
+  p = p * z2 + 0.1065626393f;
+  p = p * z2 - 0.1420889944f;
+  p = p * z2 + 0.1999355085f;
+  p = p * z2 - 0.3333314528f;
+  float a = z + z * z2 * p;
+
+  if (swap)     a = F_HALF_PI - a;
+  if (x < 0.0f) a = F_PI - a;
+  return y < 0.0f ? -a : a;
+}
+
+// ---------- суточная таблица ----------
+
+using SunPosition::DayTable;
+using SunPosition::TABLE_POINTS;
+using SunPosition::TABLE_STEP_MIN;
+using SunPosition::NO_EVENT;
+
+constexpr uint32_t STEP_S = TABLE_STEP_MIN * 60UL;
+
+// Таблица пишется только из automationTask (этап SunTable); Web UI копирует
+// её под g_tableMux и только когда g_ready — строящуюся таблицу не видит
+DayTable     g_table    = {};
+bool         g_ready    = false;
+uint16_t     g_next     = 0;      // следующая точка при построении
+uint32_t     g_builds   = 0;
+portMUX_TYPE g_tableMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Прямой расчёт, пока таблицы нет
+time_t          g_directUtc   = 0;
+bool            g_directValid = false;
+SunPositionData g_direct      = {};
+
+time_t localDayStart(time_t nowUtc) {
+  const time_t tz = (time_t)LocationConfig::TZ_OFFSET_MIN * 60;
+  time_t local = nowUtc + tz;
+  time_t day   = local - ((local % 86400) + 86400) % 86400;
+  return day - tz;
+}
+
+inline bool covers(time_t nowUtc) {
+  return g_ready &&
+         nowUtc >= g_table.dayStartUtc &&
+         nowUtc <  g_table.dayStartUtc + 86400;
+}
+
+const SunPositionData& directAt(time_t nowUtc) {
+  time_t age = nowUtc - g_directUtc;
+  if (!g_directValid || age < 0 || age >= (time_t)AutomationConfig::SUN_REFRESH_S) {
+    g_direct = SunPosition::calculateFast(
+        nowUtc,
+        LocationConfig::LATITUDE_DEG,
+        LocationConfig::LONGITUDE_DEG
+    );
+    g_directUtc   = nowUtc;
+    g_directValid = true;
+  }
+  return g_direct;
+}
+
+// Момент пересечения горизонта между точками i и i+1, минуты от полуночи
+int16_t crossingMin(uint16_t i) {
+  float a0 = g_table.altCentiDeg[i];
+  float a1 = g_table.altCentiDeg[i + 1];
+  float f  = (a0 == a1) ? 0.0f : a0 / (a0 - a1);
+  return (int16_t)lroundf((i + f) * TABLE_STEP_MIN);
+}
+
+// Восход, закат и кульминация по готовой сетке
+void finalizeTable() {
+  g_table.sunriseMin = NO_EVENT;
+  g_table.sunsetMin  = NO_EVENT;
+
+  uint16_t top = 0;
+  for (uint16_t i = 0; i + 1 < TABLE_POINTS; ++i) {
+    int16_t a0 = g_table.altCentiDeg[i];
+    int16_t a1 = g_table.altCentiDeg[i + 1];
+    if (a0 <= 0 && a1 > 0 && g_table.sunriseMin == NO_EVENT) g_table.sunriseMin = crossingMin(i);
+    if (a0 > 0 && a1 <= 0) g_table.sunsetMin = crossingMin(i);
+    if (a1 > g_table.altCentiDeg[top]) top = i + 1;
+  }
+
+  // вершина параболы по трём точкам вокруг максимума
+  float shift = 0.0f;
+  if (top > 0 && top + 1 < TABLE_POINTS) {
+    float am = g_table.altCentiDeg[top - 1];
+    float a0 = g_table.altCentiDeg[top];
+    float ap = g_table.altCentiDeg[top + 1];
+    float d  = am - 2.0f * a0 + ap;
+    if (d < 0.0f) shift = 0.5f * (am - ap) / d;
+  }
+  g_table.noonMin         = (int16_t)lroundf((top + shift) * TABLE_STEP_MIN);
+  g_table.noonAltCentiDeg = g_table.altCentiDeg[top];
+}
+
+// Линейная интерполяция между соседними точками сетки
+inline void tableIndex(time_t nowUtc, uint16_t& i, float& f) {
+  uint32_t sec = (uint32_t)(nowUtc - g_table.dayStartUtc);
+  i = sec / STEP_S;
+  f = (float)(sec % STEP_S) / STEP_S;
+}
+
 } // namespace
 
 // Для совместимости: сейчас инициализация не нужна,
@@ -34,11 +221,13 @@ SunPositionData SunPosition::calculate(time_t nowUtc,
   out.azimuthDeg  = 0.0f;
   out.isDay       = false;
 
-  // Перевод времени в "локальное"
-  time_t nowLocal = nowUtc + tzOffsetMin * 60;
+  // Юлианская дата и часовой угол считаются от UTC: поправка на долготу
+  // (4 мин/°) уже даёт местное солнечное время. Прибавлять сюда часовой
+  // пояс нельзя — кривая сдвигается на TZ_OFFSET_MIN.
+  (void)tzOffsetMin;
 
   struct tm t;
-  gmtime_r(&nowLocal, &t);
+  gmtime_r(&nowUtc, &t);
 
   int year  = t.tm_year + 1900;
   int month = t.tm_mon + 1;
@@ -139,19 +328,181 @@ SunPositionData SunPosition::calculate(time_t nowUtc,
   return out;
 }
 
+SunPositionData SunPosition::calculateFast(time_t nowUtc,
+                                           float latitudeDeg,
+                                           float longitudeDeg) {
+  // дни от J2000: целая часть — для точного приведения углов, дробная — float
+  int64_t sec  = (int64_t)(nowUtc - J2000_UTC);
+  int64_t day  = sec / 86400;
+  int64_t rem  = sec % 86400;
+  if (rem < 0) { rem += 86400; day -= 1; }
+  float   frac = (float)rem / 86400.0f;
+  float   T    = ((float)day + frac) / 36525.0f;
+
+  // Средняя долгота, средняя аномалия, долгота узла (°/сутки = °/век / 36525)
+  float L0    = dailyAngle(280.46646f, 98564736LL, (int32_t)day, frac) + 0.0003032f * T * T;
+  float M     = dailyAngle(357.52911f, 98560028LL, (int32_t)day, frac) - 0.0001537f * T * T;
+  float Omega = dailyAngle(125.04f,    -5295376LL, (int32_t)day, frac);
+  float e     = 0.016708634f - 0.000042037f * T;
+
+  float sinM, cosM;
+  sinCosDeg(M, sinM, cosM);
+  float sin2M = 2.0f * sinM * cosM;
+  float sin3M = sinM * (3.0f - 4.0f * sinM * sinM);
+
+  float C = (1.914602f - 0.004817f * T) * sinM
+          + (0.019993f - 0.000101f * T) * sin2M
+          + 0.000289f * sin3M;
+
+  float sinOm, cosOm;
+  sinCosDeg(Omega, sinOm, cosOm);
+  float lambda  = L0 + C - 0.00569f - 0.00478f * sinOm;
+  float epsilon = 23.439291f - 0.0130042f * T + 0.00256f * cosOm;
+
+  float sinEps, cosEps, sinLam, cosLam;
+  sinCosDeg(epsilon, sinEps, cosEps);
+  sinCosDeg(lambda,  sinLam, cosLam);
+
+  float sinDelta = sinEps * sinLam;
+  float cosDelta = sqrtf(1.0f - sinDelta * sinDelta);
+
+  // Уравнение времени, y = tan²(ε/2)
+  float y = (1.0f - cosEps) / (1.0f + cosEps);
+  float sin2L0, cos2L0;
+  sinCosDeg(2.0f * L0, sin2L0, cos2L0);
+  float sin4L0 = 2.0f * sin2L0 * cos2L0;
+
+  float Etime =
+      y * sin2L0
+    - 2.0f * e * sinM
+    + 4.0f * e * y * sinM * cos2L0
+    - 0.5f * y * y * sin4L0
+    - 1.25f * e * e * sin2M;
+  Etime *= F_RAD2DEG * 4.0f;   // минуты
+
+  // Часовой угол: минуты UTC-суток (от полуночи) + поправки
+  float solarTimeMin = (float)((rem + 43200) % 86400) / 60.0f + Etime + 4.0f * longitudeDeg;
+  solarTimeMin -= 1440.0f * floorFast(solarTimeMin * (1.0f / 1440.0f));
+  float hourAngleDeg = solarTimeMin * 0.25f - 180.0f;
+
+  // Зенитное расстояние z через гаверсинусы — в отличие от
+  // asin(sin φ sin δ + …) не теряет точность у зенита и надира:
+  //   hav z     = sin²((φ-δ)/2) + cos φ·cos δ·sin²(H/2)
+  //   hav(π-z)  = sin²((φ+δ)/2) + cos φ·cos δ·cos²(H/2)
+  float deltaDeg = asinFast(sinDelta) * F_RAD2DEG;
+
+  float sinLat, cosLat, sinHd, cosHd, sinHs, cosHs, sinHalfH, cosHalfH;
+  sinCosDeg(latitudeDeg,                     sinLat,   cosLat);
+  sinCosDeg(0.5f * (latitudeDeg - deltaDeg), sinHd,    cosHd);
+  sinCosDeg(0.5f * (latitudeDeg + deltaDeg), sinHs,    cosHs);
+  sinCosDeg(0.5f * hourAngleDeg,             sinHalfH, cosHalfH);
+
+  float cc   = cosLat * cosDelta;
+  float hav  = sinHd * sinHd + cc * sinHalfH * sinHalfH;
+  float havN = sinHs * sinHs + cc * cosHalfH * cosHalfH;
+
+  float altRad = hav <= havN
+    ? F_HALF_PI - 2.0f * asinFast(sqrtf(hav))
+    : 2.0f * asinFast(sqrtf(havN)) - F_HALF_PI;
+
+  // Азимут от севера по часовой: atan2 без деления на cos(высоты)
+  float sinH  = 2.0f * sinHalfH * cosHalfH;
+  float cosH  = 1.0f - 2.0f * sinHalfH * sinHalfH;
+  float azDeg = atan2Fast(-sinH * cosDelta,
+                          sinDelta * cosLat - cosDelta * sinLat * cosH) * F_RAD2DEG;
+  if (azDeg < 0.0f) azDeg += 360.0f;
+
+  SunPositionData out;
+  out.altitudeDeg = altRad * F_RAD2DEG;
+  out.azimuthDeg  = azDeg >= 360.0f ? azDeg - 360.0f : azDeg;
+  out.isDay       = out.altitudeDeg > 0.0f;
+  return out;
+}
+
 bool SunPosition::isDaylight() {
-  time_t nowUtc = time(nullptr);
-  if (nowUtc < 100000) {
+  time_t nowUtc = Clock::now();
+  if (!Clock::isWallValid()) {
     // времени ещё нет (RTC/NTP не подняты) — считаем, что "ночь"
     return false;
   }
+  return altitudeAt(nowUtc) > 0.0f;
+}
 
-  SunPositionData sun = calculate(
-      nowUtc,
-      LocationConfig::LATITUDE_DEG,
-      LocationConfig::LONGITUDE_DEG,
-      LocationConfig::TZ_OFFSET_MIN
-  );
+bool SunPosition::service(time_t nowUtc) {
+  time_t day = localDayStart(nowUtc);
+  if (g_ready && g_table.dayStartUtc == day) return true;
+
+  // новые сутки (полночь или перевод часов) — начинаем заново
+  if (g_ready || g_table.dayStartUtc != day) {
+    portENTER_CRITICAL(&g_tableMux);
+    g_ready = false;
+    portEXIT_CRITICAL(&g_tableMux);
+    g_table.dayStartUtc = day;
+    g_next = 0;
+  }
+
+  uint16_t end = g_next + AutomationConfig::SUN_TABLE_CHUNK;
+  if (end > TABLE_POINTS) end = TABLE_POINTS;
+
+  for (; g_next < end; ++g_next) {
+    SunPositionData p = calculateFast(
+        day + (time_t)g_next * STEP_S,
+        LocationConfig::LATITUDE_DEG,
+        LocationConfig::LONGITUDE_DEG
+    );
+    g_table.altCentiDeg[g_next] = (int16_t)lroundf(p.altitudeDeg * 100.0f);
+    g_table.azCentiDeg[g_next]  = (uint16_t)(lroundf(p.azimuthDeg * 100.0f) % 36000);
+  }
 
-  return sun.isDay;
-}
\ No newline at end of file
+  if (g_next < TABLE_POINTS) return false;
+
+  finalizeTable();
+  g_builds++;
+
+  portENTER_CRITICAL(&g_tableMux);
+  g_ready = true;
+  portEXIT_CRITICAL(&g_tableMux);
+
+  Serial.printf("[Sun] Day table ready: rise %d, set %d, noon %d min, max alt %.1f\n",
+                g_table.sunriseMin, g_table.sunsetMin, g_table.noonMin,
+                g_table.noonAltCentiDeg / 100.0);
+  return true;
+}
+
+float SunPosition::altitudeAt(time_t nowUtc) {
+  if (!covers(nowUtc)) return directAt(nowUtc).altitudeDeg;
+
+  uint16_t i; float f;
+  tableIndex(nowUtc, i, f);
+  float a0 = g_table.altCentiDeg[i];
+  float a1 = g_table.altCentiDeg[i + 1];
+  return (a0 + (a1 - a0) * f) * 0.01f;
+}
+
+float SunPosition::azimuthAt(time_t nowUtc) {
+  if (!covers(nowUtc)) return directAt(nowUtc).azimuthDeg;
+
+  uint16_t i; float f;
+  tableIndex(nowUtc, i, f);
+  float z0 = g_table.azCentiDeg[i];
+  float z1 = g_table.azCentiDeg[i + 1];
+  // через север (359° → 1°) — по короткой дуге
+  if (z1 - z0 >  18000.0f) z1 -= 36000.0f;
+  if (z0 - z1 >  18000.0f) z1 += 36000.0f;
+  float z = z0 + (z1 - z0) * f;
+  if (z < 0.0f)      z += 36000.0f;
+  if (z >= 36000.0f) z -= 36000.0f;
+  return z * 0.01f;
+}
+
+bool SunPosition::getTable(DayTable& out) {
+  portENTER_CRITICAL(&g_tableMux);
+  bool ok = g_ready;
+  if (ok) out = g_table;
+  portEXIT_CRITICAL(&g_tableMux);
+  return ok;
+}
+
+uint32_t SunPosition::tableBuilds() {
+  return g_builds;
+}
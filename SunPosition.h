@@ -20,14 +20,62 @@ namespace SunPosition {
   //  nowUtc        — UNIX-время в секундах (UTC)
   //  latitudeDeg   — широта (+N)
   //  longitudeDeg  — долгота (+E)
-  //  tzOffsetMin   — смещение по времени, минуты (например UTC+3 = 180)
+  //  tzOffsetMin   — смещение по времени, минуты (например UTC+3 = 180);
+  //                  на результат не влияет, оставлено для совместимости
   SunPositionData calculate(time_t nowUtc,
                             float latitudeDeg,
                             float longitudeDeg,
                             int   tzOffsetMin);
 
+  // То же во float: полиномиальные sin/cos/asin/atan2, вековые углы
+  // приводятся по модулю 360° в целых, высота — через гаверсинус (без
+  // потери точности у зенита). Для таблицы дня и частых запросов.
+  // Отклонение от calculate() (тест host/tests/sun_accuracy, 1975–2025,
+  // широты 0..±66.5°): высота — не более FAST_MAX_ALT_ERR_DEG (фактически
+  // ~1e-4°, в среднем ~2e-5°), азимут — до ~0.003° при высоте ниже 89°.
+  constexpr float FAST_MAX_ALT_ERR_DEG = 0.001f;
+
+  SunPositionData calculateFast(time_t nowUtc,
+                                float  latitudeDeg,
+                                float  longitudeDeg);
+
   // Удобная обёртка для автоматики:
-  // берёт текущее время (time(nullptr)), координаты и часовой пояс из Config.h
+  // берёт текущее время (Clock::now()), координаты и часовой пояс из Config.h
   // и возвращает true, если сейчас "день" (солнце над горизонтом).
+  // Чтение из суточной таблицы, если она уже построена.
   bool isDaylight();
+
+  // ---------- суточная таблица (эфемериды) ----------
+  // Раз в сутки (после локальной полуночи или скачка времени на другие
+  // сутки) calculateFast() прогоняется по сетке с шагом TABLE_STEP_MIN для
+  // координат из Config.h; дальше высота/азимут — чтение с интерполяцией.
+
+  constexpr uint16_t TABLE_STEP_MIN = 5;
+  constexpr uint16_t TABLE_POINTS   = 24 * 60 / TABLE_STEP_MIN + 1;  // 289: 00:00..24:00
+  constexpr int16_t  NO_EVENT       = -1;   // солнце не восходит/не заходит (полярные сутки)
+
+  struct DayTable {
+    time_t   dayStartUtc;              // локальная полночь (TZ_OFFSET_MIN) в UTC
+    int16_t  sunriseMin;               // минуты от полуночи или NO_EVENT
+    int16_t  sunsetMin;
+    int16_t  noonMin;                  // кульминация
+    int16_t  noonAltCentiDeg;
+    int16_t  altCentiDeg[TABLE_POINTS];
+    uint16_t azCentiDeg[TABLE_POINTS];
+  };
+
+  // Довести построение таблицы на сутки nowUtc: не больше SUN_TABLE_CHUNK
+  // точек за вызов, чтобы не занимать тик. true — таблица готова.
+  // Вызывается этапом SunTable планировщика.
+  bool service(time_t nowUtc);
+
+  // Высота/азимут на момент nowUtc: из таблицы, если она покрывает эти сутки,
+  // иначе прямым расчётом calculateFast() (не чаще раза в SUN_REFRESH_S)
+  float altitudeAt(time_t nowUtc);
+  float azimuthAt(time_t nowUtc);
+
+  // Копия готовой таблицы для Web UI (из любой задачи); false — таблицы нет
+  bool getTable(DayTable& out);
+
+  uint32_t tableBuilds();   // сколько раз таблица строилась с начала работы
 }
\ No newline at end of file
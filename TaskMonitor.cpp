@@ -0,0 +1,200 @@
+// === FILE: TaskMonitor.cpp ===
+#include "TaskMonitor.h"
+#include "Perf.h"
+#include "Clock.h"
+
+namespace {
+
+  using namespace TaskMonitor;
+
+  struct Tracked {
+    const char*  name;
+    uint32_t     stackSize;
+    Perf::Stage  busyStage;     // Stage::Count — своих тактов у задачи нет
+
+    TaskHandle_t handle       = nullptr;
+    uint32_t     stackFreeMin = UINT32_MAX;
+    uint16_t     cpuCentiPct  = UNKNOWN;
+    uint32_t     prevRun      = 0;   // runtime-счётчик FreeRTOS на прошлом отсчёте
+    uint64_t     prevBusy     = 0;   // сумма тактов Perf на прошлом отсчёте
+  };
+
+  // Размеры стеков — как при создании задач (StateMachine, DeviceManager,
+  // ядро Arduino и AsyncTCP)
+  Tracked g_tasks[] = {
+    { "automationTask", 8192,  Perf::Stage::Tick },
+    { "sensorTask",     4096,  Perf::Stage::Sensors },
+    { "loopTask",       8192,  Perf::Stage::Count },
+    { "async_tcp",      0,     Perf::Stage::Count },
+  };
+
+  constexpr uint8_t TASK_COUNT = sizeof(g_tasks) / sizeof(g_tasks[0]);
+  static_assert(TASK_COUNT <= MAX_TASKS, "TaskMonitor::MAX_TASKS too small");
+
+  Sample   g_hist[HISTORY_SIZE];
+  uint8_t  g_histHead  = 0;
+  uint8_t  g_histCount = 0;
+
+  uint32_t g_prevSampleMs  = 0;
+  uint16_t g_totalLoad     = UNKNOWN;
+
+#if !defined(YOTIK_HOST_BUILD) && configGENERATE_RUN_TIME_STATS
+  constexpr UBaseType_t MAX_SYS_TASKS = 24;
+  TaskStatus_t g_sys[MAX_SYS_TASKS];
+  uint32_t     g_prevTotalRun = 0;
+  uint32_t     g_prevIdleRun  = 0;
+
+  // Загрузка по runtime-статистике FreeRTOS: доля времени задачи от
+  // общего времени одного ядра; общая — 1 − доля idle-задач по всем ядрам
+  void sampleRuntime() {
+    uint32_t    totalRun = 0;
+    UBaseType_t n = uxTaskGetSystemState(g_sys, MAX_SYS_TASKS, &totalRun);
+    uint32_t    dTotal = totalRun - g_prevTotalRun;
+    g_prevTotalRun = totalRun;
+
+    uint32_t idleRun = 0;
+    for (UBaseType_t i = 0; i < n; ++i) {
+      const TaskStatus_t& ts = g_sys[i];
+      if (strncmp(ts.pcTaskName, "IDLE", 4) == 0) idleRun += ts.ulRunTimeCounter;
+
+      for (uint8_t k = 0; k < TASK_COUNT; ++k) {
+        Tracked& t = g_tasks[k];
+        if (ts.xHandle != t.handle) continue;
+        uint32_t dRun = ts.ulRunTimeCounter - t.prevRun;
+        t.prevRun     = ts.ulRunTimeCounter;
+        t.cpuCentiPct = dTotal ? (uint16_t)((uint64_t)dRun * 10000ULL / dTotal) : UNKNOWN;
+      }
+    }
+
+    uint32_t dIdle = idleRun - g_prevIdleRun;
+    g_prevIdleRun  = idleRun;
+    if (dTotal) {
+      uint64_t capacity = (uint64_t)dTotal * portNUM_PROCESSORS;
+      uint64_t idle     = dIdle > capacity ? capacity : dIdle;
+      g_totalLoad = (uint16_t)((capacity - idle) * 10000ULL / capacity);
+    }
+  }
+#endif
+
+#if !defined(YOTIK_HOST_BUILD) && !configGENERATE_RUN_TIME_STATS
+  // Загрузка своих задач по тактам Perf за интервал между отсчётами
+  void samplePerf(uint32_t dtMs) {
+    uint64_t capacity = (uint64_t)dtMs * 1000ULL * Perf::cpuMHz();   // тактов одного ядра
+
+    for (uint8_t k = 0; k < TASK_COUNT; ++k) {
+      Tracked& t = g_tasks[k];
+      if (t.busyStage == Perf::Stage::Count) continue;
+
+      uint64_t busy  = Perf::get(t.busyStage).sumCycles;
+      uint64_t dBusy = busy >= t.prevBusy ? busy - t.prevBusy : busy;  // после Perf::reset()
+      t.prevBusy = busy;
+
+      if (capacity == 0) continue;
+      uint64_t cp = dBusy * 10000ULL / capacity;
+      t.cpuCentiPct = (uint16_t)(cp > 10000 ? 10000 : cp);
+    }
+  }
+#endif
+
+  void pushHistory(uint32_t nowMs) {
+    Sample& s = g_hist[g_histHead];
+    s.tsMs = nowMs;
+    for (uint8_t k = 0; k < MAX_TASKS; ++k) {
+      if (k >= TASK_COUNT) {
+        s.cpuCentiPct[k]   = UNKNOWN;
+        s.stackFreeKb10[k] = UNKNOWN;
+        continue;
+      }
+      const Tracked& t = g_tasks[k];
+      s.cpuCentiPct[k]   = t.cpuCentiPct;
+      s.stackFreeKb10[k] = (t.stackFreeMin == UINT32_MAX) ? UNKNOWN
+                           : (uint16_t)(t.stackFreeMin * 10UL / 1024UL);
+    }
+    g_histHead = (g_histHead + 1) % HISTORY_SIZE;
+    if (g_histCount < HISTORY_SIZE) g_histCount++;
+  }
+
+} // namespace
+
+void TaskMonitor::begin() {
+  for (uint8_t k = 0; k < TASK_COUNT; ++k) {
+    Tracked& t = g_tasks[k];
+    t.handle       = nullptr;
+    t.stackFreeMin = UINT32_MAX;
+    t.cpuCentiPct  = UNKNOWN;
+    t.prevRun      = 0;
+    t.prevBusy     = (t.busyStage == Perf::Stage::Count) ? 0 : Perf::get(t.busyStage).sumCycles;
+  }
+  g_histHead     = 0;
+  g_histCount    = 0;
+  g_totalLoad    = UNKNOWN;
+  g_prevSampleMs = Clock::millis();
+}
+
+void TaskMonitor::sample() {
+  uint32_t now  = Clock::millis();
+  uint32_t dtMs = now - g_prevSampleMs;
+  g_prevSampleMs = now;
+
+  // Хэндлы ищем по имени при каждом отсчёте: задачи создаются позже begin()
+  for (uint8_t k = 0; k < TASK_COUNT; ++k) {
+    Tracked& t = g_tasks[k];
+    if (!t.handle) t.handle = xTaskGetHandle(t.name);
+    if (!t.handle) continue;
+
+    // На ESP32 StackType_t — байт, high-water mark уже в байтах
+    uint32_t freeBytes = (uint32_t)uxTaskGetStackHighWaterMark(t.handle) * sizeof(StackType_t);
+    if (freeBytes < t.stackFreeMin) t.stackFreeMin = freeBytes;
+  }
+
+#if !defined(YOTIK_HOST_BUILD) && configGENERATE_RUN_TIME_STATS
+  (void)dtMs;
+  sampleRuntime();
+#elif !defined(YOTIK_HOST_BUILD)
+  samplePerf(dtMs);
+#else
+  // хост: такты Perf настоящие, время симулированное — их доля ничего
+  // не значит, загрузка остаётся UNKNOWN
+  (void)dtMs;
+#endif
+
+  pushHistory(now);
+}
+
+bool TaskMonitor::runtimeStatsAvailable() {
+#if !defined(YOTIK_HOST_BUILD) && configGENERATE_RUN_TIME_STATS
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint8_t TaskMonitor::taskCount() {
+  return TASK_COUNT;
+}
+
+bool TaskMonitor::getTask(uint8_t index, TaskStat& out) {
+  if (index >= TASK_COUNT) return false;
+  const Tracked& t = g_tasks[index];
+  out.name         = t.name;
+  out.stackSize    = t.stackSize;
+  out.stackFreeMin = t.stackFreeMin;
+  out.cpuCentiPct  = t.cpuCentiPct;
+  out.found        = t.handle != nullptr;
+  return true;
+}
+
+uint16_t TaskMonitor::totalLoadCentiPct() {
+  return g_totalLoad;
+}
+
+uint8_t TaskMonitor::historyCount() {
+  return g_histCount;
+}
+
+bool TaskMonitor::getHistory(uint8_t index, Sample& out) {
+  if (index >= g_histCount) return false;
+  uint8_t pos = (g_histHead + HISTORY_SIZE - g_histCount + index) % HISTORY_SIZE;
+  out = g_hist[pos];
+  return true;
+}
@@ -0,0 +1,52 @@
+// === FILE: TaskMonitor.h ===
+#pragma once
+#include <Arduino.h>
+
+// Мониторинг задач FreeRTOS: минимальный запас стека (high-water mark)
+// и загрузка CPU по каждой задаче, с короткой историей отсчётов.
+//
+// Загрузка берётся из runtime-статистики FreeRTOS. Она есть, только если
+// ядро собрано с configGENERATE_RUN_TIME_STATS: в sdkconfig
+// CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS=y (вместе с таймером статистики,
+// CONFIG_FREERTOS_RUN_TIME_STATS_USING_ESP_TIMER), что требует своей
+// сборки ядра ESP-IDF/Arduino — готовые библиотеки Arduino-ESP32 идут
+// без неё. Без статистики загрузка своих задач считается по тактам Perf
+// (automationTask: этап Tick, sensorTask: Sensors), у чужих (loopTask,
+// async_tcp) и общая — UNKNOWN, в Web/Telegram это "n/a".
+// На хосте задач нет: стек неизвестен, загрузка тоже — время там
+// симулированное, доля тактов от него бессмысленна.
+namespace TaskMonitor {
+
+  constexpr uint8_t  MAX_TASKS     = 6;
+  constexpr uint8_t  HISTORY_SIZE  = 30;          // 30 × DIAG_PERIOD_MS = 5 минут
+  constexpr uint16_t UNKNOWN       = 0xFFFF;
+
+  struct TaskStat {
+    const char* name;
+    uint32_t    stackSize;       // байт; 0 — неизвестно
+    uint32_t    stackFreeMin;    // байт, минимум за всё время; UINT32_MAX — неизвестно
+    uint16_t    cpuCentiPct;     // за последний интервал, 0.01 % одного ядра; UNKNOWN — нет данных
+    bool        found;           // задача существует (хэндл найден)
+  };
+
+  struct Sample {
+    uint32_t tsMs;
+    uint16_t cpuCentiPct[MAX_TASKS];
+    uint16_t stackFreeKb10[MAX_TASKS];   // запас стека, десятые доли КБ; UNKNOWN — нет
+  };
+
+  void begin();
+  void sample();            // раз в DIAG_PERIOD_MS из automationTask
+
+  bool    runtimeStatsAvailable();
+  uint8_t taskCount();
+  bool    getTask(uint8_t index, TaskStat& out);
+
+  // Общая загрузка CPU (все ядра), 0.01 %; UNKNOWN без runtime-статистики.
+  // runtimeStatsAvailable() — собрано ли ядро с configGENERATE_RUN_TIME_STATS
+  uint16_t totalLoadCentiPct();
+
+  // index 0 — самый старый отсчёт
+  uint8_t historyCount();
+  bool    getHistory(uint8_t index, Sample& out);
+}
@@ -2,8 +2,17 @@
 #include "TelegramAsync.h"
 #include "Config.h"
 #include "Globals.h"
-#include "DeviceManager.h"
+#include "SensorBus.h"
 #include "Automation.h"
+#include "PumpGovernor.h"
+#include "SensorStats.h"
+#include "SensorHealth.h"
+#include "StateMachine.h"
+#include "CommandQueue.h"
+#include "TaskMonitor.h"
+#include "Clock.h"
+#include "CropProfiles.h"
+#include "Storage.h"
 
 #include <WiFiClientSecure.h>
 #include <UniversalTelegramBot.h>
@@ -17,6 +26,42 @@ namespace {
   unsigned long       lastCheckMs     = 0;
   const unsigned long BOT_INTERVAL_MS = 2000;
 
+  // Исходящие алерты: sendAlert() зовут из automationTask, а TLS-запрос
+  // может висеть секундами — поэтому только кладём в очередь, отправляет loop()
+  constexpr uint8_t  OUTBOX_SIZE = 8;
+  constexpr size_t   ALERT_LEN   = 192;
+
+  char         outbox[OUTBOX_SIZE][ALERT_LEN];
+  uint8_t      outboxHead    = 0;
+  uint8_t      outboxCount   = 0;
+  uint32_t     outboxDropped = 0;
+  portMUX_TYPE outboxMux     = portMUX_INITIALIZER_UNLOCKED;
+
+  bool popAlert(char* out) {
+    bool ok = false;
+    portENTER_CRITICAL(&outboxMux);
+    if (outboxCount > 0) {
+      uint8_t tail = (outboxHead + OUTBOX_SIZE - outboxCount) % OUTBOX_SIZE;
+      memcpy(out, outbox[tail], ALERT_LEN);
+      outboxCount--;
+      ok = true;
+    }
+    portEXIT_CRITICAL(&outboxMux);
+    return ok;
+  }
+
+  void flushOutbox() {
+    char text[ALERT_LEN];
+    while (popAlert(text)) {
+      bot->sendMessage(TelegramConfig::CHAT_ID, text, "");
+    }
+
+    if (outboxDropped) {
+      Serial.printf("[TG] outbox full, %u alert(s) dropped\n", (unsigned)outboxDropped);
+      outboxDropped = 0;
+    }
+  }
+
   // Текст кнопок (reply-клавиатура)
   const char* BTN_STATUS   = "🌡 Статус";
   const char* BTN_CONTROL  = "🎛 Управление";
@@ -42,31 +87,66 @@ namespace {
     return on ? "🟢 ВКЛ" : "⚪️ ВЫКЛ";
   }
 
-  String cropProfileToName(CropProfile p) {
-    switch (p) {
-      case CropProfile::Tomatoes:  return "🍅 Томаты";
-      case CropProfile::Cucumbers: return "🥒 Огурцы";
-      case CropProfile::Greens:    return "🥬 Зелень";
-      case CropProfile::Hibiscus:  return "🌺 Гибискус";
-      case CropProfile::Custom:
-      default:                     return "⚙️ Пользовательский";
+  // Задачи FreeRTOS: загрузка CPU и минимальный запас стека
+  void appendTaskStats(String& msg) {
+    msg += "\n🧵 *Задачи:*\n";
+
+    // без runtime-статистики FreeRTOS общей загрузки и загрузки чужих
+    // задач нет — "n/a", а не 0 %
+    uint16_t load = TaskMonitor::totalLoadCentiPct();
+    msg += "• CPU всего: ";
+    if (load != TaskMonitor::UNKNOWN) {
+      msg += String(load / 100.0f, 1);
+      msg += " %\n";
+    } else {
+      msg += "n/a\n";
+    }
+
+    for (uint8_t i = 0; i < TaskMonitor::taskCount(); ++i) {
+      TaskMonitor::TaskStat t;
+      if (!TaskMonitor::getTask(i, t) || !t.found) continue;
+
+      msg += "• ";
+      for (const char* p = t.name; *p; ++p) {
+        if (*p == '_') msg += '\\';   // Markdown
+        msg += *p;
+      }
+      msg += ": CPU ";
+      if (t.cpuCentiPct != TaskMonitor::UNKNOWN) {
+        msg += String(t.cpuCentiPct / 100.0f, 2);
+        msg += " %";
+      } else {
+        msg += "n/a";
+      }
+      if (t.stackFreeMin != UINT32_MAX) {
+        msg += ", стек свободно ";
+        msg += String((unsigned long)t.stackFreeMin);
+        if (t.stackSize) {
+          msg += "/";
+          msg += String((unsigned long)t.stackSize);
+        }
+        msg += " Б";
+      }
+      msg += "\n";
     }
   }
 
-  String cropProfileHint(CropProfile p) {
-    switch (p) {
-      case CropProfile::Tomatoes:
-        return "Томаты любят тёплый и более сухой воздух, почва — достаточно влажная.";
-      case CropProfile::Cucumbers:
-        return "Огурцы любят высокую влажность воздуха и более влажную почву.";
-      case CropProfile::Greens:
-        return "Листовая зелень чувствительна к перегреву, предпочитает умеренный климат.";
-      case CropProfile::Hibiscus:
-        return "Гибискус любит тепло и умеренную влажность, не терпит переохлаждения.";
-      case CropProfile::Custom:
-      default:
-        return "Настройки заданы вручную под вашу культуру.";
-    }
+  // Ручная команда уходит в очередь; выполнит её automationTask.
+  // false — очередь полна, команда отброшена
+  bool queueCommand(CommandQueue::Target target, CommandQueue::Action action) {
+    CommandQueue::Command cmd{};
+    cmd.target = target;
+    cmd.action = action;
+    cmd.source = CommandQueue::Source::Telegram;
+    cmd.tsMs   = Clock::millis();
+    cmd.holdMs = AutomationConfig::MANUAL_HOLD_MS;
+    return CommandQueue::push(cmd);
+  }
+
+  String activeProfileName() {
+    CropProfiles::Info info;
+    if (!CropProfiles::get(CropProfiles::activeId(), info)) return "—";
+    return info.name;
   }
 
   String formatStressBar(float totalStress) {
@@ -156,6 +236,8 @@ namespace {
   void sendStatus(const String& chatId) {
     if (!bot) return;
 
+    const SensorData s = SensorBus::snapshot();
+
     Automation::DiagInfo d = Automation::getDiagInfo();
 
     String msg;
@@ -163,13 +245,13 @@ namespace {
     msg  = "🌿 *Статус теплицы*\n\n";
 
     // Воздух
-    if (!isnan(g_sensors.airTemp)) {
+    if (!isnan(s.airTemp)) {
       msg += "🌡 *Воздух:* ";
-      msg += String(g_sensors.airTemp, 1);
+      msg += String(s.airTemp, 1);
       msg += " °C";
-      if (!isnan(g_sensors.airHum)) {
+      if (!isnan(s.airHum)) {
         msg += " / ";
-        msg += String(g_sensors.airHum, 0);
+        msg += String(s.airHum, 0);
         msg += " %";
       }
       msg += "\n";
@@ -178,22 +260,22 @@ namespace {
     }
 
     // Почва
-    if (!isnan(g_sensors.soilMoisture)) {
+    if (!isnan(s.soilMoisture)) {
       msg += "🌱 *Почва:* ";
-      msg += String(g_sensors.soilMoisture, 0);
+      msg += String(s.soilMoisture, 0);
       msg += " %";
-      if (!isnan(g_sensors.soilTemp)) {
+      if (!isnan(s.soilTemp)) {
         msg += " / ";
-        msg += String(g_sensors.soilTemp, 1);
+        msg += String(s.soilTemp, 1);
         msg += " °C";
       }
       msg += "\n";
     }
 
     // Свет
-    if (!isnan(g_sensors.lux)) {
+    if (!isnan(s.lux)) {
       msg += "💡 *Освещённость:* ";
-      msg += String(g_sensors.lux, 0);
+      msg += String(s.lux, 0);
       msg += " лк\n";
     }
 
@@ -202,15 +284,15 @@ namespace {
     // Устройства
     msg += "🔌 *Устройства:*\n";
     msg += "• Свет: ";
-    msg += onOffIcon(g_sensors.lightOn);
+    msg += onOffIcon(s.lightOn);
     msg += "\n";
 
     msg += "• Помпа: ";
-    msg += onOffIcon(g_sensors.pumpOn);
+    msg += onOffIcon(s.pumpOn);
     msg += "\n";
 
     msg += "• Вентилятор: ";
-    msg += onOffIcon(g_sensors.fanOn);
+    msg += onOffIcon(s.fanOn);
     msg += "\n";
 
     // Режим, профиль, стресс
@@ -219,7 +301,7 @@ namespace {
     msg += "\n";
 
     msg += "🌱 *Профиль:* ";
-    msg += cropProfileToName(g_settings.cropProfile);
+    msg += activeProfileName();
     msg += "\n";
 
     msg += "📊 *Стресс растений:* ";
@@ -230,7 +312,9 @@ namespace {
     bot->sendMessageWithReplyKeyboard(chatId, msg, "Markdown", kb, true);
   }
 
-  void sendControlMenu(const String& chatId) {
+  // s — состояние для показа: после кнопки команда ещё в очереди,
+  // поэтому показываем запрошенное (controlCommand), а не снимок
+  void sendControlMenu(const String& chatId, const SensorData& s) {
     if (!bot) return;
 
     String msg;
@@ -239,15 +323,15 @@ namespace {
     msg += "Состояние:\n";
 
     msg += "• Свет: ";
-    msg += onOffIcon(g_sensors.lightOn);
+    msg += onOffIcon(s.lightOn);
     msg += "\n";
 
     msg += "• Помпа: ";
-    msg += onOffIcon(g_sensors.pumpOn);
+    msg += onOffIcon(s.pumpOn);
     msg += "\n";
 
     msg += "• Вентилятор: ";
-    msg += onOffIcon(g_sensors.fanOn);
+    msg += onOffIcon(s.fanOn);
     msg += "\n\n";
 
     msg += "Нажимайте кнопки ниже для включения/выключения.\n";
@@ -256,9 +340,37 @@ namespace {
     bot->sendMessageWithReplyKeyboard(chatId, msg, "Markdown", kb, true);
   }
 
+  void sendControlMenu(const String& chatId) {
+    sendControlMenu(chatId, SensorBus::snapshot());
+  }
+
+  // Кнопка управления: команда в очередь, меню — с запрошенным состоянием
+  void controlCommand(const String& chatId, CommandQueue::Target target,
+                      CommandQueue::Action action) {
+    if (!bot) return;
+
+    SensorData s = SensorBus::snapshot();
+    if (!queueCommand(target, action)) {
+      bot->sendMessage(chatId, "Очередь команд переполнена, команда не выполнена. Попробуйте ещё раз.", "");
+    } else {
+      const bool toggle = action == CommandQueue::Action::Toggle;
+      const bool on     = action == CommandQueue::Action::On ||
+                          action == CommandQueue::Action::Pulse;
+      switch (target) {
+        case CommandQueue::Target::Light: s.lightOn = toggle ? !s.lightOn : on; break;
+        case CommandQueue::Target::Pump:  s.pumpOn  = toggle ? !s.pumpOn  : on; break;
+        case CommandQueue::Target::Fan:   s.fanOn   = toggle ? !s.fanOn   : on; break;
+        default: break;
+      }
+    }
+    sendControlMenu(chatId, s);
+  }
+
   void sendDiag(const String& chatId) {
     if (!bot) return;
 
+    const SensorData s = SensorBus::snapshot();
+
     Automation::DiagInfo d = Automation::getDiagInfo();
 
     String msg;
@@ -267,29 +379,59 @@ namespace {
 
     msg += "📡 *Датчики:*\n";
     msg += "• BME280 (t/влажн/давл): ";
-    msg += okIcon(g_sensors.bmeOk);
+    msg += okIcon(s.bmeOk);
     msg += "\n";
 
     msg += "• BH1750 (освещённость): ";
-    msg += okIcon(g_sensors.bhOk);
+    msg += okIcon(s.bhOk);
     msg += "\n";
 
     msg += "• Датчик почвы: ";
-    msg += okIcon(g_sensors.soilOk);
+    msg += okIcon(s.soilOk);
     msg += "\n";
 
     msg += "• RTC (часы): ";
-    msg += okIcon(g_sensors.rtcOk);
-    msg += "\n\n";
+    msg += okIcon(s.rtcOk);
+    msg += "\n";
+
+    // каналы, чьи отсчёты сейчас отбрасывает SensorHealth
+    uint32_t now = Clock::millis();
+    for (uint8_t c = 0; c < SensorHealth::CHANNELS; ++c) {
+      const SensorHealth::Channel ch = (SensorHealth::Channel)c;
+      SensorHealth::Status st = SensorHealth::status(ch, now);
+      if (!st.faults) continue;
+      msg += "• ⚠️ ";
+      msg += SensorStats::channelName(ch);
+      msg += ": ";
+      msg += SensorHealth::faultName(st.faults);
+      msg += ", отброшено ";
+      msg += String(st.rejected);
+      msg += "\n";
+    }
+    msg += "\n";
 
     msg += "🚿 *Насос:*\n";
     msg += "• Текущее состояние: ";
-    msg += onOffIcon(g_sensors.pumpOn);
+    msg += onOffIcon(s.pumpOn);
     msg += "\n";
 
-    msg += "• Блокировка safety: ";
-    msg += (d.pumpLocked ? "⚠️ включена" : "✅ нет");
-    msg += "\n\n";
+    msg += "• Блокировка: ";
+    if (d.pumpLocked) {
+      msg += (PumpGovernor::Lock)d.pumpLock == PumpGovernor::Lock::DayLimit
+               ? "⚠️ суточный лимит" : "⚠️ пауза после долгого запуска";
+      msg += ", ещё ~";
+      msg += String((d.pumpLockLeftMs + 59999UL) / 60000UL);
+      msg += " мин";
+    } else {
+      msg += "✅ нет";
+    }
+    msg += "\n";
+
+    msg += "• За сутки: ";
+    msg += String((d.pumpMsDay + 30000UL) / 60000UL);
+    msg += " из ";
+    msg += String(PumpConfig::MAX_DAY_MS / 60000UL);
+    msg += " мин\n\n";
 
     msg += "💡 *Свет и адаптация:*\n";
 
@@ -345,17 +487,44 @@ namespace {
     msg += formatStressBar(d.stressTotal);
     msg += "\n";
 
+    msg += "• За 1 ч / 24 ч: ";
+    msg += formatFloatOrDash(d.stressTotal1h, 1);
+    msg += " / ";
+    msg += formatFloatOrDash(d.stressTotal24h, 1);
+    msg += "\n";
+
+    appendTaskStats(msg);
+
     String kb = makeMainKeyboard();
     bot->sendMessageWithReplyKeyboard(chatId, msg, "Markdown", kb, true);
   }
 
+  // "• Воздух: 14.2 … ср. 18.5 … 24.1 °C" за скользящие сутки (SensorStats)
+  void appendDayRange(String& msg, const char* label,
+                      SensorStats::Channel ch, const char* unit, uint8_t digits) {
+    SensorStats::Summary st;
+    if (!SensorStats::get(ch, SensorStats::Window::Day, st)) return;
+    msg += "• ";
+    msg += label;
+    msg += ": ";
+    msg += String(st.min, (unsigned int)digits);
+    msg += " … ср. ";
+    msg += String(st.mean, (unsigned int)digits);
+    msg += " … ";
+    msg += String(st.max, (unsigned int)digits);
+    msg += unit;
+    msg += "\n";
+  }
+
   void sendHistory(const String& chatId) {
     if (!bot) return;
 
+    const SensorData s = SensorBus::snapshot();
+
     Automation::DiagInfo d = Automation::getDiagInfo();
 
     String msg;
-    msg.reserve(512);
+    msg.reserve(768);
     msg  = "📈 *История за ~24 часа*\n\n";
 
     msg += "💧 *Полив:*\n";
@@ -369,6 +538,14 @@ namespace {
       msg += " мин ";
       msg += String(sec);
       msg += " с\n";
+
+      // скважность по часам: столбик на час, старые слева
+      static const char* const BARS[] = { "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█" };
+      msg += "• По часам: `";
+      for (uint8_t pct : d.pumpDutyHourly) {
+        msg += pct > 0 ? BARS[pct * 8 / 101] : "·";
+      }
+      msg += "`\n";
     } else {
       msg += "• За последние 24ч насос не включался\n";
     }
@@ -387,24 +564,31 @@ namespace {
 
     msg += "\n🌡 *Климат:*\n";
 
+    const CropProfiles::Params& cp = CropProfiles::active();
     msg += "• Целевой диапазон по воздуху: ";
-    msg += String(g_settings.comfortTempMin, 1);
+    msg += String(cp.tempMin, 1);
     msg += "…";
-    msg += String(g_settings.comfortTempMax, 1);
+    msg += String(cp.tempMax, 1);
     msg += " °C, ";
-    msg += String(g_settings.comfortHumMin, 0);
+    msg += String(cp.humMin, 0);
     msg += "…";
-    msg += String(g_settings.comfortHumMax, 0);
+    msg += String(cp.humMax, 0);
     msg += " %\n";
 
-    if (!isnan(g_sensors.airTemp) && !isnan(g_sensors.airHum)) {
+    if (!isnan(s.airTemp) && !isnan(s.airHum)) {
       msg += "• Сейчас: ";
-      msg += String(g_sensors.airTemp, 1);
+      msg += String(s.airTemp, 1);
       msg += " °C / ";
-      msg += String(g_sensors.airHum, 0);
+      msg += String(s.airHum, 0);
       msg += " %\n";
     }
 
+    // мин … среднее … макс за сутки
+    appendDayRange(msg, "Воздух",    SensorStats::Channel::AirTemp,      " °C", 1);
+    appendDayRange(msg, "Влажность", SensorStats::Channel::AirHum,       " %",  0);
+    appendDayRange(msg, "Почва",     SensorStats::Channel::SoilMoisture, " %",  0);
+    appendDayRange(msg, "Почва t",   SensorStats::Channel::SoilTemp,     " °C", 1);
+
     msg += "\n💡 *Свет:*\n";
     if (d.dailyLuxIntegral > 0.01f) {
       float kLuxHours = d.dailyLuxIntegral / 1000.0f;
@@ -421,55 +605,63 @@ namespace {
     msg += formatFloatOrDash(d.dynamicLuxOff, 0);
     msg += " лк\n";
 
+    SensorStats::Summary lx;
+    if (SensorStats::get(SensorStats::Channel::Lux, SensorStats::Window::Day, lx)) {
+      msg += "• Максимум за сутки: ";
+      msg += String(lx.max, 0);
+      msg += " лк\n";
+    }
+
     String kb = makeMainKeyboard();
     bot->sendMessageWithReplyKeyboard(chatId, msg, "Markdown", kb, true);
   }
 
-  void sendProfile(const String& chatId) {
+  // id — выбранный профиль: после /profile_<id> выбор ещё в очереди
+  void sendProfile(const String& chatId, uint8_t id) {
     if (!bot) return;
 
-    CropProfile profile = g_settings.cropProfile;
-    String name  = cropProfileToName(profile);
-    String hint  = cropProfileHint(profile);
+    CropProfiles::Info info;
+    if (!CropProfiles::get(id, info)) return;
+    const CropProfiles::Params& p = info.params;
 
     String msg;
-    msg.reserve(512);
+    msg.reserve(768);
     msg  = "🌱 *Профиль культуры*\n\n";
 
     msg += "Текущий профиль: *";
-    msg += name;
+    msg += info.name;
     msg += "*\n";
 
-    msg += hint;
+    msg += info.hint;
     msg += "\n\n";
 
     msg += "🌡 *Воздух:*\n";
     msg += "• Комфортный диапазон: ";
-    msg += String(g_settings.comfortTempMin, 1);
+    msg += String(p.tempMin, 1);
     msg += "…";
-    msg += String(g_settings.comfortTempMax, 1);
+    msg += String(p.tempMax, 1);
     msg += " °C\n";
 
     msg += "• Влажность: ";
-    msg += String(g_settings.comfortHumMin, 0);
+    msg += String(p.humMin, 0);
     msg += "…";
-    msg += String(g_settings.comfortHumMax, 0);
+    msg += String(p.humMax, 0);
     msg += " %\n\n";
 
     msg += "🌱 *Почва:*\n";
     msg += "• Целевая влажность: ";
-    msg += String(g_settings.soilMoistureSetpoint);
+    msg += String(p.soilSetpoint);
     msg += " %\n";
 
     msg += "• Гистерезис: ±";
-    msg += String(g_settings.soilMoistureHyst);
+    msg += String(p.soilHyst);
     msg += " %\n\n";
 
     msg += "💧 *Полив:*\n";
     msg += "• Окно полива: ";
-    msg += String(g_settings.waterStartHour);
+    msg += String(p.waterStartHour);
     msg += ":00…";
-    msg += String(g_settings.waterEndHour);
+    msg += String(p.waterEndHour);
     msg += ":00\n\n";
 
     msg += "💡 *Свет:*\n";
@@ -477,12 +669,54 @@ namespace {
     msg += String(g_settings.nightCutoffHour);
     msg += ":00\n\n";
 
-    msg += "Изменение профиля сейчас делается через веб-интерфейс.";
+    // команды выбора; свои профили заводятся через веб-интерфейс (/api/profiles)
+    msg += "Сменить профиль:\n";
+    for (uint8_t id = 0; id < CropProfiles::ID_END; ++id) {
+      CropProfiles::Info o;
+      if (!CropProfiles::get(id, o)) continue;
+      msg += "• /profile\\_";
+      msg += String(id);
+      msg += " — ";
+      msg += o.name;
+      msg += "\n";
+    }
 
     String kb = makeMainKeyboard();
     bot->sendMessageWithReplyKeyboard(chatId, msg, "Markdown", kb, true);
   }
 
+  // /profile_<id> — выбрать профиль культуры
+  void selectProfile(const String& chatId, const String& text) {
+    String idStr = text.substring(strlen("/profile_"));
+    long   id    = idStr.toInt();
+    if (idStr.length() == 0 || id < 0 || id > 255 ||
+        (id == 0 && idStr != "0")) {
+      bot->sendMessage(chatId, "Не понял номер профиля.", "");
+      return;
+    }
+
+    CropProfiles::Info info;
+    if (!CropProfiles::get((uint8_t)id, info)) {
+      bot->sendMessage(chatId, "Такого профиля нет.", "");
+      return;
+    }
+
+    // выбор выполнит automationTask
+    if ((uint8_t)id != CropProfiles::activeId()) {
+      CommandQueue::Command cmd{};
+      cmd.target = CommandQueue::Target::Profile;
+      cmd.action = CommandQueue::Action::Set;
+      cmd.source = CommandQueue::Source::Telegram;
+      cmd.value  = (uint8_t)id;
+      cmd.tsMs   = Clock::millis();
+      if (!CommandQueue::push(cmd)) {
+        bot->sendMessage(chatId, "Очередь команд переполнена, попробуйте ещё раз.", "");
+        return;
+      }
+    }
+    sendProfile(chatId, (uint8_t)id);
+  }
+
   void sendHelp(const String& chatId) {
     if (!bot) return;
 
@@ -505,6 +739,7 @@ namespace {
     msg += "• /history — история за сутки\n";
     msg += "• /diag — диагностика\n";
     msg += "• /profile — профиль культуры\n";
+    msg += "• /profile\\_N — выбрать профиль N\n";
 
     String kb = makeMainKeyboard();
     bot->sendMessageWithReplyKeyboard(chatId, msg, "Markdown", kb, true);
@@ -535,7 +770,11 @@ namespace {
       return;
     }
     if (text == "/profile" || text == BTN_PROFILE) {
-      sendProfile(chatId);
+      sendProfile(chatId, CropProfiles::activeId());
+      return;
+    }
+    if (text.startsWith("/profile_")) {
+      selectProfile(chatId, text);
       return;
     }
     if (text == "/help" || text == BTN_HELP) {
@@ -551,27 +790,20 @@ namespace {
 
     // управление устройствами
     if (text == BTN_LIGHT) {
-      bool st = !g_sensors.lightOn;
-      DeviceManager::setLight(st);
-      Automation::registerManualLight();
-      sendControlMenu(chatId);
+      controlCommand(chatId, CommandQueue::Target::Light, CommandQueue::Action::Toggle);
       return;
     }
     if (text == BTN_PUMP) {
-      DeviceManager::setPump(true);
-      Automation::registerManualPump();
-      sendControlMenu(chatId);
+      controlCommand(chatId, CommandQueue::Target::Pump, CommandQueue::Action::Pulse);
       return;
     }
     if (text == BTN_FAN) {
-      bool st = !g_sensors.fanOn;
-      DeviceManager::setFan(st);
-      Automation::registerManualFan();
-      sendControlMenu(chatId);
+      controlCommand(chatId, CommandQueue::Target::Fan, CommandQueue::Action::Toggle);
       return;
     }
     if (text == BTN_AUTO) {
       g_settings.automationEnabled = !g_settings.automationEnabled;
+      StateMachine::notify(StateMachine::EVENT_SETTINGS);
       sendControlMenu(chatId);
       return;
     }
@@ -579,36 +811,31 @@ namespace {
     // старые команды для совместимости
     if (text == "/auto_on") {
       g_settings.automationEnabled = true;
+      StateMachine::notify(StateMachine::EVENT_SETTINGS);
       sendControlMenu(chatId);
       return;
     }
     if (text == "/auto_off") {
       g_settings.automationEnabled = false;
+      StateMachine::notify(StateMachine::EVENT_SETTINGS);
       sendControlMenu(chatId);
       return;
     }
     if (text == "/water") {
-      DeviceManager::setPump(true);
-      Automation::registerManualPump();
-      sendControlMenu(chatId);
+      controlCommand(chatId, CommandQueue::Target::Pump, CommandQueue::Action::Pulse);
       return;
     }
     if (text == "/light_toggle") {
-      bool st = !g_sensors.lightOn;
-      DeviceManager::setLight(st);
-      Automation::registerManualLight();
-      sendControlMenu(chatId);
+      controlCommand(chatId, CommandQueue::Target::Light, CommandQueue::Action::Toggle);
       return;
     }
     if (text == "/fan_toggle") {
-      bool st = !g_sensors.fanOn;
-      DeviceManager::setFan(st);
-      Automation::registerManualFan();
-      sendControlMenu(chatId);
+      controlCommand(chatId, CommandQueue::Target::Fan, CommandQueue::Action::Toggle);
       return;
     }
     if (text == "/auto_toggle") {
       g_settings.automationEnabled = !g_settings.automationEnabled;
+      StateMachine::notify(StateMachine::EVENT_SETTINGS);
       sendControlMenu(chatId);
       return;
     }
@@ -633,6 +860,8 @@ void TelegramAsync::begin() {
 void TelegramAsync::loop() {
   if (!bot) return;
 
+  flushOutbox();
+
   unsigned long now = millis();
   if (now - lastCheckMs < BOT_INTERVAL_MS) return;
   lastCheckMs = now;
@@ -666,5 +895,15 @@ void TelegramAsync::loop() {
 void TelegramAsync::sendAlert(const String& text) {
   if (!bot) return;
   if (strlen(TelegramConfig::CHAT_ID) == 0) return;
-  bot->sendMessage(TelegramConfig::CHAT_ID, text, "");
+
+  portENTER_CRITICAL(&outboxMux);
+  if (outboxCount < OUTBOX_SIZE) {
+    strncpy(outbox[outboxHead], text.c_str(), ALERT_LEN - 1);
+    outbox[outboxHead][ALERT_LEN - 1] = '\0';
+    outboxHead = (outboxHead + 1) % OUTBOX_SIZE;
+    outboxCount++;
+  } else {
+    outboxDropped++;
+  }
+  portEXIT_CRITICAL(&outboxMux);
 }
\ No newline at end of file
@@ -4,5 +4,6 @@
 namespace TelegramAsync {
   void begin();
   void loop();
+  // Не блокирует: алерт ставится в очередь, отправляется из loop()
   void sendAlert(const String& text);
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 // === FILE: TelemetryLogger.cpp ===
 #include "TelemetryLogger.h"
 #include "Globals.h"
+#include "SensorBus.h"
+#include "Clock.h"
+#include "Config.h"
 
 // Здесь намеренно используем собственную структуру, не завязанную
 // на Types.h::TelemetryPoint, чтобы не ломать другие модули.
@@ -18,7 +21,7 @@ namespace {
 
   // 288 точек по 5 минут = ровно сутки
   constexpr uint16_t MAX_POINTS       = 288;
-  constexpr uint32_t LOG_INTERVAL_MS  = 5UL * 60UL * 1000UL;
+  constexpr uint32_t LOG_INTERVAL_MS  = AutomationConfig::TELEMETRY_PERIOD_MS;
 
   TelemetrySample buf[MAX_POINTS];
   uint16_t head   = 0;
@@ -30,22 +33,27 @@ namespace {
 void TelemetryLogger::begin() {
   head      = 0;
   count     = 0;
-  lastLogMs = millis();
+  lastLogMs = Clock::millis();
 }
 
 void TelemetryLogger::loop() {
-  uint32_t now = millis();
+  uint32_t now = Clock::millis();
   if (now - lastLogMs < LOG_INTERVAL_MS) return;
-  lastLogMs = now;
+
+  // сетка без дрейфа: следующая точка ровно через LOG_INTERVAL_MS от предыдущей
+  lastLogMs += LOG_INTERVAL_MS;
+  if (now - lastLogMs >= LOG_INTERVAL_MS) lastLogMs = now;
+
+  const SensorData s = SensorBus::snapshot();
 
   TelemetrySample p{};
-  p.ts           = now / 1000;
-  p.airTemp      = g_sensors.airTemp;
-  p.airHum       = g_sensors.airHum;
-  p.soilMoisture = g_sensors.soilMoisture;
-  p.soilTemp     = g_sensors.soilTemp;
-  p.airPressure  = g_sensors.airPressure;
-  p.lux          = g_sensors.lux;
+  p.ts           = Clock::isWallValid() ? (uint32_t)Clock::now() : now / 1000;
+  p.airTemp      = s.airTemp;
+  p.airHum       = s.airHum;
+  p.soilMoisture = s.soilMoisture;
+  p.soilTemp     = s.soilTemp;
+  p.airPressure  = s.airPressure;
+  p.lux          = s.lux;
 
   buf[head] = p;
   head = (head + 1) % MAX_POINTS;
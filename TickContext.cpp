@@ -0,0 +1,51 @@
+// === FILE: TickContext.cpp ===
+#include "TickContext.h"
+#include "SensorBus.h"
+#include "SunPosition.h"
+#include "Clock.h"
+#include "Config.h"
+
+namespace {
+
+  // Локальный час действует на [g_hourFrom, g_hourTo). Переходы летнего
+  // времени происходят на границе часа, так что кэш их не пропускает.
+  time_t   g_hourFrom   = 0;
+  time_t   g_hourTo     = 0;
+  uint8_t  g_hour       = 0;
+
+  void refreshHour(time_t nowUtc) {
+    if (g_hourTo != 0 && nowUtc >= g_hourFrom && nowUtc < g_hourTo) return;
+
+    struct tm t;
+    localtime_r(&nowUtc, &t);
+    g_hour     = (uint8_t)t.tm_hour;
+    g_hourFrom = nowUtc - (t.tm_min * 60 + t.tm_sec);
+    g_hourTo   = g_hourFrom + 3600;
+  }
+
+} // namespace
+
+void Tick::build(uint32_t nowMs, TickContext& out) {
+  out.nowMs = nowMs;
+
+  out.wallUtc   = Clock::now();
+  out.wallValid = Clock::isWallValid();
+
+  if (out.wallValid) {
+    refreshHour(out.wallUtc);
+    out.localHour = g_hour;
+    out.sunAltDeg = SunPosition::altitudeAt(out.wallUtc);
+    out.daylight  = out.sunAltDeg > 0.0f;
+  } else {
+    // времени ещё нет (RTC/NTP не подняты) — считаем, что "ночь"
+    out.localHour = 0;
+    out.daylight  = false;
+    out.sunAltDeg = -90.0f;
+  }
+
+  out.sensors = SensorBus::snapshot();
+}
+
+void Tick::reset() {
+  g_hourFrom = g_hourTo = 0;
+}
@@ -0,0 +1,32 @@
+// === FILE: TickContext.h ===
+#pragma once
+#include <Arduino.h>
+#include <time.h>
+#include "Types.h"
+
+// Всё, что этапам тика нужно знать о "сейчас", считается один раз
+// в начале тика планировщика и передаётся в каждый этап по ссылке.
+// Этапы не вызывают Clock/TimeManager/SunPosition сами: в пределах
+// тика время, положение солнца и показания датчиков согласованы.
+struct TickContext {
+  uint32_t   nowMs;       // Clock::millis() на начало тика
+
+  time_t     wallUtc;     // Clock::now()
+  bool       wallValid;   // настенное время выставлено (NTP/RTC)
+  uint8_t    localHour;   // 0..23 по локальному TZ; 0, пока времени нет
+
+  bool       daylight;    // солнце над горизонтом; false, пока времени нет
+  float      sunAltDeg;   // высота солнца, градусы
+
+  SensorData sensors;     // SensorBus::snapshot()
+};
+
+namespace Tick {
+  // Собрать контекст на момент nowMs. Локальный час пересчитывается
+  // только при переходе через границу часа, высота солнца — чтение
+  // суточной таблицы SunPosition.
+  void build(uint32_t nowMs, TickContext& out);
+
+  // Сбросить кэши (после перевода часов, в начале прогона на хосте)
+  void reset();
+}
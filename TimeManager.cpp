@@ -1,6 +1,7 @@
 #include "TimeManager.h"
 #include "Config.h"
 #include "Globals.h"
+#include "Clock.h"
 #include <time.h>
 #include <Wire.h>
 #include <RTClib.h>
@@ -30,15 +31,19 @@ void TimeManager::syncTimeAsync() {
 
 bool TimeManager::isTimeValid() {
   struct tm timeinfo;
-  if (!getLocalTime(&timeinfo, 5)) {
+  if (!getLocalTimeSafe(timeinfo)) {
     return false;
   }
   return timeinfo.tm_year > (2016 - 1900);
 }
 
+// Локальное время от Clock::now(): TZ уже выставлен configTzTime(),
+// поэтому localtime_r() даёт то же, что getLocalTime(), но без ожидания
+// и от подменяемого источника (симуляция/реплей).
 bool TimeManager::getLocalTimeSafe(struct tm& out) {
-  if (!getLocalTime(&out, 5)) return false;
-  return true;
+  time_t now = Clock::now();
+  localtime_r(&now, &out);
+  return out.tm_year > (2016 - 1900);
 }
 
 uint8_t TimeManager::getHour() {
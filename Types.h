@@ -8,6 +8,9 @@ enum class ClimateMode : uint8_t {
   Aggressive = 2
 };
 
+// Встроенные профили культур; параметры — в таблице CropProfiles.
+// Пользовательские профили хранятся во flash и получают ID от
+// CropProfiles::USER_ID_BASE — в поле cropProfile лежит любой из них.
 enum class CropProfile : uint8_t {
   Custom = 0,
   Tomatoes,
@@ -16,6 +19,15 @@ enum class CropProfile : uint8_t {
   Hibiscus
 };
 
+// Исполнительные устройства, которыми управляют и автоматика, и правила
+enum class Actuator : uint8_t {
+  Light = 0,
+  Pump,
+  Fan,
+  Door,
+  Count
+};
+
 struct SensorData {
   // Воздух
   float airTemp      = NAN;
@@ -46,6 +58,10 @@ struct SensorData {
 
   // Производная по влажности почвы (как быстро сохнет)
   float soilDryingSlope     = NAN;  // %/час
+
+  // Кадр опроса датчиков (заполняет DeviceManager при публикации)
+  uint32_t sampleMs = 0;   // Clock::millis() момента опроса
+  uint32_t frameSeq = 0;   // номер кадра, 0 — ещё не было ни одного
 };
 
 // Алиас, если где-то используется другое имя
@@ -100,6 +116,28 @@ struct SystemSettings {
   char wifiPass[64]            = "";
 };
 
+// Пользовательский профиль культуры во flash (Storage), 26 байт
+struct UserCropProfile {
+  uint8_t id;              // 0 — слот свободен
+  char    name[15];
+  int16_t tempMinDeci;     // 0.1 °C
+  int16_t tempMaxDeci;
+  uint8_t humMin;          // %
+  uint8_t humMax;
+  uint8_t soilSetpoint;    // %
+  uint8_t soilHyst;
+  uint8_t waterStartHour;
+  uint8_t waterEndHour;
+};
+
+// Заголовок кольца PumpDuty во flash (Storage); корзины идут следом
+struct PumpDutyHeader {
+  uint32_t savedUtc;    // настенное время сохранения, 0 — не было известно
+  uint32_t headAgeMs;   // сколько уже шла текущая корзина
+  uint16_t head;        // индекс текущей корзины
+  uint16_t buckets;     // длина кольца (PumpDutyConfig::BUCKETS)
+};
+
 struct TelemetryPoint {
   uint32_t ts;           // UNIX time (сек)
   float    airTemp;      // °C
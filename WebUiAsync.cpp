@@ -2,12 +2,24 @@
 
 #include "WebUiAsync.h"
 #include "Globals.h"
+#include "SensorBus.h"
+#include "CommandQueue.h"
 #include "Config.h"
 #include "DeviceManager.h"
 #include "Automation.h"
 #include "TelemetryLogger.h"
 #include "SoilCalibration.h"
 #include "Storage.h"
+#include "Perf.h"
+#include "TaskMonitor.h"
+#include "SunPosition.h"
+#include "CropProfiles.h"
+#include "Rules.h"
+#include "PumpGovernor.h"
+#include "SensorStats.h"
+#include "SensorHealth.h"
+#include "Clock.h"
+#include "StateMachine.h"
 
 #include <WiFi.h>
 #include <AsyncTCP.h>
@@ -153,6 +165,17 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
     font-size:.85rem;
   }
   input[type=range]{width:100%;}
+  textarea{
+    width:100%;
+    min-height:160px;
+    padding:8px 10px;
+    border-radius:10px;
+    border:1px solid var(--border);
+    background:#020617;
+    color:var(--fg);
+    font-family:monospace;
+    font-size:.8rem;
+  }
   button{
     border:none;
     border-radius:999px;
@@ -319,7 +342,7 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
           </div>
           <div>
             <label>Профиль культуры</label>
-            <select id="cropProfile">
+            <select id="cropProfile" onchange="applyProfileUi()">
               <option value="1">Томаты</option>
               <option value="2">Огурцы</option>
               <option value="3">Зелень</option>
@@ -387,9 +410,16 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
     <div class="card">
       <h2>Диагностика автоматики</h2>
       <div class="status">
-        Насос за ~24 часа: <span id="diagPumpMinutes">0</span> мин
+        Насос за 24 часа: <span id="diagPumpMinutes">0</span> мин
         (<span id="diagPumpLocked">норма</span>)
       </div>
+      <div class="status">
+        Датчики: <span id="diagSensorHealth">—</span>
+      </div>
+      <label>Работа насоса по часам (старые слева), %</label>
+      <div class="status" style="font-family:monospace;letter-spacing:1px;">
+        <span id="diagPumpDuty" title="">—</span>
+      </div>
       <div class="row">
         <div>
           <label>Скорость высыхания почвы, %/ч</label>
@@ -449,12 +479,41 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
             <b><span id="diagStressTotal">0</span></b>
           </div>
         </div>
+        <div>
+          <label>Стресс, сглаженный (1 ч / 24 ч)</label>
+          <div class="status">
+            <span id="diagStress1h">0</span> /
+            <span id="diagStress24h">0</span>
+          </div>
+        </div>
       </div>
       <div style="margin-top:12px;">
         <button type="button" onclick="saveDiagLimits()">Сохранить пределы адаптации</button>
       </div>
     </div>
 
+    <!-- Правила -->
+    <div class="card">
+      <h2>Правила</h2>
+      <div class="status">
+        Одно правило на строку, например:
+        <code>if airTemp &gt; 30 and hour &gt;= 8 then fan on else fan off hyst 1 dwell 60</code>.
+        Устройства из правил встроенная автоматика не трогает.
+      </div>
+      <textarea id="rulesSource" spellcheck="false"></textarea>
+      <div class="status" id="rulesInfo">—</div>
+      <div style="margin-top:12px;">
+        <button type="button" onclick="saveRules()">Сохранить правила</button>
+      </div>
+    </div>
+
+    <!-- Солнце -->
+    <div class="card">
+      <h2>Солнце</h2>
+      <canvas id="sunCanvas" width="320" height="120" style="width:100%;"></canvas>
+      <div class="status" id="sunInfo">—</div>
+    </div>
+
     <!-- OTA -->
     <div class="card">
       <h2>OTA-обновление прошивки</h2>
@@ -591,8 +650,45 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
     if (b2El) el('lightColorBValue').textContent     = b2El.value;
   }
 
+  // Диапазоны климата/почвы/полива: у "своей настройки" (ID 0) — из
+  // настроек, у остальных профилей — из /api/profiles, только для чтения
+  const PROFILE_FIELDS = {
+    comfortTempMin:'tempMin', comfortTempMax:'tempMax',
+    comfortHumMin:'humMin',   comfortHumMax:'humMax',
+    soilMoistureSetpoint:'soilSetpoint', soilMoistureHyst:'soilHyst',
+    waterStartHour:'waterStartHour',     waterEndHour:'waterEndHour'
+  };
+  let profiles = [];
+  let customVals = {};
+
+  async function loadProfiles(){
+    try{
+      const r = await fetchJson('/api/profiles');
+      profiles = r.profiles;
+      const sel = el('cropProfile');
+      sel.innerHTML = '';
+      profiles.forEach(p=>{
+        const o = document.createElement('option');
+        o.value = p.id;
+        o.textContent = p.name + (p.builtin ? '' : ' (свой)');
+        sel.appendChild(o);
+      });
+    }catch(e){console.error(e);}
+  }
+
+  function applyProfileUi(){
+    const id = parseInt(el('cropProfile').value || '0',10);
+    const p  = profiles.find(x=>x.id===id);
+    for (const f in PROFILE_FIELDS){
+      const custom = (id === 0 || !p);
+      el(f).value    = custom ? customVals[f] : p[PROFILE_FIELDS[f]];
+      el(f).disabled = !custom;
+    }
+  }
+
   async function loadSettings(){
     try{
+      await loadProfiles();
       const s = await fetchJson('/api/settings');
       el('comfortTempMin').value       = s.comfortTempMin;
       el('comfortTempMax').value       = s.comfortTempMax;
@@ -606,6 +702,9 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
       el('cropProfile').value          = s.cropProfile;
       el('soilTempOffset').value       = s.soilTempOffset;
 
+      for (const f in PROFILE_FIELDS) customVals[f] = s[f];
+      applyProfileUi();
+
       el('lightBrightness').value      = s.lightBrightness;
       el('lightColorR').value          = s.lightColorR;
       el('lightColorG').value          = s.lightColorG;
@@ -646,6 +745,11 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
       wifiPass:             el('wifiPass') ? (el('wifiPass').value || '') : ''
     };
 
+    // у выбранного профиля поля только показаны — свои значения не трогаем
+    if (payload.cropProfile !== 0){
+      for (const f in PROFILE_FIELDS) delete payload[f];
+    }
+
     try{
       await fetch('/api/settings',{
         method:'POST',
@@ -677,9 +781,27 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
 
       const pumpMinutes = Math.round((d.pumpMsDay || 0) / 60000);
       el('diagPumpMinutes').textContent = pumpMinutes;
-      el('diagPumpLocked').textContent  = d.pumpLocked ? 'блокирован' : 'норма';
+      const lockNames = { 'cooldown': 'пауза после долгого запуска', 'day limit': 'суточный лимит' };
+      el('diagPumpLocked').textContent  = d.pumpLocked
+        ? (lockNames[d.pumpLock] || 'блокирован') + ', ещё ' + Math.ceil((d.pumpLockLeftMs || 0) / 60000) + ' мин'
+        : 'норма';
       el('diagPumpLocked').className    = d.pumpLocked ? 'status flag-bad' : 'status flag-ok';
 
+      // каналы с отбрасываемыми отсчётами; "норма", если таких нет
+      const faultNames = { 'range': 'вне диапазона', 'stuck': 'залип', 'mismatch': 'не согласуется', 'spike': 'выброс' };
+      const bad = Object.entries(d.sensorHealth || {})
+        .filter(([, h]) => h.fault !== 'ok')
+        .map(([name, h]) => name + ': ' + (faultNames[h.fault] || h.fault));
+      el('diagSensorHealth').textContent = bad.length ? bad.join(', ') : 'норма';
+      el('diagSensorHealth').className   = bad.length ? 'flag-bad' : 'flag-ok';
+
+      const duty = d.pumpDutyHourly || [];
+      const bars = '▁▂▃▄▅▆▇█';
+      el('diagPumpDuty').textContent = duty.length
+        ? duty.map(p => p > 0 ? bars[Math.min(7, Math.floor(p * 8 / 101))] : '·').join('')
+        : '—';
+      el('diagPumpDuty').title = duty.join(' ');
+
       el('diagDrySpeed').textContent =
         (d.avgDrySpeed === null || d.avgDrySpeed === undefined || isNaN(d.avgDrySpeed))
           ? '—' : d.avgDrySpeed.toFixed(2);
@@ -706,6 +828,8 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
       el('diagStressSoil').textContent   = d.stressSoil.toFixed(1);
       el('diagStressLight').textContent  = d.stressLight.toFixed(1);
       el('diagStressTotal').textContent  = d.stressTotal.toFixed(1);
+      el('diagStress1h').textContent     = d.stressTotal1h.toFixed(1);
+      el('diagStress24h').textContent    = d.stressTotal24h.toFixed(1);
 
     }catch(e){
       console.error(e);
@@ -735,12 +859,87 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
     }
   }
 
+  function showRulesInfo(r){
+    el('rulesInfo').textContent = 'Правил: ' + r.rules + ' · байткод ' + r.codeBytes
+      + ' Б · сработало ' + r.activeRules;
+    el('rulesInfo').className = 'status';
+  }
+
+  async function loadRules(){
+    try{
+      const r = await fetchJson('/api/rules');
+      el('rulesSource').value = r.source || '';
+      showRulesInfo(r);
+    }catch(e){
+      console.error(e);
+    }
+  }
+
+  async function saveRules(){
+    try{
+      const r = await fetch('/api/rules',{
+        method:'POST',
+        headers:{'Content-Type':'text/plain'},
+        body:el('rulesSource').value
+      });
+      const j = await r.json();
+      if (!r.ok){
+        el('rulesInfo').textContent = (j.line ? 'Строка ' + j.line + ': ' : '') + j.error;
+        el('rulesInfo').className = 'status flag-bad';
+        return;
+      }
+      j.activeRules = 0;
+      showRulesInfo(j);
+      el('top-status').textContent = 'Правила сохранены';
+      setTimeout(()=>{el('top-status').textContent='';},3000);
+    }catch(e){
+      console.error(e);
+      el('top-status').textContent = 'Ошибка сохранения правил';
+      setTimeout(()=>{el('top-status').textContent='';},3000);
+    }
+  }
+
+  function hhmm(min){
+    if(min === undefined) return '—';
+    const h = Math.floor(min/60), m = min%60;
+    return (h<10?'0':'')+h+':'+(m<10?'0':'')+m;
+  }
+
+  async function loadSun(){
+    try{
+      const s = await fetchJson('/api/sun');
+      const c = el('sunCanvas'), g = c.getContext('2d');
+      const w = c.width, h = c.height, n = s.altCentiDeg.length;
+      const top = Math.max(s.noonAltDeg, 10), y0 = h*0.7;
+      const y = a => y0 - (a/100)/top*(y0-4);
+
+      g.clearRect(0,0,w,h);
+      g.strokeStyle = '#555'; g.beginPath(); g.moveTo(0,y0); g.lineTo(w,y0); g.stroke();
+      g.strokeStyle = '#f5b942'; g.beginPath();
+      s.altCentiDeg.forEach((a,i)=>{ const x = i/(n-1)*w; i ? g.lineTo(x,y(a)) : g.moveTo(x,y(a)); });
+      g.stroke();
+      if(s.nowMin !== undefined){
+        const x = s.nowMin/1440*w;
+        g.strokeStyle = '#4aa3ff'; g.beginPath(); g.moveTo(x,0); g.lineTo(x,h); g.stroke();
+      }
+
+      el('sunInfo').textContent =
+        'Восход ' + hhmm(s.sunriseMin) + ' · полдень ' + hhmm(s.noonMin)
+        + ' (' + s.noonAltDeg.toFixed(1) + '°) · закат ' + hhmm(s.sunsetMin);
+    }catch(e){
+      console.error(e);
+    }
+  }
+
   async function init(){
     await loadSettings();
     await loadSensors();
     await loadDiag();
+    await loadSun();
+    await loadRules();
     setInterval(loadSensors, 3000);
     setInterval(loadDiag, 10000);
+    setInterval(loadSun, 300000);
   }
 
   document.addEventListener('DOMContentLoaded', init);
@@ -756,27 +955,32 @@ void handleRoot(AsyncWebServerRequest *request) {
 }
 
 void handleApiSensors(AsyncWebServerRequest *request) {
+  const SensorData s = SensorBus::snapshot();
+
   DynamicJsonDocument doc(1024);
 
   auto m   = doc.createNestedObject("metrics");
   auto fl  = doc.createNestedObject("flags");
   auto out = doc.createNestedObject("outputs");
 
-  m["airTemp"]      = g_sensors.airTemp;
-  m["airHum"]       = g_sensors.airHum;
-  m["soilMoisture"] = g_sensors.soilMoisture;
-  m["soilTemp"]     = g_sensors.soilTemp;
-  m["airPressure"]  = g_sensors.airPressure;
-  m["lux"]          = g_sensors.lux;
+  m["airTemp"]      = s.airTemp;
+  m["airHum"]       = s.airHum;
+  m["soilMoisture"] = s.soilMoisture;
+  m["soilTemp"]     = s.soilTemp;
+  m["airPressure"]  = s.airPressure;
+  m["lux"]          = s.lux;
 
-  fl["bmeOk"]   = g_sensors.bmeOk;
-  fl["bhOk"]    = g_sensors.bhOk;
-  fl["rtcOk"]   = g_sensors.rtcOk;
-  fl["soilOk"]  = g_sensors.soilOk;
+  fl["bmeOk"]   = s.bmeOk;
+  fl["bhOk"]    = s.bhOk;
+  fl["rtcOk"]   = s.rtcOk;
+  fl["soilOk"]  = s.soilOk;
 
-  out["lightOn"] = g_sensors.lightOn;
-  out["pumpOn"]  = g_sensors.pumpOn;
-  out["fanOn"]   = g_sensors.fanOn;
+  out["lightOn"] = s.lightOn;
+  out["pumpOn"]  = s.pumpOn;
+  out["fanOn"]   = s.fanOn;
+
+  doc["frameSeq"]    = s.frameSeq;
+  doc["sampleAgeMs"] = s.frameSeq ? Clock::millis() - s.sampleMs : 0;
 
   String outStr;
   serializeJson(doc, outStr);
@@ -868,12 +1072,177 @@ void handleApiSettingsPost(AsyncWebServerRequest *request, uint8_t *data, size_t
     g_settings.wifiPass[sizeof(g_settings.wifiPass)-1] = '\0';
   }
 
+  CropProfiles::refresh();
   Storage::saveSettings(g_settings);
   Automation::updateDynamicWaterWindow();
+  StateMachine::notify(StateMachine::EVENT_SETTINGS);
 
   request->send(200, "text/plain", "OK");
 }
 
+// --- Профили культур ---
+
+void profileToJson(JsonObject o, const CropProfiles::Info& info) {
+  const CropProfiles::Params& p = info.params;
+  o["id"]             = info.id;
+  o["name"]           = info.name;
+  o["builtin"]        = info.builtin;
+  o["tempMin"]        = p.tempMin;
+  o["tempMax"]        = p.tempMax;
+  o["humMin"]         = p.humMin;
+  o["humMax"]         = p.humMax;
+  o["soilSetpoint"]   = p.soilSetpoint;
+  o["soilHyst"]       = p.soilHyst;
+  o["waterStartHour"] = p.waterStartHour;
+  o["waterEndHour"]   = p.waterEndHour;
+}
+
+void handleApiProfilesGet(AsyncWebServerRequest *request) {
+  DynamicJsonDocument doc(4096);
+  doc["active"] = CropProfiles::activeId();
+
+  JsonArray arr = doc.createNestedArray("profiles");
+  for (uint8_t id = 0; id < CropProfiles::ID_END; ++id) {
+    CropProfiles::Info info;
+    if (!CropProfiles::get(id, info)) continue;
+    profileToJson(arr.createNestedObject(), info);
+  }
+
+  String out;
+  serializeJson(doc, out);
+  request->send(200, "application/json", out);
+}
+
+// Профиль выбирает automationTask (CommandQueue): g_settings и действующие
+// диапазоны читает автоматика. false — очередь полна.
+bool queueProfile(uint8_t id) {
+  CommandQueue::Command cmd{};
+  cmd.target = CommandQueue::Target::Profile;
+  cmd.action = CommandQueue::Action::Set;
+  cmd.source = CommandQueue::Source::WebUi;
+  cmd.value  = id;
+  cmd.tsMs   = Clock::millis();
+  return CommandQueue::push(cmd);
+}
+
+// Байтовое поле из JSON: целое 0..255; нет поля — def, иначе -1.
+// as<uint8_t>() и "| 0" в uint8_t заворачивают 272 в 16.
+int byteFrom(const JsonDocument& doc, const char* key, int def) {
+  JsonVariantConst v = doc[key];
+  if (v.isNull()) return def;
+  if (!v.is<long>()) return -1;
+  long x = v.as<long>();
+  return (x >= 0 && x <= 255) ? (int)x : -1;
+}
+
+// ID профиля из JSON: целое 0..255, иначе -1
+int profileIdFrom(const JsonDocument& doc) {
+  return byteFrom(doc, "id", -1);
+}
+
+// Завести/изменить пользовательский профиль: {id?, name, tempMin, ...}
+void handleApiProfilesPost(AsyncWebServerRequest *request, uint8_t *data, size_t len,
+                           size_t index, size_t total) {
+  (void)index;
+  (void)total;
+
+  StaticJsonDocument<512> doc;
+  if (deserializeJson(doc, data, len)) {
+    request->send(400, "text/plain", "Bad JSON");
+    return;
+  }
+
+  // целые поля проверяем до сужения в uint8_t, остальное — valid()
+  const int reqId = byteFrom(doc, "id", 0);
+  const int sp    = byteFrom(doc, "soilSetpoint", 0);
+  const int hyst  = byteFrom(doc, "soilHyst", 0);
+  const int from  = byteFrom(doc, "waterStartHour", 0);
+  const int to    = byteFrom(doc, "waterEndHour", 0);
+  if (reqId < 0 || sp < 0 || hyst < 0 || from < 0 || to < 0) {
+    request->send(400, "text/plain", "Invalid profile or no free slot");
+    return;
+  }
+
+  CropProfiles::Params p;
+  p.tempMin        = doc["tempMin"] | NAN;
+  p.tempMax        = doc["tempMax"] | NAN;
+  p.humMin         = doc["humMin"]  | NAN;
+  p.humMax         = doc["humMax"]  | NAN;
+  p.soilSetpoint   = (uint8_t)sp;
+  p.soilHyst       = (uint8_t)hyst;
+  p.waterStartHour = (uint8_t)from;
+  p.waterEndHour   = (uint8_t)to;
+
+  uint8_t id = CropProfiles::saveUser((uint8_t)reqId, doc["name"] | "", p);
+  if (id == 0) {
+    request->send(400, "text/plain", "Invalid profile or no free slot");
+    return;
+  }
+  // правили действующий профиль — автоматика перечитает диапазоны
+  if (id == CropProfiles::activeId() && !queueProfile(id)) {
+    request->send(503, "text/plain", "Saved, but command queue full");
+    return;
+  }
+
+  StaticJsonDocument<64> resp;
+  resp["id"] = id;
+  String out;
+  serializeJson(resp, out);
+  request->send(200, "application/json", out);
+}
+
+// Выбор профиля: {id}
+void handleApiProfileSelect(AsyncWebServerRequest *request, uint8_t *data, size_t len,
+                            size_t index, size_t total) {
+  (void)index;
+  (void)total;
+
+  StaticJsonDocument<64> doc;
+  if (deserializeJson(doc, data, len) || !doc.containsKey("id")) {
+    request->send(400, "text/plain", "Bad JSON");
+    return;
+  }
+
+  int id = profileIdFrom(doc);
+  CropProfiles::Info info;
+  if (id < 0 || !CropProfiles::get((uint8_t)id, info)) {
+    request->send(404, "text/plain", "No such profile");
+    return;
+  }
+  // меняется только ID профиля в настройках, диапазоны в g_settings не трогаем
+  if (id != CropProfiles::activeId() && !queueProfile((uint8_t)id)) {
+    request->send(503, "text/plain", "Command queue full");
+    return;
+  }
+  request->send(200, "text/plain", "OK");
+}
+
+// Удаление пользовательского профиля: {id}
+void handleApiProfileDelete(AsyncWebServerRequest *request, uint8_t *data, size_t len,
+                            size_t index, size_t total) {
+  (void)index;
+  (void)total;
+
+  StaticJsonDocument<64> doc;
+  if (deserializeJson(doc, data, len) || !doc.containsKey("id")) {
+    request->send(400, "text/plain", "Bad JSON");
+    return;
+  }
+
+  int id = profileIdFrom(doc);
+  if (id < 0 || !CropProfiles::removeUser((uint8_t)id)) {
+    request->send(404, "text/plain", "No such user profile");
+    return;
+  }
+  // удалили действующий — автоматика переходит на свою настройку
+  if (id == CropProfiles::activeId() &&
+      !queueProfile(CropProfiles::CUSTOM_ID)) {
+    request->send(503, "text/plain", "Removed, but command queue full");
+    return;
+  }
+  request->send(200, "text/plain", "OK");
+}
+
 void handleApiControl(AsyncWebServerRequest *request, uint8_t *data, size_t len,
                       size_t index, size_t total) {
   (void)index;
@@ -889,37 +1258,46 @@ void handleApiControl(AsyncWebServerRequest *request, uint8_t *data, size_t len,
   String target = doc["target"] | "";
   String action = doc["action"] | "";
 
+  // Команда только ставится в очередь — выполнит её automationTask
+  CommandQueue::Command cmd{};
+  cmd.source = CommandQueue::Source::WebUi;
+  cmd.tsMs   = Clock::millis();
+  cmd.holdMs = doc["holdMs"] | AutomationConfig::MANUAL_HOLD_MS;
+
+  bool known = true;
   if (target == "light") {
-    if (action == "toggle") {
-      DeviceManager::setLight(!g_sensors.lightOn);
-      Automation::registerManualLight();
-    }
+    cmd.target = CommandQueue::Target::Light;
+    known = (action == "toggle");
+    cmd.action = CommandQueue::Action::Toggle;
   } else if (target == "pump") {
-    if (action == "toggle") {
-      DeviceManager::setPump(!g_sensors.pumpOn);
-      Automation::registerManualPump();
-    } else if (action == "pulse") {
-      DeviceManager::setPump(true);
-      Automation::registerManualPump();
-    }
+    cmd.target = CommandQueue::Target::Pump;
+    if (action == "toggle")     cmd.action = CommandQueue::Action::Toggle;
+    else if (action == "pulse") cmd.action = CommandQueue::Action::Pulse;
+    else known = false;
   } else if (target == "fan") {
-    if (action == "toggle") {
-      DeviceManager::setFan(!g_sensors.fanOn);
-      Automation::registerManualFan();
-    }
+    cmd.target = CommandQueue::Target::Fan;
+    known = (action == "toggle");
+    cmd.action = CommandQueue::Action::Toggle;
   } else if (target == "door") {
-    if (action == "open") {
-      DeviceManager::setDoorAngle(100);
-      Automation::registerManualDoor();
-    } else if (action == "close") {
-      DeviceManager::setDoorAngle(0);
-      Automation::registerManualDoor();
-    }
+    cmd.target = CommandQueue::Target::Door;
+    if (action == "open")       cmd.action = CommandQueue::Action::On;
+    else if (action == "close") cmd.action = CommandQueue::Action::Off;
+    else known = false;
   } else {
     request->send(400, "text/plain", "Unknown target");
     return;
   }
 
+  if (!known) {
+    request->send(400, "text/plain", "Unknown action");
+    return;
+  }
+
+  if (!CommandQueue::push(cmd)) {
+    request->send(503, "text/plain", "Command queue full");
+    return;
+  }
+
   request->send(200, "text/plain", "OK");
 }
 
@@ -942,10 +1320,16 @@ void handleApiSoilCalibration(AsyncWebServerRequest *request) {
 
 void handleApiDiagGet(AsyncWebServerRequest *request) {
   Automation::DiagInfo info = Automation::getDiagInfo();
-  DynamicJsonDocument doc(512);
+  DynamicJsonDocument doc(1536 + 160 * ZoneConfig::MAX_ZONES);
 
   doc["pumpMsDay"]          = info.pumpMsDay;
   doc["pumpLocked"]         = info.pumpLocked;
+  doc["pumpLock"]           = PumpGovernor::lockName((PumpGovernor::Lock)info.pumpLock);
+  doc["pumpLockLeftMs"]     = info.pumpLockLeftMs;
+
+  // скважность насоса по часам, старые первыми
+  JsonArray duty = doc.createNestedArray("pumpDutyHourly");
+  for (uint8_t pct : info.pumpDutyHourly) duty.add(pct);
 
   doc["soilSetpointOffset"] = info.soilSetpointOffset;
   doc["soilAdaptMin"]       = info.soilAdaptMin;
@@ -968,6 +1352,36 @@ void handleApiDiagGet(AsyncWebServerRequest *request) {
   doc["stressSoil"]         = info.stressSoil;
   doc["stressLight"]        = info.stressLight;
   doc["stressTotal"]        = info.stressTotal;
+  doc["stressTotal1h"]      = info.stressTotal1h;
+  doc["stressTotal24h"]     = info.stressTotal24h;
+  doc["ventDemand"]         = info.ventDemand;
+
+  // достоверность каналов датчиков: {"airTemp": {fault, rejected, events}, ...}
+  JsonObject health = doc.createNestedObject("sensorHealth");
+  uint32_t now = Clock::millis();
+  for (uint8_t c = 0; c < SensorHealth::CHANNELS; ++c) {
+    const SensorHealth::Channel ch = (SensorHealth::Channel)c;
+    SensorHealth::Status st = SensorHealth::status(ch, now);
+    JsonObject o = health.createNestedObject(SensorStats::channelName(ch));
+    o["fault"]    = SensorHealth::faultName(st.faults);
+    o["badForMs"] = st.badForMs;
+    o["rejected"] = st.rejected;
+    o["events"]   = st.events;
+  }
+
+  // грядки: зона 0 продублирована полями выше
+  JsonArray zones = doc.createNestedArray("zones");
+  for (uint8_t z = 0; z < Automation::zoneCount(); ++z) {
+    Automation::ZoneInfo zi;
+    if (!Automation::getZoneInfo(z, zi)) break;
+    JsonObject o = zones.createNestedObject();
+    o["soil"]        = zi.soilMoisture;
+    o["offset"]      = zi.soilSetpointOffset;
+    o["drySpeed"]    = zi.avgDrySpeed;
+    o["deltaPerRun"] = zi.avgDeltaMoisture;
+    o["stress"]      = zi.stressSoil;
+    o["watering"]    = zi.watering;
+  }
 
   String out;
   serializeJson(doc, out);
@@ -996,6 +1410,285 @@ void handleApiDiagLimitsPost(AsyncWebServerRequest *request,
   request->send(200, "text/plain", "OK");
 }
 
+// --- Профиль цикла автоматики ---
+
+void handleApiPerfGet(AsyncWebServerRequest *request) {
+  if (request->hasParam("reset")) {
+    Perf::reset();
+  }
+
+  DynamicJsonDocument doc(4096);
+  uint32_t mhz = Perf::cpuMHz();
+
+  doc["cpuMHz"]       = mhz;
+  doc["tickBudgetUs"] = AutomationConfig::TICK_BUDGET_US;
+
+  // перегрузка: тики дольше бюджета и отложенные низкоприоритетные этапы
+  StateMachine::SchedStats ss = StateMachine::getSchedStats();
+  JsonObject so = doc.createNestedObject("sched");
+  so["ticks"]      = ss.ticks;
+  so["overruns"]   = ss.overruns;
+  so["shedTicks"]  = ss.shedTicks;
+  so["maxTickUs"]  = ss.maxTickUs;
+  so["overloaded"] = ss.overloaded;
+
+  // пробуждения по событиям (ручные команды, датчики, настройки)
+  StateMachine::EventStats ev = StateMachine::getEventStats();
+  JsonObject evo = doc.createNestedObject("events");
+  evo["wakeups"]       = ev.wakeups;
+  evo["lastLatencyUs"] = ev.lastLatencyUs;
+  evo["maxLatencyUs"]  = ev.maxLatencyUs;
+
+  // seqlock g_sensors: записей и повторов чтения из-за пересечения с записью
+  JsonObject sb = doc.createNestedObject("sensorBus");
+  sb["version"]     = SensorBus::version();
+  sb["readRetries"] = SensorBus::readRetries();
+
+  // очередь ручных команд (Web UI / Telegram → automationTask)
+  CommandQueue::Stats cq = CommandQueue::getStats();
+  JsonObject cqo = doc.createNestedObject("commands");
+  cqo["pushed"]       = cq.pushed;
+  cqo["dropped"]      = cq.dropped;
+  cqo["applied"]      = cq.applied;
+  cqo["maxLatencyMs"] = cq.maxLatencyMs;
+
+  // исполнители: запросы set*() против реальных переключений железа
+  DeviceManager::OutputStats os = DeviceManager::getOutputStats();
+  JsonObject oo = doc.createNestedObject("outputs");
+  oo["requests"]     = os.requests;
+  oo["commits"]      = os.commits;
+  oo["light"]        = os.light;
+  oo["pump"]         = os.pump;
+  oo["fan"]          = os.fan;
+  oo["fanDuty"]      = os.fanDuty;
+  oo["door"]         = os.door;
+  oo["valves"]       = os.valves;
+  oo["ledRefreshes"] = os.ledRefreshes;
+
+  JsonArray stages = doc.createNestedArray("stages");
+  for (uint8_t i = 0; i < Perf::STAGE_COUNT; ++i) {
+    Perf::Stage st = (Perf::Stage)i;
+    Perf::StageStats s = Perf::get(st);
+
+    JsonObject o = stages.createNestedObject();
+    o["name"]  = Perf::stageName(st);
+    o["count"] = s.count;
+    o["minUs"] = (float)s.minCycles / mhz;
+    o["avgUs"] = s.count ? (float)((double)s.sumCycles / s.count / mhz) : 0.0f;
+    o["maxUs"] = (float)s.maxCycles / mhz;
+
+    StateMachine::StageInfo si;
+    if (StateMachine::getStageInfo(i, si)) {
+      o["periodMs"]       = si.periodMs;
+      o["deadlineMs"]     = si.deadlineMs;
+      o["deadlineMisses"] = si.deadlineMisses;
+      o["skippedPeriods"] = si.skippedPeriods;
+      o["deferrals"]      = si.deferrals;
+      o["priority"]       = si.critical ? "critical" : (si.deferrable ? "deferrable" : "control");
+    }
+
+    // hist[b] — число вызовов длительностью [2^b, 2^(b+1)) мкс
+    JsonArray h = o.createNestedArray("hist");
+    for (uint8_t b = 0; b < Perf::HIST_BUCKETS; ++b) {
+      h.add(s.hist[b]);
+    }
+  }
+
+  String out;
+  serializeJson(doc, out);
+  request->send(200, "application/json", out);
+}
+
+// --- Задачи FreeRTOS: стек и загрузка ---
+
+void handleApiTasksGet(AsyncWebServerRequest *request) {
+  DynamicJsonDocument doc(6144);
+
+  // cpuSource: "freertos" — runtime-статистика ядра, "perf" — оценка по
+  // тактам своих этапов, "n/a" — загрузки нет; cpuPct без данных — null
+  bool runtime = TaskMonitor::runtimeStatsAvailable();
+  doc["runtimeStats"] = runtime;
+  doc["cpuSource"]    = runtime ? "freertos" : "perf";
+  uint16_t load = TaskMonitor::totalLoadCentiPct();
+  if (load != TaskMonitor::UNKNOWN) doc["cpuLoadPct"] = load / 100.0f;
+  else                              doc["cpuLoadPct"] = nullptr;
+
+  JsonArray tasks = doc.createNestedArray("tasks");
+  for (uint8_t i = 0; i < TaskMonitor::taskCount(); ++i) {
+    TaskMonitor::TaskStat t;
+    if (!TaskMonitor::getTask(i, t)) continue;
+
+    JsonObject o = tasks.createNestedObject();
+    o["name"]  = t.name;
+    o["found"] = t.found;
+    if (t.stackSize)                     o["stackSize"]    = t.stackSize;
+    if (t.stackFreeMin != UINT32_MAX)    o["stackFreeMin"] = t.stackFreeMin;
+    if (t.cpuCentiPct != TaskMonitor::UNKNOWN) o["cpuPct"] = t.cpuCentiPct / 100.0f;
+    else                                       o["cpuPct"] = nullptr;
+  }
+
+  // история: по строке на отсчёт, значения в порядке tasks; null — нет данных
+  JsonArray hist = doc.createNestedArray("history");
+  for (uint8_t i = 0; i < TaskMonitor::historyCount(); ++i) {
+    TaskMonitor::Sample s;
+    if (!TaskMonitor::getHistory(i, s)) continue;
+
+    JsonObject o = hist.createNestedObject();
+    o["tsMs"] = s.tsMs;
+    JsonArray cpu = o.createNestedArray("cpuPct");
+    JsonArray stk = o.createNestedArray("stackFreeKb");
+    for (uint8_t k = 0; k < TaskMonitor::taskCount(); ++k) {
+      if (s.cpuCentiPct[k] != TaskMonitor::UNKNOWN) cpu.add(s.cpuCentiPct[k] / 100.0f);
+      else                                          cpu.add(nullptr);
+      if (s.stackFreeKb10[k] != TaskMonitor::UNKNOWN) stk.add(s.stackFreeKb10[k] / 10.0f);
+      else                                            stk.add(nullptr);
+    }
+  }
+
+  String out;
+  serializeJson(doc, out);
+  request->send(200, "application/json", out);
+}
+
+// --- Статистика каналов датчиков за 1 ч / 24 ч / 7 суток ---
+
+void handleApiStatsGet(AsyncWebServerRequest *request) {
+  DynamicJsonDocument doc(4096);
+  doc["uptimeMs"] = Clock::millis();
+
+  // {"airTemp": {"1h": {n, mean, sd, min, max, ewma}, ...}, ...};
+  // окна без отсчётов пропускаются
+  JsonObject ch = doc.createNestedObject("channels");
+  for (uint8_t c = 0; c < SensorStats::CHANNELS; ++c) {
+    JsonObject co = ch.createNestedObject(SensorStats::channelName((SensorStats::Channel)c));
+    for (uint8_t w = 0; w < SensorStats::WINDOWS; ++w) {
+      SensorStats::Summary st;
+      if (!SensorStats::get((SensorStats::Channel)c, (SensorStats::Window)w, st)) continue;
+
+      JsonObject o = co.createNestedObject(SensorStats::windowName((SensorStats::Window)w));
+      o["n"]    = st.n;
+      o["mean"] = st.mean;
+      o["sd"]   = st.stddev;
+      o["min"]  = st.min;
+      o["max"]  = st.max;
+      o["ewma"] = st.ewma;
+    }
+  }
+
+  String out;
+  serializeJson(doc, out);
+  request->send(200, "application/json", out);
+}
+
+// --- Суточная таблица солнца (кривая высоты для графика) ---
+
+void handleApiSunGet(AsyncWebServerRequest *request) {
+  // обработчики AsyncTCP выполняются в одной задаче — буфер можно держать статическим
+  static SunPosition::DayTable t;
+  if (!SunPosition::getTable(t)) {
+    request->send(503, "text/plain", "Sun table not ready");
+    return;
+  }
+
+  DynamicJsonDocument doc(12288);
+  doc["dayStartUtc"] = (uint32_t)t.dayStartUtc;
+  doc["stepMin"]     = SunPosition::TABLE_STEP_MIN;
+  doc["builds"]      = SunPosition::tableBuilds();
+  if (t.sunriseMin != SunPosition::NO_EVENT) doc["sunriseMin"] = t.sunriseMin;
+  if (t.sunsetMin  != SunPosition::NO_EVENT) doc["sunsetMin"]  = t.sunsetMin;
+  doc["noonMin"]     = t.noonMin;
+  doc["noonAltDeg"]  = t.noonAltCentiDeg / 100.0f;
+
+  time_t now = Clock::now();
+  if (now >= t.dayStartUtc && now < t.dayStartUtc + 86400) {
+    doc["nowMin"] = (uint32_t)(now - t.dayStartUtc) / 60;
+  }
+
+  // точки с шагом stepMin от локальной полуночи, 00:00..24:00, в сотых градуса
+  JsonArray alt = doc.createNestedArray("altCentiDeg");
+  JsonArray az  = doc.createNestedArray("azCentiDeg");
+  for (uint16_t i = 0; i < SunPosition::TABLE_POINTS; ++i) {
+    alt.add(t.altCentiDeg[i]);
+    az.add(t.azCentiDeg[i]);
+  }
+
+  String out;
+  serializeJson(doc, out);
+  request->send(200, "application/json", out);
+}
+
+// --- Правила ---
+
+void handleApiRulesGet(AsyncWebServerRequest *request) {
+  String src;
+  Storage::loadRules(src);
+  Rules::Status st = Rules::status();
+
+  DynamicJsonDocument doc(src.length() + 256);
+  doc["source"]      = src.c_str();
+  doc["rules"]       = st.rules;
+  doc["codeBytes"]   = st.codeBytes;
+  doc["activeRules"] = st.activeRules;
+  doc["evals"]       = st.evals;
+  doc["switches"]    = st.switches;
+  doc["pending"]     = st.pending;
+
+  String out;
+  serializeJson(doc, out);
+  request->send(200, "application/json", out);
+}
+
+// Установить программу и ответить: 200 с размером, 400 с ошибкой
+void installRules(AsyncWebServerRequest *request, const char* src, size_t len) {
+  Rules::CompileResult res;
+  bool ok = Rules::install(src, len, true, res);
+
+  StaticJsonDocument<192> doc;
+  if (ok) {
+    doc["rules"]     = res.rules;
+    doc["codeBytes"] = res.codeBytes;
+    StateMachine::notify(StateMachine::EVENT_SETTINGS);
+  } else {
+    if (res.line) doc["line"] = res.line;
+    doc["error"] = res.error;
+  }
+
+  String out;
+  serializeJson(doc, out);
+  request->send(ok ? 200 : 400, "application/json", out);
+}
+
+// Пустое тело обработчик кусков не получает вовсе — это "удалить все
+// правила"; непустое уже получило ответ в handleApiRulesPost
+void handleApiRulesRequest(AsyncWebServerRequest *request) {
+  if (request->contentLength() == 0) installRules(request, "", 0);
+}
+
+// Текст правил (text/plain) приходит кусками: собираем во временный
+// буфер запроса, компилируем на последнем куске
+void handleApiRulesPost(AsyncWebServerRequest *request, uint8_t *data, size_t len,
+                        size_t index, size_t total) {
+  if (total > RulesConfig::SOURCE_MAX) {
+    if (index == 0) request->send(413, "text/plain", "Rules too large");
+    return;
+  }
+  if (index == 0) {
+    request->_tempObject = malloc(total + 1);
+    if (!request->_tempObject) {
+      request->send(500, "text/plain", "Out of memory");
+      return;
+    }
+  }
+  if (!request->_tempObject) return;
+
+  char* buf = (char*)request->_tempObject;
+  memcpy(buf + index, data, len);
+  if (index + len < total) return;
+  buf[total] = '\0';
+
+  installRules(request, buf, total);
+}
+
 // -------- OTA /update --------
 
 void setupOtaRoutes() {
@@ -1068,11 +1761,32 @@ void WebUiAsync::begin() {
 
   server.on("/api/soil_calibration", HTTP_POST, handleApiSoilCalibration);
 
+  // профили культур: выбор, удаление, список, свой профиль.
+  // /api/profiles совпадает и с /api/profiles/* — вложенные регистрируем раньше
+  server.on("/api/profiles/select", HTTP_POST, [](AsyncWebServerRequest *r){},
+            NULL, handleApiProfileSelect);
+  server.on("/api/profiles/delete", HTTP_POST, [](AsyncWebServerRequest *r){},
+            NULL, handleApiProfileDelete);
+  server.on("/api/profiles", HTTP_GET, handleApiProfilesGet);
+  server.on("/api/profiles", HTTP_POST, [](AsyncWebServerRequest *r){},
+            NULL, handleApiProfilesPost);
+
   // диагностика
   server.on("/api/diag", HTTP_GET, handleApiDiagGet);
   server.on("/api/diag_limits", HTTP_POST, [](AsyncWebServerRequest *r){},
             NULL, handleApiDiagLimitsPost);
 
+  // профиль цикла автоматики (?reset=1 — обнулить)
+  server.on("/api/perf", HTTP_GET, handleApiPerfGet);
+  server.on("/api/tasks", HTTP_GET, handleApiTasksGet);
+  server.on("/api/stats", HTTP_GET, handleApiStatsGet);
+  server.on("/api/sun", HTTP_GET, handleApiSunGet);
+
+  // правила: исходник и состояние; POST — текст целиком (text/plain)
+  server.on("/api/rules", HTTP_GET, handleApiRulesGet);
+  server.on("/api/rules", HTTP_POST, handleApiRulesRequest,
+            NULL, handleApiRulesPost);
+
   // OTA /update
   setupOtaRoutes();
 
@@ -0,0 +1,137 @@
+// === FILE: host/bench/bench_rules.cpp ===
+// Стоимость пользовательских правил: компиляция и Rules::evaluate.
+//
+//   bench_rules [ticks]
+//
+// Для 10, 25, 50, 100 и MAX_RULES правил четырёх типичных видов
+// (вентиляция по температуре и часу, дверь по влажности, свет по
+// солнцу, полив в окне) текст компилируется, затем ticks тиков
+// по SCHED_TICK_MS выполняется только этап правил. Датчики меняются
+// каждые SENSOR_PERIOD_MS, чтобы правила переключались.
+
+#include <Arduino.h>
+#include "HostHw.h"
+#include "ManualClock.h"
+
+#include "Config.h"
+#include "Globals.h"
+#include "Storage.h"
+#include "TimeManager.h"
+#include "DeviceManager.h"
+#include "Automation.h"
+#include "Rules.h"
+#include "TickContext.h"
+#include "SunPosition.h"
+
+#include <chrono>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+  using SteadyClock = std::chrono::steady_clock;
+
+  std::string makeRules(uint16_t n) {
+    std::string src = "# bench_rules\n";
+    char line[160];
+    for (uint16_t i = 0; i < n; ++i) {
+      switch (i % 4) {
+        case 0:
+          snprintf(line, sizeof(line),
+                   "if airTemp > %d and hour >= %d then fan on else fan off hyst 0.5 dwell 30\n",
+                   24 + i % 8, 6 + i % 4);
+          break;
+        case 1:
+          snprintf(line, sizeof(line),
+                   "if (airHum > %d or airTemp > %d) and not pump then door %d else door 0\n",
+                   70 + i % 15, 28 + i % 5, 20 + i % 80);
+          break;
+        case 2:
+          snprintf(line, sizeof(line),
+                   "if night or lux > %d then light off else light on hyst 500 dwell 60\n",
+                   8000 + 250 * (i % 16));
+          break;
+        default:
+          snprintf(line, sizeof(line),
+                   "if soil < %d and hour >= 6 and hour < 20 and sunAlt > -6 then pump on else pump off hyst 3 dwell 120\n",
+                   40 + i % 20);
+          break;
+      }
+      src += line;
+    }
+    return src;
+  }
+
+  void feedSensors(uint32_t tick) {
+    float phase = (float)(tick % 600) / 600.0f * 6.2831853f;
+    HostHw::setBme(true, 27.0f + 5.0f * sinf(phase), 75.0f + 10.0f * cosf(phase), 100500.0f);
+    HostHw::setLux(true, 12000.0f + 4000.0f * sinf(phase));
+    HostHw::setAnalog(Pins::SOIL_ANALOG, (uint16_t)(3500 - (50.0f + 10.0f * cosf(phase)) * 17.0f));
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint32_t ticks = 100000;
+  if (argc > 1) ticks = (uint32_t)strtoul(argv[1], nullptr, 10);
+  if (ticks == 0) ticks = 1;
+
+  ManualClock::set(1000, 1748768400);   // 2025-06-01 12:00 MSK
+  Clock::bind(ManualClock::source());
+
+  HostHw::setAnalog(Pins::SOIL_TEMP_ANALOG, 900);
+  feedSensors(0);
+
+  Storage::begin();
+  Storage::loadSettings(g_settings);
+  DeviceManager::begin();
+  TimeManager::begin();
+  Automation::begin();
+  while (!SunPosition::service(Clock::now())) {}
+
+  printf("rules: %u ticks each, tick %u ms\n", ticks, AutomationConfig::SCHED_TICK_MS);
+  printf("%6s %10s %12s %14s %12s %10s\n",
+         "rules", "bytes", "compile us", "ns/evaluate", "ns/rule", "switches");
+
+  const uint16_t counts[] = { 10, 25, 50, 100, RulesConfig::MAX_RULES };
+  for (uint16_t n : counts) {
+    std::string src = makeRules(n);
+
+    Rules::CompileResult res;
+    auto c0 = SteadyClock::now();
+    bool ok = Rules::install(src.c_str(), src.size(), false, res);
+    double compileUs = std::chrono::duration<double, std::micro>(SteadyClock::now() - c0).count();
+    if (!ok) {
+      fprintf(stderr, "%u rules: line %u: %s\n", n, res.line, res.error);
+      return 1;
+    }
+
+    const uint32_t switches0 = Rules::status().switches;
+    double totalNs = 0.0;
+    for (uint32_t i = 0; i < ticks; ++i) {
+      if (i % (AutomationConfig::SENSOR_PERIOD_MS / AutomationConfig::SCHED_TICK_MS) == 0) {
+        feedSensors(i);
+        DeviceManager::acquireSensors();
+      }
+
+      TickContext ctx;
+      Tick::build(Clock::millis(), ctx);
+
+      auto t0 = SteadyClock::now();
+      Rules::evaluate(ctx);
+      totalNs += std::chrono::duration<double, std::nano>(SteadyClock::now() - t0).count();
+
+      DeviceManager::commitOutputs();
+      vTaskDelay(pdMS_TO_TICKS(AutomationConfig::SCHED_TICK_MS));
+    }
+
+    Rules::Status st = Rules::status();
+    double perEval = totalNs / ticks;
+    printf("%6u %10u %12.1f %14.1f %12.2f %10u\n",
+           st.rules, st.codeBytes, compileUs, perEval, perEval / st.rules,
+           st.switches - switches0);
+  }
+
+  return 0;
+}
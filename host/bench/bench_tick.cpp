@@ -0,0 +1,164 @@
+// === FILE: host/bench/bench_tick.cpp ===
+// Бенчмарк одной итерации automationTask на хосте.
+//
+//   bench_tick [ticks]
+//
+// Каждая итерация — это то, что делает StateMachine раз в секунду:
+// сборка TickContext, stepCritical, PumpGovernor::tick, stepHigh/Medium/Low,
+// правила (без загруженных правил — только проверка), обновление стресса
+// и вывод на исполнители (commitOutputs), плюс один опрос
+// датчиков (на ESP32 — в sensorTask на другом ядре). Показания
+// датчиков "гуляют", чтобы проходились разные ветки автоматики.
+
+#include <Arduino.h>
+#include "HostHw.h"
+#include "ManualClock.h"
+
+#include "Config.h"
+#include "Globals.h"
+#include "Storage.h"
+#include "TimeManager.h"
+#include "DeviceManager.h"
+#include "Automation.h"
+#include "SensorStats.h"
+#include "Rules.h"
+#include "PumpGovernor.h"
+#include "TelemetryLogger.h"
+#include "Diagnostics.h"
+#include "TickContext.h"
+#include "SunPosition.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+  using SteadyClock = std::chrono::steady_clock;
+
+  struct StageStat {
+    const char* name;
+    double      totalNs = 0.0;
+    double      minNs   = 1e30;
+    double      maxNs   = 0.0;
+  };
+
+  enum Stage { ST_ACQUIRE, ST_CONTEXT, ST_CRITICAL, ST_PUMP, ST_HIGH, ST_MEDIUM,
+               ST_LOW, ST_LIGHT, ST_RULES, ST_STRESS, ST_STATS, ST_COMMIT, ST_COUNT };
+
+  StageStat stats[ST_COUNT] = {
+    { "DeviceManager::acquire"   },
+    { "Tick::build"              },
+    { "Automation::stepCritical" },
+    { "PumpGovernor::tick"       },
+    { "Automation::stepHigh"     },
+    { "Automation::stepMedium"   },
+    { "Automation::stepLow"      },
+    { "Automation::lightStats"   },
+    { "Rules::evaluate"          },
+    { "Automation::updateStress" },
+    { "SensorStats::sample"      },
+    { "DeviceManager::commit"    },
+  };
+
+  template<typename Fn>
+  inline void timed(Stage st, Fn fn) {
+    auto t0 = SteadyClock::now();
+    fn();
+    auto t1 = SteadyClock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    StageStat& s = stats[st];
+    s.totalNs += ns;
+    if (ns < s.minNs) s.minNs = ns;
+    if (ns > s.maxNs) s.maxNs = ns;
+  }
+
+  // Медленно меняющаяся "погода", чтобы пороги срабатывали в обе стороны
+  void feedSensors(uint32_t tick) {
+    float phase = (float)(tick % 3600) / 3600.0f * 6.2831853f;
+    float t     = 26.0f + 12.0f * sinf(phase);
+    float h     = 60.0f + 20.0f * cosf(phase);
+    float lux   = 60.0f + 60.0f * sinf(phase * 3.0f);
+    if (lux < 0.0f) lux = 0.0f;
+
+    HostHw::setBme(true, t, h, 100500.0f);
+    HostHw::setLux(true, lux);
+
+    uint16_t soilRaw = (uint16_t)(2650 + 800 * sinf(phase * 2.0f));
+    HostHw::setAnalog(Pins::SOIL_ANALOG, soilRaw);
+    HostHw::setAnalog(Pins::SOIL_TEMP_ANALOG, 900);
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint32_t ticks = 200000;
+  if (argc > 1) ticks = (uint32_t)strtoul(argv[1], nullptr, 10);
+  if (ticks == 0) ticks = 1;
+
+  // Фиксированная дата — тики воспроизводимы и не зависят от часов хоста
+  ManualClock::set(1000, 1748768400);   // 2025-06-01 12:00 MSK
+  Clock::bind(ManualClock::source());
+
+  feedSensors(0);
+
+  Storage::begin();
+  Storage::loadSettings(g_settings);
+  DeviceManager::begin();
+  TimeManager::begin();
+  TelemetryLogger::begin();
+  Automation::begin();
+  SensorStats::begin();
+  Diagnostics::begin();
+
+  // суточную таблицу солнца на ESP32 достраивает этап SunTable — здесь сразу
+  while (!SunPosition::service(Clock::now())) {}
+
+  auto wall0 = SteadyClock::now();
+  TickContext ctx;
+
+  for (uint32_t i = 0; i < ticks; ++i) {
+    feedSensors(i);
+
+    timed(ST_ACQUIRE,   [] { DeviceManager::acquireSensors(); });
+    timed(ST_CONTEXT,   [&] { Tick::build(Clock::millis(), ctx); });
+    timed(ST_CRITICAL,  [&] { Automation::stepCritical(ctx); });
+    timed(ST_PUMP,      [&] { PumpGovernor::tick(ctx); });
+    timed(ST_HIGH,      [&] { Automation::stepHigh(ctx); });
+    timed(ST_MEDIUM,    [&] { Automation::stepMedium(ctx); });
+    timed(ST_LOW,       [&] { Automation::stepLow(ctx); });
+    timed(ST_LIGHT,     [&] { Automation::updateLightStats(ctx); });
+    timed(ST_RULES,     [&] { Rules::evaluate(ctx); });
+    timed(ST_STRESS,    [&] { Automation::updateStress(ctx); });
+    timed(ST_STATS,     [&] { SensorStats::sample(ctx); });
+    timed(ST_COMMIT,    [] { DeviceManager::commitOutputs(); });
+
+    TelemetryLogger::loop();
+    Diagnostics::loop();
+    SunPosition::service(Clock::now());
+
+    vTaskDelay(pdMS_TO_TICKS(AutomationConfig::AUTOMATION_INTERVAL_MS));
+  }
+
+  double wallNs = std::chrono::duration<double, std::nano>(SteadyClock::now() - wall0).count();
+
+  printf("ticks: %u (simulated %.1f h)\n", ticks,
+         ticks * (AutomationConfig::AUTOMATION_INTERVAL_MS / 3600000.0));
+  printf("%-28s %12s %12s %12s\n", "stage", "avg ns", "min ns", "max ns");
+
+  double sumAvg = 0.0;
+  for (const StageStat& s : stats) {
+    double avg = s.totalNs / ticks;
+    sumAvg += avg;
+    printf("%-28s %12.1f %12.1f %12.1f\n", s.name, avg, s.minNs, s.maxNs);
+  }
+  printf("%-28s %12.1f\n", "sum of stages", sumAvg);
+  printf("%-28s %12.1f\n", "full tick (wall)", wallNs / ticks);
+
+  // сколько запросов к исполнителям реально дошло до железа
+  DeviceManager::OutputStats o = DeviceManager::getOutputStats();
+  printf("outputs: %u requests, %u commits, transitions light %u pump %u fan %u door %u valves %u, led %u\n",
+         o.requests, o.commits, o.light, o.pump, o.fan, o.door, o.valves, o.ledRefreshes);
+
+  return 0;
+}
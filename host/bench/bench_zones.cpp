@@ -0,0 +1,92 @@
+// === FILE: host/bench/bench_zones.cpp ===
+// Стоимость зональной части тика в зависимости от числа грядок.
+//
+//   bench_zones [ticks]
+//
+// Для 1, 2, 4 … MAX_ZONES зон прогоняется ticks тиков stepHigh
+// (полив, статистика высыхания, адаптация) + updateStress (почвенный
+// стресс по зонам) + commitOutputs (клапаны). Отсчёты зон меняются
+// в пределах гистерезиса, чтобы каждая зона проходила полный путь
+// решения, но насос не упирался в суточный лимит.
+
+#include <Arduino.h>
+#include "HostHw.h"
+#include "ManualClock.h"
+
+#include "Config.h"
+#include "Globals.h"
+#include "Storage.h"
+#include "TimeManager.h"
+#include "DeviceManager.h"
+#include "Automation.h"
+#include "TickContext.h"
+#include "SunPosition.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+  using SteadyClock = std::chrono::steady_clock;
+
+  void feedZones(uint8_t n, uint32_t tick) {
+    for (uint8_t z = 0; z < n; ++z) {
+      float phase = (float)((tick + z * 97u) % 3600) / 3600.0f * 6.2831853f;
+      float pct   = 65.0f + 3.0f * sinf(phase);
+      if (z == 0) HostHw::setAnalog(Pins::SOIL_ANALOG, (uint16_t)(3500 - pct * 17.0f));
+      else        Automation::setZoneSoil(z, pct);
+    }
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint32_t ticks = 20000;
+  if (argc > 1) ticks = (uint32_t)strtoul(argv[1], nullptr, 10);
+  if (ticks == 0) ticks = 1;
+
+  ManualClock::set(1000, 1748768400);   // 2025-06-01 12:00 MSK — окно полива
+  Clock::bind(ManualClock::source());
+
+  HostHw::setBme(true, 24.0f, 60.0f, 100500.0f);
+  HostHw::setLux(true, 20000.0f);
+  HostHw::setAnalog(Pins::SOIL_TEMP_ANALOG, 900);
+
+  Storage::begin();
+  Storage::loadSettings(g_settings);
+  DeviceManager::begin();
+  TimeManager::begin();
+  while (!SunPosition::service(Clock::now())) {}
+
+  printf("zones: MAX_ZONES=%u, %u ticks each\n", ZoneConfig::MAX_ZONES, ticks);
+  printf("%6s %14s %14s\n", "zones", "ns/tick", "ns/zone");
+
+  for (uint16_t n = 1; n <= ZoneConfig::MAX_ZONES; n *= 2) {
+    Automation::begin();
+    Tick::reset();
+    Automation::setZoneCount((uint8_t)n);
+
+    double totalNs = 0.0;
+    for (uint32_t i = 0; i < ticks; ++i) {
+      feedZones((uint8_t)n, i);
+      DeviceManager::acquireSensors();
+
+      TickContext ctx;
+      Tick::build(Clock::millis(), ctx);
+
+      auto t0 = SteadyClock::now();
+      Automation::stepHigh(ctx);
+      Automation::updateStress(ctx);
+      DeviceManager::commitOutputs();
+      totalNs += std::chrono::duration<double, std::nano>(SteadyClock::now() - t0).count();
+
+      vTaskDelay(pdMS_TO_TICKS(AutomationConfig::CLIMATE_PERIOD_MS));
+    }
+
+    double perTick = totalNs / ticks;
+    printf("%6u %14.1f %14.1f\n", n, perTick, perTick / n);
+  }
+
+  return 0;
+}
@@ -0,0 +1,12 @@
+// === FILE: host/shim/Adafruit_BME280.h ===
+#pragma once
+#include <Arduino.h>
+
+// Показания берутся из HostHw::setBme().
+class Adafruit_BME280 {
+public:
+  bool  begin(uint8_t addr = 0x77);
+  float readTemperature();
+  float readHumidity();
+  float readPressure();   // Па
+};
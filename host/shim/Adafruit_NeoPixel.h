@@ -0,0 +1,29 @@
+// === FILE: host/shim/Adafruit_NeoPixel.h ===
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+#define NEO_GRB     0x52
+#define NEO_KHZ800  0x0000
+
+class Adafruit_NeoPixel {
+public:
+  Adafruit_NeoPixel(uint16_t n, int16_t pin, uint16_t type)
+    : pixels_(n, 0) { (void)pin; (void)type; }
+
+  void begin() {}
+  void clear() { for (auto& p : pixels_) p = 0; }
+  void setBrightness(uint8_t b) { brightness_ = b; }
+  void setPixelColor(uint16_t n, uint32_t c) {
+    if (n < pixels_.size()) pixels_[n] = c;
+  }
+  void show();
+
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+
+private:
+  std::vector<uint32_t> pixels_;
+  uint8_t brightness_ = 255;
+};
@@ -0,0 +1,131 @@
+// === FILE: host/shim/Arduino.h ===
+#pragma once
+
+// Тонкая прослойка Arduino-ESP32 API для хост-сборки (Linux).
+// Реализует ровно то, что используют модули ядра: millis, String,
+// Serial, GPIO/АЦП, getLocalTime и FreeRTOS-задержки.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <initializer_list>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+
+#define PROGMEM
+#define F(s) (s)
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+// ---------- время ----------
+
+uint32_t millis();
+uint32_t micros();
+void     delay(uint32_t ms);
+
+// ---------- GPIO / АЦП ----------
+
+void     pinMode(uint8_t pin, uint8_t mode);
+void     digitalWrite(uint8_t pin, uint8_t val);
+int      digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+void     analogWrite(uint8_t pin, int value);   // ШИМ, 8 бит
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// ---------- esp32-hal-time ----------
+
+void configTzTime(const char* tz, const char* server1,
+                  const char* server2 = nullptr, const char* server3 = nullptr);
+bool getLocalTime(struct tm* info, uint32_t ms = 5000);
+
+// ---------- ESP ----------
+// Счётчик тактов на хосте — наносекунды steady_clock ("CPU 1000 МГц").
+class EspClass {
+public:
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 1000; }
+  uint32_t getFreeHeap()   { return 200000; }
+  void     restart()       {}
+};
+
+extern EspClass ESP;
+
+// ---------- String ----------
+
+class String {
+public:
+  String() = default;
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  String(unsigned char v, unsigned char base = 10);
+  String(int v, unsigned char base = 10);
+  String(unsigned int v, unsigned char base = 10);
+  String(long v, unsigned char base = 10);
+  String(unsigned long v, unsigned char base = 10);
+  String(float v, unsigned int decimals = 2);
+  String(double v, unsigned int decimals = 2);
+
+  bool        reserve(unsigned int size) { s_.reserve(size); return true; }
+  unsigned    length() const { return (unsigned)s_.size(); }
+  const char* c_str() const { return s_.c_str(); }
+
+  String& operator+=(const String& o)  { s_ += o.s_; return *this; }
+  String& operator+=(const char* o)    { s_ += (o ? o : ""); return *this; }
+  String& operator+=(char c)           { s_ += c; return *this; }
+
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o)   const { return s_ == (o ? o : ""); }
+  bool operator!=(const String& o) const { return !(*this == o); }
+  bool operator!=(const char* o)   const { return !(*this == o); }
+
+  const std::string& str() const { return s_; }
+
+private:
+  std::string s_;
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b)   { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b)   { String r(a); r += b; return r; }
+
+// ---------- Serial ----------
+
+class HardwareSerial {
+public:
+  void begin(unsigned long) {}
+
+  size_t print(const char* s);
+  size_t print(const String& s) { return print(s.c_str()); }
+  size_t print(char c);
+  size_t print(int v);
+  size_t print(unsigned int v);
+  size_t print(long v);
+  size_t print(unsigned long v);
+  size_t print(double v, int digits = 2);
+
+  size_t println();
+  template<typename T>
+  size_t println(const T& v) { size_t n = print(v); return n + println(); }
+
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,15 @@
+// === FILE: host/shim/BH1750.h ===
+#pragma once
+#include <Arduino.h>
+
+// Показания берутся из HostHw::setLux().
+class BH1750 {
+public:
+  enum Mode {
+    UNCONFIGURED             = 0,
+    CONTINUOUS_HIGH_RES_MODE = 0x10,
+  };
+
+  bool  begin(Mode mode = CONTINUOUS_HIGH_RES_MODE, uint8_t addr = 0x23);
+  float readLightLevel();
+};
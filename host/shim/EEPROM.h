@@ -0,0 +1,44 @@
+// === FILE: host/shim/EEPROM.h ===
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+// EEPROM-эмуляция в памяти процесса (на ESP32 это тоже RAM-буфер + flash).
+class EEPROMClass {
+public:
+  bool begin(size_t size) {
+    if (data_.size() < size) data_.resize(size, 0xFF);
+    return true;
+  }
+
+  uint8_t read(int addr) const {
+    return (addr >= 0 && (size_t)addr < data_.size()) ? data_[addr] : 0xFF;
+  }
+  void write(int addr, uint8_t v) {
+    if (addr >= 0 && (size_t)addr < data_.size()) data_[addr] = v;
+  }
+
+  template<typename T>
+  T& get(int addr, T& out) const {
+    uint8_t* p = (uint8_t*)&out;
+    for (size_t i = 0; i < sizeof(T); ++i) p[i] = read(addr + (int)i);
+    return out;
+  }
+
+  template<typename T>
+  const T& put(int addr, const T& in) {
+    const uint8_t* p = (const uint8_t*)&in;
+    for (size_t i = 0; i < sizeof(T); ++i) write(addr + (int)i, p[i]);
+    return in;
+  }
+
+  bool commit() { commits_++; return true; }
+  uint32_t commits() const { return commits_; }
+  size_t length() const { return data_.size(); }
+
+private:
+  std::vector<uint8_t> data_;
+  uint32_t commits_ = 0;
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,15 @@
+// === FILE: host/shim/ESP32Servo.h ===
+#pragma once
+#include <Arduino.h>
+
+// Последний угол доступен через HostHw::servoAngle().
+class Servo {
+public:
+  int  attach(int pin) { pin_ = pin; return 1; }
+  void write(int angle);
+  int  read() const { return angle_; }
+
+private:
+  int pin_   = -1;
+  int angle_ = 0;
+};
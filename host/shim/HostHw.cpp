@@ -0,0 +1,252 @@
+// === FILE: host/shim/HostHw.cpp ===
+#include "HostHw.h"
+#include "ManualClock.h"
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <SPIFFS.h>
+#include <Wire.h>
+#include <Adafruit_BME280.h>
+#include <BH1750.h>
+#include <ESP32Servo.h>
+#include <Adafruit_NeoPixel.h>
+
+#include <chrono>
+#include <stdio.h>
+
+namespace {
+
+  constexpr int PIN_COUNT = 64;
+
+  uint16_t analogRaw[PIN_COUNT]  = {};
+  bool     pinState[PIN_COUNT]   = {};
+  uint32_t pinWriteCnt[PIN_COUNT] = {};
+  uint8_t  pwmValue[PIN_COUNT]    = {};
+
+  bool  bmePresent  = true;
+  float bmeTemp     = 22.0f;
+  float bmeHum      = 55.0f;
+  float bmePressure = 101325.0f;
+
+  bool  bhPresent = true;
+  float bhLux     = 500.0f;
+
+  int      servoLast  = -1;
+  uint32_t servoCnt   = 0;
+  uint32_t ledShowCnt = 0;
+
+  bool serialEcho = false;
+
+  inline bool validPin(uint8_t pin) { return pin < PIN_COUNT; }
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+// HostHw
+// -----------------------------------------------------------------------------
+
+void HostHw::setAnalog(uint8_t pin, uint16_t raw) {
+  if (validPin(pin)) analogRaw[pin] = raw;
+}
+
+uint16_t HostHw::analogValue(uint8_t pin) {
+  return validPin(pin) ? analogRaw[pin] : 0;
+}
+
+bool HostHw::pinLevel(uint8_t pin) {
+  return validPin(pin) ? pinState[pin] : false;
+}
+
+uint32_t HostHw::pinWrites(uint8_t pin) {
+  return validPin(pin) ? pinWriteCnt[pin] : 0;
+}
+
+uint8_t HostHw::pwm(uint8_t pin) {
+  return validPin(pin) ? pwmValue[pin] : 0;
+}
+
+void HostHw::setBme(bool present, float tempC, float humPct, float pressurePa) {
+  bmePresent  = present;
+  bmeTemp     = tempC;
+  bmeHum      = humPct;
+  bmePressure = pressurePa;
+}
+
+void HostHw::setLux(bool present, float lux) {
+  bhPresent = present;
+  bhLux     = lux;
+}
+
+int      HostHw::servoAngle()  { return servoLast; }
+uint32_t HostHw::servoWrites() { return servoCnt; }
+uint32_t HostHw::ledShows()    { return ledShowCnt; }
+
+void HostHw::setSerialEcho(bool on) { serialEcho = on; }
+
+// -----------------------------------------------------------------------------
+// Arduino core
+// -----------------------------------------------------------------------------
+
+HardwareSerial Serial;
+EspClass       ESP;
+EEPROMClass    EEPROM;
+SPIFFSClass    SPIFFS;
+TwoWire        Wire;
+
+uint32_t millis() { return ManualClock::millis(); }
+uint32_t micros() { return ManualClock::millis() * 1000UL; }
+void     delay(uint32_t ms) { ManualClock::advance(ms); }
+
+uint32_t EspClass::getCycleCount() {
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  return (uint32_t)ns;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (!validPin(pin)) return;
+  pinState[pin] = (val != LOW);
+  pinWriteCnt[pin]++;
+}
+
+int digitalRead(uint8_t pin) {
+  return (validPin(pin) && pinState[pin]) ? HIGH : LOW;
+}
+
+uint16_t analogRead(uint8_t pin) {
+  return validPin(pin) ? analogRaw[pin] : 0;
+}
+
+void analogWrite(uint8_t pin, int value) {
+  if (!validPin(pin)) return;
+  pwmValue[pin] = (uint8_t)constrain(value, 0, 255);
+  pinWriteCnt[pin]++;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  if (inMax == inMin) return outMin;
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+void configTzTime(const char* tz, const char* server1,
+                  const char* server2, const char* server3) {
+  (void)server1; (void)server2; (void)server3;
+  setenv("TZ", tz, 1);
+  tzset();
+}
+
+bool getLocalTime(struct tm* info, uint32_t ms) {
+  (void)ms;
+  time_t now = ManualClock::now();
+  localtime_r(&now, info);
+  return info->tm_year > (2016 - 1900);
+}
+
+// ---------- FreeRTOS ----------
+
+void vTaskDelay(TickType_t ticks) { ManualClock::advance(ticks); }
+
+void vTaskDelayUntil(TickType_t* prevWake, TickType_t increment) {
+  TickType_t wake = *prevWake + increment;
+  TickType_t now  = ManualClock::millis();
+  if ((int32_t)(wake - now) > 0) ManualClock::advance(wake - now);
+  *prevWake = wake;
+}
+
+TickType_t xTaskGetTickCount() { return ManualClock::millis(); }
+
+// Задач нет: хэндлы не находятся, TaskMonitor считает только по Perf
+TaskHandle_t xTaskGetHandle(const char*) { return nullptr; }
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+
+// Задач нет — уведомлять некого; ожидание просто двигает часы
+BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t ticks) {
+  ManualClock::advance(ticks);
+  return 0;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name,
+                                   uint32_t stackDepth, void* param,
+                                   UBaseType_t priority, TaskHandle_t* outHandle,
+                                   BaseType_t coreId) {
+  (void)fn; (void)name; (void)stackDepth; (void)param;
+  (void)priority; (void)coreId;
+  if (outHandle) *outHandle = nullptr;
+  return pdPASS;
+}
+
+// ---------- String ----------
+
+namespace {
+  std::string fmtInt(long long v, unsigned char base) {
+    if (base == 16) {
+      char b[24];
+      snprintf(b, sizeof(b), "%llx", (unsigned long long)v);
+      return b;
+    }
+    return std::to_string(v);
+  }
+
+  std::string fmtFloat(double v, unsigned int decimals) {
+    char b[48];
+    snprintf(b, sizeof(b), "%.*f", (int)decimals, v);
+    return b;
+  }
+}
+
+String::String(unsigned char v, unsigned char base) : s_(fmtInt(v, base)) {}
+String::String(int v, unsigned char base)           : s_(fmtInt(v, base)) {}
+String::String(unsigned int v, unsigned char base)  : s_(fmtInt(v, base)) {}
+String::String(long v, unsigned char base)          : s_(fmtInt(v, base)) {}
+String::String(unsigned long v, unsigned char base) : s_(fmtInt((long long)v, base)) {}
+String::String(float v, unsigned int decimals)      : s_(fmtFloat(v, decimals)) {}
+String::String(double v, unsigned int decimals)     : s_(fmtFloat(v, decimals)) {}
+
+// ---------- Serial ----------
+
+size_t HardwareSerial::print(const char* s) {
+  if (!serialEcho || !s) return 0;
+  return fputs(s, stdout) >= 0 ? strlen(s) : 0;
+}
+
+size_t HardwareSerial::print(char c)            { char b[2] = { c, 0 }; return print(b); }
+size_t HardwareSerial::print(int v)             { return print(String(v)); }
+size_t HardwareSerial::print(unsigned int v)    { return print(String(v)); }
+size_t HardwareSerial::print(long v)            { return print(String(v)); }
+size_t HardwareSerial::print(unsigned long v)   { return print(String(v)); }
+size_t HardwareSerial::print(double v, int digits) { return print(String(v, (unsigned)digits)); }
+
+size_t HardwareSerial::println() { return print("\n"); }
+
+size_t HardwareSerial::printf(const char* fmt, ...) {
+  if (!serialEcho) return 0;
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vprintf(fmt, ap);
+  va_end(ap);
+  return n > 0 ? (size_t)n : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Библиотеки датчиков/исполнителей
+// -----------------------------------------------------------------------------
+
+bool  Adafruit_BME280::begin(uint8_t addr) { (void)addr; return bmePresent; }
+float Adafruit_BME280::readTemperature()   { return bmePresent ? bmeTemp : NAN; }
+float Adafruit_BME280::readHumidity()      { return bmePresent ? bmeHum : NAN; }
+float Adafruit_BME280::readPressure()      { return bmePresent ? bmePressure : NAN; }
+
+bool BH1750::begin(Mode mode, uint8_t addr) { (void)mode; (void)addr; return bhPresent; }
+float BH1750::readLightLevel()              { return bhPresent ? bhLux : -2.0f; }
+
+void Servo::write(int angle) {
+  angle_    = angle;
+  servoLast = angle;
+  servoCnt++;
+}
+
+void Adafruit_NeoPixel::show() { ledShowCnt++; }
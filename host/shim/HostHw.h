@@ -0,0 +1,32 @@
+// === FILE: host/shim/HostHw.h ===
+#pragma once
+#include <stdint.h>
+
+// Управление "виртуальным железом" хост-сборки.
+// Через эти функции бенчмарк/симулятор подставляет показания датчиков
+// и читает состояние выходов (реле, серво, светодиоды).
+namespace HostHw {
+
+  // Время на хосте — см. ManualClock.h: millis(), delay() и vTaskDelay()
+  // работают от ручных/ускоренных часов.
+
+  // ---------- GPIO / АЦП ----------
+  void     setAnalog(uint8_t pin, uint16_t raw);
+  uint16_t analogValue(uint8_t pin);
+  bool     pinLevel(uint8_t pin);         // последнее digitalWrite
+  uint32_t pinWrites(uint8_t pin);        // сколько раз писали в пин
+  uint8_t  pwm(uint8_t pin);              // последний analogWrite, 0..255
+
+  // ---------- I2C-датчики ----------
+  void setBme(bool present, float tempC, float humPct, float pressurePa);
+  void setLux(bool present, float lux);
+
+  // ---------- исполнители ----------
+  int      servoAngle();                  // последний Servo::write (градусы), -1 если не писали
+  uint32_t servoWrites();
+  uint32_t ledShows();                    // сколько раз вызывали NeoPixel::show()
+
+  // ---------- вывод ----------
+  // По умолчанию Serial на хосте молчит, чтобы не мерить printf.
+  void setSerialEcho(bool on);
+}
@@ -0,0 +1,68 @@
+// === FILE: host/shim/ManualClock.cpp ===
+#include "ManualClock.h"
+
+#include <chrono>
+
+namespace {
+
+  using Steady = std::chrono::steady_clock;
+
+  uint64_t monoMs = 1000;
+  int64_t  utcMs  = 0;
+
+  double        accel = 0.0;
+  Steady::time_point accelBase;
+
+  // сколько мс "натикало" в ускоренном режиме с последней фиксации
+  uint64_t accelElapsedMs() {
+    if (accel <= 0.0) return 0;
+    double realMs = std::chrono::duration<double, std::milli>(Steady::now() - accelBase).count();
+    return (uint64_t)(realMs * accel);
+  }
+
+  // переносим ускоренный прирост в ручные счётчики
+  void settle() {
+    uint64_t d = accelElapsedMs();
+    if (d == 0) return;
+    monoMs   += d;
+    utcMs    += (int64_t)d;
+    accelBase = Steady::now();
+  }
+
+  uint32_t srcMonoMs()  { return ManualClock::millis(); }
+  time_t   srcWallUtc() { return ManualClock::now(); }
+}
+
+void ManualClock::set(uint32_t mono, time_t utc) {
+  monoMs    = mono;
+  utcMs     = (int64_t)utc * 1000;
+  accelBase = Steady::now();
+}
+
+void ManualClock::setUtc(time_t utc) {
+  settle();
+  utcMs = (int64_t)utc * 1000;
+}
+
+void ManualClock::advance(uint32_t ms) {
+  monoMs += ms;
+  utcMs  += ms;
+}
+
+void ManualClock::setAccelerated(double factor) {
+  settle();
+  accel     = factor;
+  accelBase = Steady::now();
+}
+
+uint32_t ManualClock::millis() {
+  return (uint32_t)(monoMs + accelElapsedMs());
+}
+
+time_t ManualClock::now() {
+  return (time_t)((utcMs + (int64_t)accelElapsedMs()) / 1000);
+}
+
+Clock::Source ManualClock::source() {
+  return Clock::Source{ srcMonoMs, srcWallUtc };
+}
@@ -0,0 +1,26 @@
+// === FILE: host/shim/ManualClock.h ===
+#pragma once
+#include "Clock.h"
+
+// Ручные / ускоренные часы для хост-прогонов.
+// Монотонное и настенное время двигаются вместе: advance(24 ч) —
+// это и 24 ч для окна насоса, и смена суток для SunPosition.
+namespace ManualClock {
+
+  // Начальное состояние: millis() = 1000 (как после setup()), UTC = 0 (времени нет)
+  void set(uint32_t monoMs, time_t utc);
+  void setUtc(time_t utc);
+
+  // Ручной сдвиг (delay/vTaskDelay на хосте тоже идут сюда)
+  void advance(uint32_t ms);
+
+  // factor > 0: время дополнительно идёт от steady_clock с ускорением factor
+  // (например 3600 — час за секунду). 0 — чисто ручной режим.
+  void setAccelerated(double factor);
+
+  uint32_t millis();
+  time_t   now();
+
+  // Источник для Clock::bind()
+  Clock::Source source();
+}
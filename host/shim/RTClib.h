@@ -0,0 +1,32 @@
+// === FILE: host/shim/RTClib.h ===
+#pragma once
+#include <Arduino.h>
+
+// На хосте RTC нет: begin() возвращает false, TimeManager работает от системных часов.
+class DateTime {
+public:
+  DateTime(uint32_t t = 0) : t_(t) {}
+  uint16_t year()   const { return tmv().tm_year + 1900; }
+  uint8_t  month()  const { return tmv().tm_mon + 1; }
+  uint8_t  day()    const { return tmv().tm_mday; }
+  uint8_t  hour()   const { return tmv().tm_hour; }
+  uint8_t  minute() const { return tmv().tm_min; }
+  uint8_t  second() const { return tmv().tm_sec; }
+
+private:
+  struct tm tmv() const {
+    time_t t = (time_t)t_;
+    struct tm out{};
+    gmtime_r(&t, &out);
+    return out;
+  }
+  uint32_t t_;
+};
+
+class RTC_DS3231 {
+public:
+  bool     begin() { return false; }
+  bool     lostPower() { return true; }
+  void     adjust(const DateTime& dt) { (void)dt; }
+  DateTime now() { return DateTime(0); }
+};
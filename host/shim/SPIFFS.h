@@ -0,0 +1,76 @@
+// === FILE: host/shim/SPIFFS.h ===
+#pragma once
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+// SPIFFS в памяти процесса: файлы живут до конца прогона.
+// Только то, что нужно Storage: open("r"/"w"), read/write, exists,
+// remove, rename.
+
+#define FILE_READ  "r"
+#define FILE_WRITE "w"
+
+class File {
+public:
+  File() = default;
+  File(std::string* data, bool write) : data_(data), write_(write) {}
+
+  explicit operator bool() const { return data_ != nullptr; }
+
+  size_t size() const { return data_ ? data_->size() : 0; }
+
+  size_t read(uint8_t* buf, size_t len) {
+    if (!data_ || write_) return 0;
+    size_t n = data_->size() - pos_;
+    if (n > len) n = len;
+    data_->copy((char*)buf, n, pos_);
+    pos_ += n;
+    return n;
+  }
+
+  size_t write(const uint8_t* buf, size_t len) {
+    if (!data_ || !write_) return 0;
+    data_->append((const char*)buf, len);
+    return len;
+  }
+
+  void close() { data_ = nullptr; }
+
+private:
+  std::string* data_  = nullptr;
+  bool         write_ = false;
+  size_t       pos_   = 0;
+};
+
+class SPIFFSClass {
+public:
+  bool begin(bool formatOnFail = false) { (void)formatOnFail; return true; }
+
+  bool exists(const char* path) const { return files_.count(path) != 0; }
+
+  File open(const char* path, const char* mode = FILE_READ) {
+    if (mode[0] == 'w') {
+      std::string& f = files_[path];
+      f.clear();
+      return File(&f, true);
+    }
+    auto it = files_.find(path);
+    return it == files_.end() ? File() : File(&it->second, false);
+  }
+
+  bool remove(const char* path) { return files_.erase(path) != 0; }
+
+  bool rename(const char* from, const char* to) {
+    auto it = files_.find(from);
+    if (it == files_.end()) return false;
+    files_[to] = std::move(it->second);
+    files_.erase(from);
+    return true;
+  }
+
+private:
+  std::map<std::string, std::string> files_;
+};
+
+extern SPIFFSClass SPIFFS;
@@ -0,0 +1,15 @@
+// === FILE: host/shim/TM1637Display.h ===
+#pragma once
+#include <Arduino.h>
+
+class TM1637Display {
+public:
+  TM1637Display(uint8_t clk, uint8_t dio) { (void)clk; (void)dio; }
+  void setBrightness(uint8_t brightness, bool on = true) { (void)brightness; (void)on; }
+  void clear() {}
+  void showNumberDec(int num, bool leadingZero = false) { last_ = num; (void)leadingZero; }
+  int  lastNumber() const { return last_; }
+
+private:
+  int last_ = 0;
+};
@@ -0,0 +1,13 @@
+// === FILE: host/shim/TelegramAsyncHost.cpp ===
+#include "TelegramAsync.h"
+
+// Хост-заглушка бота: сети нет, алерты уходят в Serial (по умолчанию молчит).
+
+void TelegramAsync::begin() {}
+
+void TelegramAsync::loop() {}
+
+void TelegramAsync::sendAlert(const String& text) {
+  Serial.print("[TG] alert: ");
+  Serial.println(text);
+}
@@ -0,0 +1,26 @@
+// === FILE: host/shim/freertos/FreeRTOS.h ===
+#pragma once
+#include <stdint.h>
+
+// Минимальные типы FreeRTOS для хост-сборки.
+// Тик = 1 мс, как в конфигурации Arduino-ESP32.
+
+typedef uint32_t TickType_t;
+typedef int32_t  BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint8_t  StackType_t;   // как в ESP-IDF: стек считается в байтах
+
+#define pdFALSE  ((BaseType_t)0)
+#define pdTRUE   ((BaseType_t)1)
+#define pdPASS   pdTRUE
+#define pdFAIL   pdFALSE
+
+#define portTICK_PERIOD_MS ((TickType_t)1)
+#define portMAX_DELAY      ((TickType_t)0xFFFFFFFFUL)
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+
+// Критические секции: хост-прогоны однопоточные, спинлок не нужен
+typedef struct { volatile uint32_t owner; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux)  ((void)(mux))
@@ -0,0 +1,27 @@
+// === FILE: host/shim/freertos/task.h ===
+#pragma once
+#include "FreeRTOS.h"
+
+// Задачи на хосте не создаются: бенчмарк и симулятор сами вызывают
+// шаги автоматики. vTaskDelay сдвигает ручные часы millis().
+
+typedef void (*TaskFunction_t)(void*);
+typedef void* TaskHandle_t;
+
+void       vTaskDelay(TickType_t ticks);
+void       vTaskDelayUntil(TickType_t* prevWake, TickType_t increment);
+TickType_t xTaskGetTickCount();
+
+TaskHandle_t xTaskGetHandle(const char* name);
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t   ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn,
+                                   const char*    name,
+                                   uint32_t       stackDepth,
+                                   void*          param,
+                                   UBaseType_t    priority,
+                                   TaskHandle_t*  outHandle,
+                                   BaseType_t     coreId);
@@ -0,0 +1,198 @@
+// === FILE: host/sim/GreenhouseSim.cpp ===
+#include "GreenhouseSim.h"
+#include "HostHw.h"
+
+#include "Config.h"
+#include "DeviceManager.h"
+#include "Globals.h"
+#include "SunPosition.h"
+
+#include <math.h>
+
+namespace {
+
+  constexpr float TWO_PI = 6.2831853f;
+
+  GreenhouseSim::Params P;
+  GreenhouseSim::State  S;
+
+  float  absHum        = 10.0f;  // г/м³
+  float  sunAltDeg     = -90.0f;
+  float  cloudFactor   = 1.0f;
+  int    cloudDay      = -1;
+  double sunAccumSec   = 1e9;    // раз в минуту пересчитываем солнце
+  double fracSec       = 0.0;    // дробная часть симулированных секунд
+
+  uint32_t rng = 1;
+
+  float frand() {
+    // xorshift32 → [0, 1)
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (rng >> 8) * (1.0f / 16777216.0f);
+  }
+
+  float noise(float amp) {
+    return (frand() + frand() - 1.0f) * amp;
+  }
+
+  // Насыщающая абсолютная влажность, г/м³ (формула Магнуса)
+  float satAbsHum(float tC) {
+    return 6.112f * expf(17.67f * tC / (tC + 243.5f)) * 216.74f / (273.15f + tC);
+  }
+
+  float clampf(float v, float lo, float hi) {
+    if (v < lo) return lo;
+    if (v > hi) return hi;
+    return v;
+  }
+
+  void updateOutdoor() {
+    time_t local = S.utc + LocationConfig::TZ_OFFSET_MIN * 60;
+    struct tm t;
+    gmtime_r(&local, &t);
+
+    float hour = t.tm_hour + t.tm_min / 60.0f + t.tm_sec / 3600.0f;
+    float doy  = (float)t.tm_yday;
+
+    float seasonal = P.outdoorTempMean -
+                     P.outdoorTempSeason * cosf(TWO_PI * (doy - 15.0f) / 365.0f);
+    float daily    = P.outdoorTempDaily * sinf(TWO_PI * (hour - 9.0f) / 24.0f);
+    S.outdoorTemp  = seasonal + daily;
+
+    // облачность меняется раз в сутки
+    if (t.tm_yday != cloudDay) {
+      cloudDay    = t.tm_yday;
+      cloudFactor = 1.0f - P.cloudiness * frand() * 1.4f;
+      cloudFactor = clampf(cloudFactor, 0.15f, 1.0f);
+    }
+
+    if (sunAccumSec >= 60.0) {
+      sunAccumSec = 0.0;
+      SunPositionData sun = SunPosition::calculate(
+          S.utc,
+          LocationConfig::LATITUDE_DEG,
+          LocationConfig::LONGITUDE_DEG,
+          LocationConfig::TZ_OFFSET_MIN);
+      sunAltDeg = sun.altitudeDeg;
+    }
+
+    float sinAlt = sinf(sunAltDeg * (TWO_PI / 360.0f));
+    if (sunAltDeg > 0.0f) {
+      S.outdoorLux = 110000.0f * sinAlt * cloudFactor;
+    } else if (sunAltDeg > -6.0f) {
+      // гражданские сумерки
+      S.outdoorLux = 400.0f * (1.0f + sunAltDeg / 6.0f);
+    } else {
+      S.outdoorLux = 0.0f;
+    }
+  }
+
+  void writeSensors() {
+    HostHw::setBme(true,
+                   S.airTemp + noise(0.05f),
+                   clampf(S.airHum + noise(0.3f), 0.0f, 100.0f),
+                   100500.0f + noise(20.0f));
+    HostHw::setLux(true, fmaxf(0.0f, S.lux + noise(S.lux * 0.01f)));
+
+    uint16_t dry = 3500, wet = 1800;
+    DeviceManager::getSoilCalibration(dry, wet);
+    float norm = 1.0f - clampf(S.soilMoisture, 0.0f, 100.0f) / 100.0f;
+    float raw  = (float)wet + norm * ((float)dry - (float)wet) + noise(4.0f);
+    HostHw::setAnalog(Pins::SOIL_ANALOG, (uint16_t)clampf(raw, 0.0f, 4095.0f));
+
+    // обратная модель к DeviceManager: T = (V - 0.5) * 100 + offset
+    float v    = (S.soilTemp - g_settings.soilTempOffset) / 100.0f + 0.5f;
+    float rawT = v / 3.3f * 4095.0f;
+    HostHw::setAnalog(Pins::SOIL_TEMP_ANALOG, (uint16_t)clampf(rawT, 0.0f, 4095.0f));
+  }
+
+} // namespace
+
+void GreenhouseSim::begin(const Params& p, time_t startUtc) {
+  P   = p;
+  S   = State{};
+  rng = p.seed ? p.seed : 1;
+
+  S.utc       = startUtc;
+  cloudDay    = -1;
+  sunAccumSec = 1e9;
+  fracSec     = 0.0;
+
+  updateOutdoor();
+  S.airTemp  = S.outdoorTemp + 2.0f;
+  S.soilTemp = S.outdoorTemp;
+  absHum     = satAbsHum(S.airTemp) * S.airHum / 100.0f;
+
+  writeSensors();
+}
+
+void GreenhouseSim::step(float dtSec) {
+  if (dtSec <= 0.0f) return;
+
+  fracSec += dtSec;
+  time_t whole = (time_t)fracSec;
+  S.utc       += whole;
+  fracSec     -= (double)whole;
+  sunAccumSec += dtSec;
+
+  updateOutdoor();
+
+  // ---------- выходы контроллера ----------
+  bool  lightOn = HostHw::pinLevel(Pins::RELAY_LIGHT);
+  bool  pumpOn  = HostHw::pinLevel(Pins::RELAY_PUMP);
+  bool  fanOn   = HostHw::pinLevel(Pins::RELAY_FAN);
+  // с ШИМ поток пропорционален скважности, без него — реле
+  float fanFlow = !fanOn ? 0.0f
+                : Pins::FAN_PWM == Pins::NO_PIN ? 1.0f
+                : HostHw::pwm(Pins::FAN_PWM) / 255.0f;
+  int   servo   = HostHw::servoAngle();
+  float door    = servo > 0 ? clampf(servo / 180.0f, 0.0f, 1.0f) : 0.0f;
+
+  // ---------- свет ----------
+  S.lux = S.outdoorLux * P.transmission + (lightOn ? P.growLightLux : 0.0f);
+
+  // ---------- воздух: тепловой баланс ----------
+  float ua      = P.uaClosed + P.uaDoorFull * door + P.uaFan * fanFlow;
+  float gainKw  = P.solarGain * (S.outdoorLux * P.transmission) / 1000.0f;
+  float lossKw  = ua * (S.airTemp - S.outdoorTemp);
+  S.airTemp    += (gainKw - lossKw) / P.heatCapacity * dtSec;
+
+  // ---------- воздух: влага ----------
+  float solarRel = S.lux / 30000.0f;
+  float soilRel  = clampf(S.soilMoisture / 60.0f, 0.0f, 1.2f);
+  float transp   = (0.003f + 0.03f * solarRel) * soilRel;              // г/м³/с
+  float outAbs   = satAbsHum(S.outdoorTemp) * P.outdoorHum / 100.0f;
+  float exch     = clampf(P.humExchange * ua * dtSec, 0.0f, 1.0f);
+  absHum        += transp * dtSec;
+  absHum        += (outAbs - absHum) * exch;
+
+  float sat = satAbsHum(S.airTemp);
+  if (absHum > sat) absHum = sat;                                      // конденсация
+  S.airHum = clampf(absHum / sat * 100.0f, 0.0f, 100.0f);
+
+  // ---------- почва ----------
+  float heat   = 1.0f + fmaxf(0.0f, S.airTemp - 25.0f) * 0.05f;
+  float etHour = (P.etBasePctHour + P.etSolarPctHour * solarRel) * heat;
+  float dM     = -etHour * dtSec / 3600.0f;
+  if (pumpOn) dM += P.pumpRatePctMin * dtSec / 60.0f;
+  if (S.soilMoisture > P.fieldCapacity) {
+    dM -= (S.soilMoisture - P.fieldCapacity) * 0.5f * dtSec / 3600.0f;
+  }
+  S.soilMoisture = clampf(S.soilMoisture + dM, 0.0f, 100.0f);
+
+  float k = dtSec / (P.soilTempLagHours * 3600.0f);
+  S.soilTemp += (S.airTemp - S.soilTemp) * clampf(k, 0.0f, 1.0f);
+
+  // ---------- накопители ----------
+  if (pumpOn)       S.pumpOnSec   += dtSec;
+  if (lightOn)      S.lightOnSec  += dtSec;
+  if (fanOn)        S.fanOnSec    += dtSec;
+  if (door > 0.05f) S.doorOpenSec += dtSec;
+
+  writeSensors();
+}
+
+const GreenhouseSim::State&  GreenhouseSim::state()  { return S; }
+const GreenhouseSim::Params& GreenhouseSim::params() { return P; }
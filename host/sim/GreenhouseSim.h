@@ -0,0 +1,65 @@
+// === FILE: host/sim/GreenhouseSim.h ===
+#pragma once
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+
+// Упрощённая физика теплицы для хост-симулятора.
+// Модель читает выходы (реле света/помпы/вентилятора, угол серво двери)
+// через HostHw и подставляет показания BME280/BH1750/датчика почвы,
+// так что DeviceManager и Automation работают без изменений.
+namespace GreenhouseSim {
+
+  struct Params {
+    // Улица
+    float outdoorTempMean   = 14.0f;   // средняя за сезон, °C
+    float outdoorTempSeason = 10.0f;   // амплитуда год, °C
+    float outdoorTempDaily  = 6.0f;    // амплитуда сутки, °C
+    float outdoorHum        = 65.0f;   // %
+    float cloudiness        = 0.3f;    // 0..1, ослабление солнца
+
+    // Теплица
+    float heatCapacity      = 150.0f;  // кДж/°C (воздух + конструкции)
+    float solarGain         = 0.040f;  // кВт на 1000 лк внутри
+    float uaClosed          = 0.08f;   // кВт/°C через ограждение
+    float uaDoorFull        = 0.45f;   // кВт/°C при полностью открытой двери
+    float uaFan             = 0.30f;   // кВт/°C при работающем вентиляторе
+    float transmission      = 0.70f;   // пропускание плёнки
+    float growLightLux      = 350.0f;  // добавка досветки у датчика, лк
+    float humExchange       = 0.02f;   // доля обмена влажности в секунду на 1 кВт/°C вентиляции
+
+    // Почва
+    float pumpRatePctMin    = 4.0f;    // прирост влажности за минуту полива, %
+    float etBasePctHour     = 0.3f;    // базовое испарение, %/ч
+    float etSolarPctHour    = 1.2f;    // добавка при 30 клк, %/ч
+    float fieldCapacity     = 85.0f;   // выше — быстрый дренаж
+    float soilTempLagHours  = 3.0f;    // инерция температуры почвы
+
+    uint32_t seed           = 1;       // шум датчиков/облачности
+  };
+
+  struct State {
+    time_t utc          = 0;       // симулированное время (UTC)
+    float  outdoorTemp  = NAN;
+    float  outdoorLux   = 0.0f;
+    float  airTemp      = 20.0f;
+    float  airHum       = 60.0f;
+    float  lux          = 0.0f;
+    float  soilMoisture = 60.0f;
+    float  soilTemp     = 18.0f;
+
+    // Накопители за время моделирования
+    double pumpOnSec    = 0.0;
+    double lightOnSec   = 0.0;
+    double fanOnSec     = 0.0;
+    double doorOpenSec  = 0.0;
+  };
+
+  void begin(const Params& p, time_t startUtc);
+
+  // Шаг физики на dtSec секунд; затем показания "записываются" в датчики.
+  void step(float dtSec);
+
+  const State&  state();
+  const Params& params();
+}
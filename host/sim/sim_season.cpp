@@ -0,0 +1,250 @@
+// === FILE: host/sim/sim_season.cpp ===
+// Ускоренная прогонка сезона: физика GreenhouseSim + неизменённые
+// Automation::step* / PumpGovernor::tick под штатным планировщиком
+// StateMachine (тот же runDue, что в automationTask); опрос датчиков —
+// DeviceManager::acquireSensors с периодом sensorTask.
+//
+//   sim_season [--days N] [--start YYYY-MM-DD] [--csv out.csv] [--trace trace.csv]
+//
+// Физика шагает по 1 с, планировщик — по SCHED_TICK_MS.
+// В конце каждого дня печатается сводка, в конце — ускорение относительно
+// реального времени. --trace пишет показания датчиков раз в 5 минут
+// в формате TelemetrySample — их можно прогнать через replay.
+
+#include <Arduino.h>
+#include "HostHw.h"
+#include "ManualClock.h"
+#include "GreenhouseSim.h"
+
+#include "Config.h"
+#include "Globals.h"
+#include "Storage.h"
+#include "TimeManager.h"
+#include "DeviceManager.h"
+#include "Automation.h"
+#include "SensorStats.h"
+#include "SensorHealth.h"
+#include "TelemetryLogger.h"
+#include "Diagnostics.h"
+#include "StateMachine.h"
+#include "TaskMonitor.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+  struct DayStats {
+    float  tMin = 1e9f, tMax = -1e9f;
+    float  hMin = 1e9f, hMax = -1e9f;
+    float  smMin = 1e9f, smMax = -1e9f;
+    double stressSum = 0.0;
+    uint32_t samples = 0;
+    double pumpSec0 = 0.0, lightSec0 = 0.0, fanSec0 = 0.0;
+  };
+
+  time_t parseDate(const char* s) {
+    struct tm t{};
+    if (sscanf(s, "%d-%d-%d", &t.tm_year, &t.tm_mon, &t.tm_mday) != 3) return 0;
+    t.tm_year -= 1900;
+    t.tm_mon  -= 1;
+    t.tm_hour  = 0;
+    return timegm(&t) - LocationConfig::TZ_OFFSET_MIN * 60;
+  }
+
+  uint32_t nextAcquireMs = 0;
+
+  // Одна секунда работы sensorTask + automationTask: SCHED_TICK_MS-тики
+  void runAutomationSecond() {
+    for (uint32_t t = 0; t < 1000; t += AutomationConfig::SCHED_TICK_MS) {
+      if ((int32_t)(Clock::millis() - nextAcquireMs) >= 0) {
+        DeviceManager::acquireSensors();
+        nextAcquireMs += AutomationConfig::SENSOR_PERIOD_MS;
+      }
+      StateMachine::runDue(Clock::millis());
+      ManualClock::advance(AutomationConfig::SCHED_TICK_MS);
+    }
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint32_t    days     = 180;
+  time_t      startUtc = parseDate("2025-04-01");
+  const char* csvPath  = nullptr;
+  const char* tracePath = nullptr;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--days") && i + 1 < argc) {
+      days = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--start") && i + 1 < argc) {
+      startUtc = parseDate(argv[++i]);
+    } else if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+      csvPath = argv[++i];
+    } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--days N] [--start YYYY-MM-DD] [--csv out.csv] [--trace trace.csv]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  FILE* csv = nullptr;
+  if (csvPath) {
+    csv = fopen(csvPath, "w");
+    if (!csv) { perror(csvPath); return 1; }
+    fprintf(csv, "utc,outTemp,airTemp,airHum,lux,soil,soilTemp,light,pump,fan,door,stress,soilOffset,luxOnOffset\n");
+  }
+
+  // Автоматика видит то же время, что и физика: и millis(), и UTC
+  ManualClock::set(1000, startUtc);
+  Clock::bind(ManualClock::source());
+
+  FILE* trace = nullptr;
+  if (tracePath) {
+    trace = fopen(tracePath, "w");
+    if (!trace) { perror(tracePath); return 1; }
+    fprintf(trace, "ts,airTemp,airHum,soilMoisture,soilTemp,airPressure,lux\n");
+  }
+
+  GreenhouseSim::Params params;
+  GreenhouseSim::begin(params, startUtc);
+
+  Storage::begin();
+  Storage::loadSettings(g_settings);
+  DeviceManager::begin();
+  TimeManager::begin();
+  TelemetryLogger::begin();
+  Automation::begin();
+  SensorStats::begin();
+  Diagnostics::begin();
+  TaskMonitor::begin();
+  StateMachine::begin(Clock::millis());
+  nextAcquireMs = Clock::millis();
+
+  const uint64_t totalSec = (uint64_t)days * 86400ULL;
+
+  printf("%-10s %11s %11s %11s %8s %8s %8s %8s %7s\n",
+         "day", "air °C", "hum %", "soil %", "pump m", "light h", "fan h", "stress", "soilOff");
+
+  DayStats day;
+  auto wall0 = std::chrono::steady_clock::now();
+
+  for (uint64_t sec = 0; sec < totalSec; ++sec) {
+    GreenhouseSim::step(1.0f);
+    runAutomationSecond();
+
+    const GreenhouseSim::State& s = GreenhouseSim::state();
+
+    if (s.airTemp < day.tMin) day.tMin = s.airTemp;
+    if (s.airTemp > day.tMax) day.tMax = s.airTemp;
+    if (s.airHum  < day.hMin) day.hMin = s.airHum;
+    if (s.airHum  > day.hMax) day.hMax = s.airHum;
+    if (s.soilMoisture < day.smMin) day.smMin = s.soilMoisture;
+    if (s.soilMoisture > day.smMax) day.smMax = s.soilMoisture;
+
+    if (sec % 60 == 0) {
+      Automation::DiagInfo d = Automation::getDiagInfo();
+      day.stressSum += d.stressTotal;
+      day.samples++;
+
+      if (csv && sec % 600 == 0) {
+        fprintf(csv, "%ld,%.2f,%.2f,%.1f,%.0f,%.1f,%.1f,%d,%d,%d,%d,%.1f,%.2f,%.1f\n",
+                (long)s.utc, s.outdoorTemp, s.airTemp, s.airHum, s.lux,
+                s.soilMoisture, s.soilTemp,
+                g_sensors.lightOn, g_sensors.pumpOn, g_sensors.fanOn,
+                HostHw::servoAngle(), d.stressTotal,
+                d.soilSetpointOffset, d.luxOnOffset);
+      }
+    }
+
+    if (trace && sec % 300 == 0) {
+      fprintf(trace, "%ld,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f\n",
+              (long)Clock::now(), g_sensors.airTemp, g_sensors.airHum,
+              g_sensors.soilMoisture, g_sensors.soilTemp,
+              g_sensors.airPressure, g_sensors.lux);
+    }
+
+    if ((sec + 1) % 86400 == 0) {
+      Automation::DiagInfo d = Automation::getDiagInfo();
+      time_t local = s.utc + LocationConfig::TZ_OFFSET_MIN * 60 - 1;
+      struct tm t;
+      gmtime_r(&local, &t);
+      char date[16];
+      strftime(date, sizeof(date), "%Y-%m-%d", &t);
+
+      printf("%-10s %5.1f/%5.1f %5.1f/%5.1f %5.1f/%5.1f %8.1f %8.2f %8.2f %8.1f %7.2f\n",
+             date, day.tMin, day.tMax, day.hMin, day.hMax, day.smMin, day.smMax,
+             (s.pumpOnSec  - day.pumpSec0)  / 60.0,
+             (s.lightOnSec - day.lightSec0) / 3600.0,
+             (s.fanOnSec   - day.fanSec0)   / 3600.0,
+             day.samples ? day.stressSum / day.samples : 0.0,
+             d.soilSetpointOffset);
+
+      day = DayStats{};
+      day.pumpSec0  = s.pumpOnSec;
+      day.lightSec0 = s.lightOnSec;
+      day.fanSec0   = s.fanOnSec;
+    }
+  }
+
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+  printf("\nsimulated %u days in %.2f s wall — %.0fx real time\n",
+         days, wallSec, wallSec > 0.0 ? (double)totalSec / wallSec : 0.0);
+
+  DeviceManager::OutputStats o = DeviceManager::getOutputStats();
+  printf("outputs: %u requests -> light %u, pump %u, fan %u, door %u, valves %u transitions, led %u refreshes\n",
+         o.requests, o.light, o.pump, o.fan, o.door, o.valves, o.ledRefreshes);
+
+  // SensorStats по кадрам датчиков — сверка с суточными min/max выше
+  printf("\nsensor stats        window        n      mean        sd       min       max      ewma\n");
+  for (uint8_t c = 0; c < SensorStats::CHANNELS; ++c) {
+    for (uint8_t w = 0; w < SensorStats::WINDOWS; ++w) {
+      SensorStats::Summary st;
+      if (!SensorStats::get((SensorStats::Channel)c, (SensorStats::Window)w, st)) continue;
+      printf("%-18s %7s %8u %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+             SensorStats::channelName((SensorStats::Channel)c),
+             SensorStats::windowName((SensorStats::Window)w),
+             st.n, st.mean, st.stddev, st.min, st.max, st.ewma);
+    }
+  }
+
+  // SensorHealth на гладкой модели не должен ничего отбрасывать
+  printf("\nsensor health      ");
+  for (uint8_t c = 0; c < SensorHealth::CHANNELS; ++c) {
+    SensorHealth::Status h = SensorHealth::status((SensorHealth::Channel)c, Clock::millis());
+    printf(" %s %u/%u", SensorStats::channelName((SensorStats::Channel)c), h.rejected, h.events);
+  }
+  printf("  (rejected/events)\n");
+
+  // TaskMonitor: загрузка задач за последние 5 минут симуляции. На хосте
+  // runtime-статистики FreeRTOS нет — TaskMonitor отдаёт UNKNOWN, печатаем n/a
+  uint8_t n = TaskMonitor::historyCount();
+  for (uint8_t k = 0; k < TaskMonitor::taskCount() && n > 0; ++k) {
+    TaskMonitor::TaskStat t;
+    TaskMonitor::getTask(k, t);
+    if (t.cpuCentiPct == TaskMonitor::UNKNOWN) {
+      printf("task %-16s cpu n/a (no FreeRTOS run-time stats)\n", t.name);
+      continue;
+    }
+
+    uint32_t sum = 0, peak = 0, valid = 0;
+    for (uint8_t i = 0; i < n; ++i) {
+      TaskMonitor::Sample s;
+      TaskMonitor::getHistory(i, s);
+      if (s.cpuCentiPct[k] == TaskMonitor::UNKNOWN) continue;
+      sum += s.cpuCentiPct[k];
+      if (s.cpuCentiPct[k] > peak) peak = s.cpuCentiPct[k];
+      valid++;
+    }
+    if (valid == 0) continue;
+    printf("task %-16s cpu avg %.2f%%, peak %.2f%% (last %u samples)\n",
+           t.name, sum / 100.0 / valid, peak / 100.0, valid);
+  }
+
+  if (csv)   fclose(csv);
+  if (trace) fclose(trace);
+  return 0;
+}
@@ -0,0 +1,159 @@
+// === FILE: host/tests/sensor_health.cpp ===
+// Регрессия SensorHealth: значение на краю диапазона — не залипание.
+//
+//   sensor_health
+//
+// Ночь с 20:30 до 10:30: датчик почвы суше сухой калибровки (АЦП 3600
+// при dry = 3500, acquireSensors обрезает до ровно 0 %), воздух в тумане
+// держит ровно 100 % RH до 06:00. Полный стек: acquireSensors +
+// StateMachine. Ни почва, ни влажность не должны стать NAN, насос обязан
+// включиться в окне полива 07–10 ч.
+//
+// Вторая часть — контроль: то же значение в середине диапазона дольше
+// flatMs по-прежнему помечается как залипшее.
+//
+// Третья — датчики почвы грядок 1..: checkZone держит своё состояние на
+// зону. Залипший датчик зоны 1 и обрыв датчика зоны 2 (скачок 60 → 0 %)
+// дают NAN, живой датчик зоны 3 проходит.
+//
+// Код возврата 1 при любом нарушении.
+
+#include <Arduino.h>
+#include "HostHw.h"
+#include "ManualClock.h"
+
+#include "Config.h"
+#include "Globals.h"
+#include "Storage.h"
+#include "TimeManager.h"
+#include "DeviceManager.h"
+#include "Automation.h"
+#include "SensorHealth.h"
+#include "StateMachine.h"
+
+#include <math.h>
+#include <stdio.h>
+
+namespace {
+
+  constexpr time_t   START_UTC = 1748799000;   // 2025-06-01 20:30 MSK
+  constexpr uint32_t RUN_SEC   = 14 * 3600;    // до 10:30
+  constexpr uint32_t FOG_SEC   = 9 * 3600 + 1800;   // 100 % RH до 06:00
+  constexpr uint32_t WATER_FROM_SEC = 10 * 3600 + 1800;   // 07:00
+  constexpr uint32_t WATER_TO_SEC   = 13 * 3600 + 1800;   // 10:00
+
+  uint32_t nextAcquireMs = 0;
+
+  void runAutomationSecond() {
+    for (uint32_t t = 0; t < 1000; t += AutomationConfig::SCHED_TICK_MS) {
+      if ((int32_t)(Clock::millis() - nextAcquireMs) >= 0) {
+        DeviceManager::acquireSensors();
+        nextAcquireMs += AutomationConfig::SENSOR_PERIOD_MS;
+      }
+      StateMachine::runDue(Clock::millis());
+      ManualClock::advance(AutomationConfig::SCHED_TICK_MS);
+    }
+  }
+
+  // Живые (шумящие) показания всего, кроме проверяемых краёв
+  void feed(uint32_t sec) {
+    float t   = 18.0f + 0.01f * (float)(sec % 37);
+    // туман расходится плавно, без скачка
+    float hum = sec < FOG_SEC ? 100.0f
+              : fmaxf(85.0f, 99.9f - 0.005f * (float)(sec - FOG_SEC)) + 0.01f * (float)(sec % 3);
+    HostHw::setBme(true, t, hum, 100500.0f + (float)(sec % 7));
+    HostHw::setLux(true, sec < 9 * 3600 ? 0.0f : 2000.0f + (float)(sec % 11));
+    HostHw::setAnalog(Pins::SOIL_ANALOG, 3600);
+    HostHw::setAnalog(Pins::SOIL_TEMP_ANALOG, (uint16_t)(900 + sec % 2));
+  }
+
+  bool edgeValuesStayValid() {
+    ManualClock::set(1000, START_UTC);
+    Clock::bind(ManualClock::source());
+    feed(0);
+
+    Storage::begin();
+    Storage::loadSettings(g_settings);
+    g_settings.soilDryRaw = 3500;
+    g_settings.soilWetRaw = 1800;
+    DeviceManager::begin();
+    TimeManager::begin();
+    Automation::begin();
+    StateMachine::begin(Clock::millis());
+    nextAcquireMs = Clock::millis();
+
+    uint32_t soilNan = 0, humNan = 0, pumpOnSec = 0;
+    for (uint32_t sec = 0; sec < RUN_SEC; ++sec) {
+      feed(sec);
+      runAutomationSecond();
+      if (sec < 10) continue;   // первый кадр
+
+      if (isnan(g_sensors.soilMoisture)) soilNan++;
+      if (isnan(g_sensors.airHum))       humNan++;
+      if (sec >= WATER_FROM_SEC && sec < WATER_TO_SEC && g_sensors.pumpOn) pumpOnSec++;
+    }
+
+    SensorHealth::Status sm = SensorHealth::status(SensorHealth::Channel::SoilMoisture, Clock::millis());
+    SensorHealth::Status hu = SensorHealth::status(SensorHealth::Channel::AirHum, Clock::millis());
+    printf("edge: soil %.1f %%, NaN %u s, rejected %u; hum NaN %u s, rejected %u; pump in window %u s\n",
+           g_sensors.soilMoisture, soilNan, sm.rejected, humNan, hu.rejected, pumpOnSec);
+
+    bool ok = soilNan == 0 && humNan == 0 && pumpOnSec > 0;
+    if (!ok) printf("FAIL: edge values marked invalid or pump never ran\n");
+    return ok;
+  }
+
+  bool midRangeStillStuck() {
+    SensorHealth::begin();
+    const uint32_t flatMs = SensorHealthConfig::LIMITS[(uint8_t)SensorHealth::Channel::SoilMoisture].flatMs;
+
+    float v[SensorHealth::CHANNELS];
+    uint8_t mask = 0;
+    for (uint32_t t = 0; t <= flatMs + 2000; t += 2000) {
+      for (float& x : v) x = NAN;
+      v[(uint8_t)SensorHealth::Channel::SoilMoisture] = 42.0f;
+      mask = SensorHealth::check(v, t);
+    }
+    SensorHealth::Status st = SensorHealth::status(SensorHealth::Channel::SoilMoisture, flatMs + 2000);
+    printf("mid-range: soil 42 %% for %lu s -> %s\n",
+           (unsigned long)(flatMs / 1000), SensorHealth::faultName(st.faults));
+
+    bool ok = (mask & (1 << (uint8_t)SensorHealth::Channel::SoilMoisture)) &&
+              (st.faults & SensorHealth::FAULT_STUCK);
+    if (!ok) printf("FAIL: mid-range stuck value not flagged\n");
+    return ok;
+  }
+
+  bool zoneProbesChecked() {
+    SensorHealth::begin();
+    const uint32_t flatMs = SensorHealthConfig::LIMITS[(uint8_t)SensorHealth::Channel::SoilMoisture].flatMs;
+
+    float z1 = 0, z2 = 0, z3 = 0;
+    uint32_t t = 0;
+    for (; t <= flatMs + 2000; t += 2000) {
+      z1 = SensorHealth::checkZone(1, 42.0f, t);
+      z2 = SensorHealth::checkZone(2, 60.0f + 0.1f * (float)(t / 2000 % 5), t);
+      z3 = SensorHealth::checkZone(3, 50.0f + 0.1f * (float)(t / 2000 % 7), t);
+    }
+    z2 = SensorHealth::checkZone(2, 0.0f, t);   // провод оборван
+
+    SensorHealth::Status s1 = SensorHealth::zoneStatus(1, t);
+    SensorHealth::Status s2 = SensorHealth::zoneStatus(2, t);
+    printf("zones: z1 %s, z2 %s, z3 %.1f %%\n",
+           SensorHealth::faultName(s1.faults), SensorHealth::faultName(s2.faults), z3);
+
+    bool ok = isnan(z1) && (s1.faults & SensorHealth::FAULT_STUCK) &&
+              isnan(z2) && (s2.faults & SensorHealth::FAULT_SPIKE) &&
+              !isnan(z3);
+    if (!ok) printf("FAIL: zone soil probes not checked like zone 0\n");
+    return ok;
+  }
+
+} // namespace
+
+int main() {
+  bool ok = edgeValuesStayValid();
+  ok = midRangeStillStuck() && ok;
+  ok = zoneProbesChecked() && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// === FILE: host/tests/sun_accuracy.cpp ===
+// Сверка SunPosition::calculateFast (float) с calculate (double).
+//
+//   sun_accuracy [--full]
+//
+// Диапазон — 50 лет (1975–2025) на нескольких широтах. По умолчанию
+// время идёт с шагом 2221 с (взаимно просто с сутками, так что покрываются
+// все минуты суток); --full — каждая минута всех 50 лет (~26 млн точек
+// на широту, несколько минут). Код возврата 1, если ошибка высоты
+// больше SunPosition::FAST_MAX_ALT_ERR_DEG или день/ночь расходятся
+// дальше этой полосы у горизонта. В конце — время одного вызова обеих
+// версий на хосте.
+
+#include <Arduino.h>
+#include "SunPosition.h"
+#include "Config.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+  const float LATITUDES[] = { 0.0f, 23.44f, -33.9f, LocationConfig::LATITUDE_DEG, 60.0f, -66.5f };
+
+  constexpr time_t START_UTC = 157766400;    // 1975-01-01 00:00 UTC
+  constexpr time_t END_UTC   = 1735689600;   // 2025-01-01 00:00 UTC
+
+  struct Errors {
+    double   maxAlt    = 0.0;
+    double   sumAlt    = 0.0;
+    double   maxAz     = 0.0;    // только при высоте ниже 89°: у зенита азимут не определён
+    uint64_t points    = 0;
+    uint64_t dayFlips  = 0;      // isDay различается при |высота| > допуска
+  };
+
+  void compare(float lat, time_t stepSec, Errors& e) {
+    const float lon = LocationConfig::LONGITUDE_DEG;
+    for (time_t t = START_UTC; t < END_UTC; t += stepSec) {
+      SunPositionData ref  = SunPosition::calculate(t, lat, lon, 0);
+      SunPositionData fast = SunPosition::calculateFast(t, lat, lon);
+
+      double dAlt = fabs((double)fast.altitudeDeg - ref.altitudeDeg);
+      e.sumAlt += dAlt;
+      if (dAlt > e.maxAlt) e.maxAlt = dAlt;
+
+      if (fabsf(ref.altitudeDeg) < 89.0f) {
+        double dAz = fabs((double)fast.azimuthDeg - ref.azimuthDeg);
+        if (dAz > 180.0) dAz = 360.0 - dAz;
+        if (dAz > e.maxAz) e.maxAz = dAz;
+      }
+
+      if (fast.isDay != ref.isDay &&
+          fabsf(ref.altitudeDeg) > SunPosition::FAST_MAX_ALT_ERR_DEG) {
+        e.dayFlips++;
+      }
+      e.points++;
+    }
+  }
+
+  template<typename Fn>
+  double nsPerCall(Fn fn, uint32_t n) {
+    volatile float sink = 0.0f;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < n; ++i) {
+      sink = sink + fn(START_UTC + (time_t)i * 601);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool full = argc > 1 && !strcmp(argv[1], "--full");
+  const time_t stepSec = full ? 60 : 2221;
+
+  printf("%-8s %12s %12s %12s %12s %8s\n",
+         "lat", "points", "max alt °", "mean alt °", "max az °", "flips");
+
+  bool ok = true;
+  double worst = 0.0;
+  for (float lat : LATITUDES) {
+    Errors e;
+    compare(lat, stepSec, e);
+    printf("%-8.2f %12llu %12.5f %12.6f %12.5f %8llu\n",
+           lat, (unsigned long long)e.points, e.maxAlt,
+           e.sumAlt / e.points, e.maxAz, (unsigned long long)e.dayFlips);
+    if (e.maxAlt > worst) worst = e.maxAlt;
+    if (e.maxAlt > SunPosition::FAST_MAX_ALT_ERR_DEG || e.dayFlips) ok = false;
+  }
+
+  const uint32_t N = 2000000;
+  const float lat = LocationConfig::LATITUDE_DEG;
+  const float lon = LocationConfig::LONGITUDE_DEG;
+  double nsRef  = nsPerCall([&](time_t t) { return SunPosition::calculate(t, lat, lon, 0).altitudeDeg; }, N);
+  double nsFast = nsPerCall([&](time_t t) { return SunPosition::calculateFast(t, lat, lon).altitudeDeg; }, N);
+
+  printf("\ncalculate      %8.1f ns/call\n", nsRef);
+  printf("calculateFast  %8.1f ns/call  (x%.1f)\n", nsFast, nsFast > 0.0 ? nsRef / nsFast : 0.0);
+  printf("worst altitude error %.5f° (bound %.3f°): %s\n",
+         worst, SunPosition::FAST_MAX_ALT_ERR_DEG, ok ? "OK" : "FAIL");
+
+  return ok ? 0 : 1;
+}
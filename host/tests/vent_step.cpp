@@ -0,0 +1,341 @@
+// === FILE: host/tests/vent_step.cpp ===
+// Переходная характеристика проветривания на физике GreenhouseSim:
+// PI-регулятор (VentControl::Pi) против прежней эвристики.
+//
+//   vent_step [--csv out.csv]
+//
+// Летний ясный день, своя настройка (профиль 0), верхняя граница
+// комфорта SP_HIGH. Теплица стартует закрытой и прогревается солнцем
+// (фаза 1); через PHASE_SEC граница скачком опускается до SP_LOW
+// (фаза 2). По каждой фазе: время установления в полосе ±BAND_C,
+// перерегулирование, средняя ошибка в конце фазы, записи в серво,
+// смены направления двери и стоимость stepMedium.
+//
+// Отдельно — перегрев выше AIR_EMERGENCY_HOT при быстром росте
+// температуры: пока PI ещё не дошёл до 100 %, stepMedium не должен
+// перебивать аварийные дверь 100 % / вентилятор stepCritical, а после
+// аварии регулятор продолжает с полностью открытой двери.
+//
+// Код возврата 1, если PI не установился в фазе 2 за SETTLE_MAX_SEC,
+// перерегулирование больше OVERSHOOT_MAX_C, остаточная ошибка больше
+// STEADY_ERR_MAX_C, дверь под PI меняет направление чаще эвристики или
+// аварийная вентиляция хоть на тик перебита регулятором.
+
+#include <Arduino.h>
+#include "HostHw.h"
+#include "ManualClock.h"
+#include "GreenhouseSim.h"
+
+#include "Config.h"
+#include "Globals.h"
+#include "Storage.h"
+#include "TimeManager.h"
+#include "DeviceManager.h"
+#include "Automation.h"
+#include "CropProfiles.h"
+#include "StateMachine.h"
+#include "Perf.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+  constexpr time_t   START_UTC   = 1746079200;   // 2025-05-01 09:00 MSK
+  constexpr uint32_t PHASE_SEC   = 2 * 3600;
+  constexpr float    SP_HIGH     = 28.0f;
+  constexpr float    SP_LOW      = 25.0f;
+  constexpr float    BAND_C      = 1.0f;
+  constexpr uint32_t STEADY_SEC  = 30 * 60;      // хвост фазы для средней ошибки
+
+  constexpr uint32_t SETTLE_MAX_SEC   = 40 * 60;
+  constexpr float    OVERSHOOT_MAX_C  = 1.5f;
+  constexpr float    STEADY_ERR_MAX_C = 0.5f;
+
+  struct PhaseResult {
+    uint32_t settleSec   = 0;      // с начала фазы до входа в полосу навсегда
+    bool     settled     = false;
+    float    overshoot   = 0.0f;   // макс. выход за уставку в сторону ошибки, °C
+    float    steadyErr   = 0.0f;   // средняя |T − уставка| в хвосте фазы
+  };
+
+  struct RunResult {
+    PhaseResult phase[2];
+    uint32_t    doorWrites    = 0;
+    uint32_t    doorReversals = 0;
+    uint32_t    fanSwitches   = 0;
+    double      stepMediumNs  = 0.0;
+  };
+
+  void setUpperLimit(float sp) {
+    g_settings.comfortTempMax = sp;
+    CropProfiles::refresh();
+  }
+
+  // Одна секунда работы обеих задач: опрос датчиков + SCHED_TICK_MS-тики
+  uint32_t nextAcquireMs = 0;
+
+  void runAutomationTick() {
+    if ((int32_t)(Clock::millis() - nextAcquireMs) >= 0) {
+      DeviceManager::acquireSensors();
+      nextAcquireMs += AutomationConfig::SENSOR_PERIOD_MS;
+    }
+    StateMachine::runDue(Clock::millis());
+    ManualClock::advance(AutomationConfig::SCHED_TICK_MS);
+  }
+
+  void runAutomationSecond() {
+    for (uint32_t t = 0; t < 1000; t += AutomationConfig::SCHED_TICK_MS) {
+      runAutomationTick();
+    }
+  }
+
+  RunResult run(Automation::VentControl control, FILE* csv) {
+    ManualClock::set(1000, START_UTC);
+    Clock::bind(ManualClock::source());
+
+    GreenhouseSim::Params params;
+    params.cloudiness = 0.0f;
+    GreenhouseSim::begin(params, START_UTC);
+
+    Storage::begin();
+    Storage::loadSettings(g_settings);
+    g_settings.cropProfile    = CropProfile::Custom;
+    g_settings.climateMode    = ClimateMode::Normal;
+    g_settings.comfortTempMin = 16.0f;
+    g_settings.comfortHumMin  = 30.0f;
+    g_settings.comfortHumMax  = 98.0f;   // проверяем контур по температуре
+    setUpperLimit(SP_HIGH);
+
+    DeviceManager::begin();
+    TimeManager::begin();
+    Automation::begin();
+    Automation::setVentControl(control);
+    StateMachine::begin(Clock::millis());
+    Perf::reset();
+    nextAcquireMs = Clock::millis();
+
+    RunResult r;
+    int lastAngle = HostHw::servoAngle();
+    int lastDir   = 0;
+
+    for (uint8_t ph = 0; ph < 2; ++ph) {
+      const float sp = ph == 0 ? SP_HIGH : SP_LOW;
+      setUpperLimit(sp);
+      // фаза 1 — прогрев снизу, фаза 2 — уставка сверху вниз
+      const float sign = ph == 0 ? 1.0f : -1.0f;
+
+      PhaseResult& p = r.phase[ph];
+      bool   crossed  = false;
+      bool   inBand   = false;
+      double errSum   = 0.0;
+      uint32_t errN   = 0;
+
+      for (uint32_t sec = 0; sec < PHASE_SEC; ++sec) {
+        GreenhouseSim::step(1.0f);
+        runAutomationSecond();
+
+        const float t   = GreenhouseSim::state().airTemp;
+        const float err = t - sp;
+
+        if (!crossed && sign * err >= 0.0f) crossed = true;
+        if (crossed && sign * err > p.overshoot) p.overshoot = sign * err;
+
+        bool nowIn = fabsf(err) <= BAND_C;
+        if (nowIn && !inBand) p.settleSec = sec;
+        inBand = nowIn;
+
+        if (sec >= PHASE_SEC - STEADY_SEC) {
+          errSum += fabsf(err);
+          errN++;
+        }
+
+        int angle = HostHw::servoAngle();
+        if (angle != lastAngle) {
+          int dir = angle > lastAngle ? 1 : -1;
+          if (lastDir != 0 && dir != lastDir) r.doorReversals++;
+          lastDir   = dir;
+          lastAngle = angle;
+        }
+
+        if (csv && sec % 10 == 0) {
+          fprintf(csv, "%s,%u,%u,%.2f,%.2f,%.1f,%d,%d\n",
+                  control == Automation::VentControl::Pi ? "pi" : "heuristic",
+                  ph, sec, sp, t, GreenhouseSim::state().outdoorTemp,
+                  angle, HostHw::pinLevel(Pins::RELAY_FAN) ? 1 : 0);
+        }
+      }
+
+      p.settled   = inBand;
+      p.steadyErr = errN ? (float)(errSum / errN) : 0.0f;
+    }
+
+    DeviceManager::OutputStats o = DeviceManager::getOutputStats();
+    r.doorWrites  = o.door;
+    r.fanSwitches = o.fan;
+
+    Perf::StageStats st = Perf::get(Perf::Stage::StepMedium);
+    if (st.count) {
+      r.stepMediumNs = (double)st.sumCycles / st.count * 1000.0 / Perf::cpuMHz();
+    }
+    return r;
+  }
+
+  // Перегрев: 20 °C → 42 °C со скоростью 0.9 °C/с (в пределах
+  // SensorHealth), 5 минут жары, затем 38 °C — уже не авария, но жарко
+  constexpr float    HEAT_FROM_C  = 20.0f;
+  constexpr float    HEAT_PEAK_C  = 42.0f;
+  constexpr float    HEAT_AFTER_C = 38.0f;
+  constexpr float    HEAT_RATE    = 0.9f;
+  constexpr uint32_t HEAT_HOLD_SEC  = 5 * 60;
+  constexpr uint32_t HEAT_AFTER_SEC = 60;
+  constexpr float    EMERGENCY_C  = 40.0f;   // Automation: AIR_EMERGENCY_HOT
+
+  struct HeatResult {
+    uint32_t emergencyTicks = 0;   // тиков с кадром выше EMERGENCY_C
+    uint32_t overridden     = 0;   // из них дверь не 100 % или вентилятор выключен
+    uint32_t afterTicks     = 0;
+    uint32_t afterClosed    = 0;   // после аварии дверь прикрылась скачком
+  };
+
+  HeatResult runHeat() {
+    ManualClock::set(1000, START_UTC);
+    Clock::bind(ManualClock::source());
+
+    Storage::begin();
+    Storage::loadSettings(g_settings);
+    g_settings.cropProfile    = CropProfile::Custom;
+    g_settings.climateMode    = ClimateMode::Normal;
+    g_settings.comfortTempMin = 16.0f;
+    g_settings.comfortHumMin  = 30.0f;
+    g_settings.comfortHumMax  = 98.0f;
+    setUpperLimit(SP_HIGH);
+
+    float temp = HEAT_FROM_C;
+    HostHw::setBme(true, temp, 60.0f, 100500.0f);
+    HostHw::setLux(true, 20000.0f);
+
+    DeviceManager::begin();
+    TimeManager::begin();
+    Automation::begin();
+    Automation::setVentControl(Automation::VentControl::Pi);
+    StateMachine::begin(Clock::millis());
+    nextAcquireMs = Clock::millis();
+
+    HeatResult r;
+    const uint32_t rampSec = (uint32_t)((HEAT_PEAK_C - HEAT_FROM_C) / HEAT_RATE) + 1;
+    const uint32_t endSec  = 60 + rampSec + HEAT_HOLD_SEC + HEAT_AFTER_SEC;
+
+    for (uint32_t sec = 0; sec < endSec; ++sec) {
+      if (sec >= 60 + rampSec + HEAT_HOLD_SEC) {
+        temp = HEAT_AFTER_C;
+      } else if (sec >= 60) {
+        temp = fminf(HEAT_PEAK_C, temp + HEAT_RATE);
+      }
+      // шум, чтобы канал не считался залипшим
+      HostHw::setBme(true, temp + 0.01f * (float)(sec % 3), 60.0f, 100500.0f);
+
+      for (uint32_t t = 0; t < 1000; t += AutomationConfig::SCHED_TICK_MS) {
+        runAutomationTick();
+
+        const bool open = HostHw::servoAngle() == 180 &&
+                          HostHw::pinLevel(Pins::RELAY_FAN);
+        if (g_sensors.airTemp > EMERGENCY_C) {
+          r.emergencyTicks++;
+          if (!open) r.overridden++;
+        } else if (temp == HEAT_AFTER_C && r.emergencyTicks > 0) {
+          r.afterTicks++;
+          if (HostHw::servoAngle() != 180) r.afterClosed++;
+        }
+      }
+    }
+    return r;
+  }
+
+  void print(const char* name, const RunResult& r) {
+    for (uint8_t ph = 0; ph < 2; ++ph) {
+      const PhaseResult& p = r.phase[ph];
+      printf("%-10s %5u   ", ph == 0 ? name : "", ph + 1);
+      if (p.settled) printf("%8.1f", p.settleSec / 60.0);
+      else           printf("%8s", "never");
+      printf(" %10.2f %10.2f", p.overshoot, p.steadyErr);
+      if (ph == 0) {
+        printf(" %8u %8u %8u %10.0f\n", r.doorWrites, r.doorReversals,
+               r.fanSwitches, r.stepMediumNs);
+      } else {
+        printf("\n");
+      }
+    }
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* csvPath = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+      csvPath = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--csv out.csv]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  FILE* csv = nullptr;
+  if (csvPath) {
+    csv = fopen(csvPath, "w");
+    if (!csv) { perror(csvPath); return 1; }
+    fprintf(csv, "control,phase,sec,setpoint,airTemp,outTemp,servo,fan\n");
+  }
+
+  RunResult pi        = run(Automation::VentControl::Pi, csv);
+  RunResult heuristic = run(Automation::VentControl::Heuristic, csv);
+  if (csv) fclose(csv);
+
+  printf("setpoint %.1f -> %.1f °C, band ±%.1f °C, %u h per phase\n",
+         SP_HIGH, SP_LOW, BAND_C, PHASE_SEC / 3600);
+  printf("%-10s %5s %10s %10s %10s %8s %8s %8s %10s\n",
+         "control", "phase", "settle m", "overshoot", "steady err",
+         "servo", "reversal", "fan", "ns/medium");
+  print("pi", pi);
+  print("heuristic", heuristic);
+
+  HeatResult heat = runHeat();
+  printf("overheat %.0f °C: %u emergency ticks, %u overridden; after: %u ticks, %u door closing\n",
+         HEAT_PEAK_C, heat.emergencyTicks, heat.overridden, heat.afterTicks, heat.afterClosed);
+
+  bool ok = true;
+  const PhaseResult& step = pi.phase[1];
+  if (!step.settled || step.settleSec > SETTLE_MAX_SEC) {
+    printf("FAIL: PI did not settle within %u min after the step\n", SETTLE_MAX_SEC / 60);
+    ok = false;
+  }
+  for (uint8_t ph = 0; ph < 2; ++ph) {
+    if (pi.phase[ph].overshoot > OVERSHOOT_MAX_C) {
+      printf("FAIL: PI overshoot %.2f °C in phase %u\n", pi.phase[ph].overshoot, ph + 1);
+      ok = false;
+    }
+    if (pi.phase[ph].steadyErr > STEADY_ERR_MAX_C) {
+      printf("FAIL: PI steady-state error %.2f °C in phase %u\n", pi.phase[ph].steadyErr, ph + 1);
+      ok = false;
+    }
+  }
+  if (pi.doorReversals > heuristic.doorReversals) {
+    printf("FAIL: PI door reversals %u > heuristic %u\n", pi.doorReversals, heuristic.doorReversals);
+    ok = false;
+  }
+
+  if (heat.emergencyTicks == 0 || heat.overridden > 0) {
+    printf("FAIL: emergency ventilation overridden by PI in %u ticks\n", heat.overridden);
+    ok = false;
+  }
+  if (heat.afterTicks == 0 || heat.afterClosed > 0) {
+    printf("FAIL: door closed right after the emergency (%u ticks) — PI not bumpless\n",
+           heat.afterClosed);
+    ok = false;
+  }
+
+  printf(ok ? "OK\n" : "FAILED\n");
+  return ok ? 0 : 1;
+}
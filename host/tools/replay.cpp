@@ -0,0 +1,337 @@
+// === FILE: host/tools/replay.cpp ===
+// Реплей записанной телеметрии через автоматику.
+//
+//   replay <trace.csv|trace.bin> [--bin] [--fast] [--out decisions.csv]
+//          [--golden golden.csv] [--max-diff N]
+//
+// Формат trace: CSV с заголовком в порядке TelemetrySample
+//   ts,airTemp,airHum,soilMoisture,soilTemp,airPressure,lux
+// (пустое поле или "nan" — нет данных), либо --bin: массив упакованных
+// TelemetrySample (uint32 ts + 6 float, little-endian).
+//
+// Каждая строка публикуется в g_sensors как кадр sensorTask (опрос железа
+// DeviceManager не вызывается). Между соседними строками работает штатный
+// планировщик — StateMachine::runDue по ManualClock с шагом SCHED_TICK_MS,
+// тот же список этапов, что в automationTask; значения удерживаются.
+// --fast — один проход планировщика на строку: часы прыгают на интервал
+// строки, выполняются все этапы, чей срок прошёл.
+//
+// Все переключения выходов пишутся как "ts,actuator,value". С --golden
+// решения сравниваются с эталоном; код возврата 1, если есть расхождения.
+
+#include <Arduino.h>
+#include "HostHw.h"
+#include "ManualClock.h"
+
+#include "Config.h"
+#include "Globals.h"
+#include "Storage.h"
+#include "TimeManager.h"
+#include "DeviceManager.h"
+#include "Automation.h"
+#include "SensorBus.h"
+#include "SensorStats.h"
+#include "TelemetryLogger.h"
+#include "Diagnostics.h"
+#include "TaskMonitor.h"
+#include "Rules.h"
+#include "StateMachine.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+  struct TelemetrySample {
+    uint32_t ts;
+    float    airTemp;
+    float    airHum;
+    float    soilMoisture;
+    float    soilTemp;
+    float    airPressure;
+    float    lux;
+  } __attribute__((packed));
+
+  static_assert(sizeof(TelemetrySample) == 28, "TelemetrySample layout");
+
+  enum Actuator : uint8_t { ACT_LIGHT, ACT_PUMP, ACT_FAN, ACT_DOOR, ACT_COUNT };
+  const char* const ACT_NAMES[ACT_COUNT] = { "light", "pump", "fan", "door" };
+
+  struct Decision {
+    uint32_t ts;
+    uint8_t  act;
+    int      value;
+  };
+
+  // ---------- чтение trace ----------
+
+  float parseField(const char* s) {
+    while (*s == ' ') ++s;
+    if (*s == '\0' || *s == ',' || *s == '\n' || *s == '\r') return NAN;
+    return strtof(s, nullptr);
+  }
+
+  bool readCsv(const char* path, std::vector<TelemetrySample>& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) { perror(path); return false; }
+
+    char line[512];
+    bool header = true;
+    while (fgets(line, sizeof(line), f)) {
+      if (header) { header = false; if (line[0] < '0' || line[0] > '9') continue; }
+      if (line[0] == '\n' || line[0] == '#') continue;
+
+      float v[7];
+      const char* p = line;
+      for (int i = 0; i < 7; ++i) {
+        v[i] = parseField(p);
+        p = strchr(p, ',');
+        if (!p) { for (int k = i + 1; k < 7; ++k) v[k] = NAN; break; }
+        ++p;
+      }
+      TelemetrySample s{};
+      s.ts           = (uint32_t)strtoul(line, nullptr, 10);
+      s.airTemp      = v[1];
+      s.airHum       = v[2];
+      s.soilMoisture = v[3];
+      s.soilTemp     = v[4];
+      s.airPressure  = v[5];
+      s.lux          = v[6];
+      out.push_back(s);
+    }
+    fclose(f);
+    return true;
+  }
+
+  bool readBin(const char* path, std::vector<TelemetrySample>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) { perror(path); return false; }
+    TelemetrySample s;
+    while (fread(&s, sizeof(s), 1, f) == 1) out.push_back(s);
+    fclose(f);
+    return true;
+  }
+
+  bool readDecisions(const char* path, std::vector<Decision>& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) { perror(path); return false; }
+    char line[128], name[32];
+    while (fgets(line, sizeof(line), f)) {
+      unsigned long ts; int value;
+      if (sscanf(line, "%lu,%31[^,],%d", &ts, name, &value) != 3) continue;
+      for (uint8_t a = 0; a < ACT_COUNT; ++a) {
+        if (!strcmp(name, ACT_NAMES[a])) {
+          out.push_back(Decision{ (uint32_t)ts, a, value });
+          break;
+        }
+      }
+    }
+    fclose(f);
+    return true;
+  }
+
+  // ---------- автоматика ----------
+
+  uint32_t frameSeq = 0;
+
+  void pushSample(const TelemetrySample& s) {
+    SensorBus::writeBegin();
+    g_sensors.airTemp      = s.airTemp;
+    g_sensors.airHum       = s.airHum;
+    g_sensors.airPressure  = s.airPressure;
+    g_sensors.soilMoisture = s.soilMoisture;
+    g_sensors.soilTemp     = s.soilTemp;
+    g_sensors.lux          = s.lux;
+
+    g_sensors.bmeOk  = !isnan(s.airTemp);
+    g_sensors.bhOk   = !isnan(s.lux);
+    g_sensors.soilOk = !isnan(s.soilMoisture);
+
+    g_sensors.sampleMs = Clock::millis();
+    g_sensors.frameSeq = ++frameSeq;
+    SensorBus::writeEnd();
+
+    // как acquireSensors: свежий кадр будит климатические этапы
+    StateMachine::notify(StateMachine::EVENT_SENSORS);
+  }
+
+  int actuatorValue(uint8_t a) {
+    switch (a) {
+      case ACT_LIGHT: return g_sensors.lightOn ? 1 : 0;
+      case ACT_PUMP:  return g_sensors.pumpOn  ? 1 : 0;
+      case ACT_FAN:   return g_sensors.fanOn   ? 1 : 0;
+      case ACT_DOOR:  return HostHw::servoAngle();
+      default:        return 0;
+    }
+  }
+
+  int lastValue[ACT_COUNT];
+
+  void recordChanges(std::vector<Decision>& out) {
+    uint32_t ts = (uint32_t)Clock::now();
+    for (uint8_t a = 0; a < ACT_COUNT; ++a) {
+      int v = actuatorValue(a);
+      if (v != lastValue[a]) {
+        lastValue[a] = v;
+        out.push_back(Decision{ ts, a, v });
+      }
+    }
+  }
+
+  // ---------- сравнение с эталоном ----------
+
+  // Слияние двух отсортированных по времени списков; возвращает число расхождений
+  size_t diffDecisions(const std::vector<Decision>& got,
+                       const std::vector<Decision>& gold,
+                       size_t maxPrint) {
+    size_t i = 0, j = 0, diffs = 0;
+    auto key = [](const Decision& d) { return ((uint64_t)d.ts << 8) | d.act; };
+    auto report = [&](const char* tag, const Decision& d, int other) {
+      if (diffs < maxPrint) {
+        if (other == INT32_MIN) {
+          printf("  %s %u %s=%d\n", tag, d.ts, ACT_NAMES[d.act], d.value);
+        } else {
+          printf("  ~ %u %s=%d (golden %d)\n", d.ts, ACT_NAMES[d.act], d.value, other);
+        }
+      }
+      diffs++;
+    };
+
+    while (i < got.size() || j < gold.size()) {
+      if (j >= gold.size() || (i < got.size() && key(got[i]) < key(gold[j]))) {
+        report("+", got[i++], INT32_MIN);
+      } else if (i >= got.size() || key(gold[j]) < key(got[i])) {
+        report("-", gold[j++], INT32_MIN);
+      } else {
+        if (got[i].value != gold[j].value) report("~", got[i], gold[j].value);
+        ++i; ++j;
+      }
+    }
+    return diffs;
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* tracePath  = nullptr;
+  const char* outPath    = nullptr;
+  const char* goldenPath = nullptr;
+  bool        binary     = false;
+  bool        fast       = false;
+  size_t      maxDiff    = 20;
+
+  for (int i = 1; i < argc; ++i) {
+    if      (!strcmp(argv[i], "--bin"))  binary = true;
+    else if (!strcmp(argv[i], "--fast")) fast   = true;
+    else if (!strcmp(argv[i], "--out")      && i + 1 < argc) outPath    = argv[++i];
+    else if (!strcmp(argv[i], "--golden")   && i + 1 < argc) goldenPath = argv[++i];
+    else if (!strcmp(argv[i], "--max-diff") && i + 1 < argc) maxDiff    = strtoul(argv[++i], nullptr, 10);
+    else if (argv[i][0] != '-' && !tracePath) tracePath = argv[i];
+    else { tracePath = nullptr; break; }
+  }
+  if (!tracePath) {
+    fprintf(stderr,
+            "usage: %s <trace> [--bin] [--fast] [--out decisions.csv] "
+            "[--golden golden.csv] [--max-diff N]\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<TelemetrySample> trace;
+  if (!(binary ? readBin(tracePath, trace) : readCsv(tracePath, trace))) return 2;
+  if (trace.empty()) {
+    fprintf(stderr, "%s: no samples\n", tracePath);
+    return 2;
+  }
+
+  ManualClock::set(1000, (time_t)trace.front().ts);
+  Clock::bind(ManualClock::source());
+
+  // как setup() прошивки, без сети
+  Storage::begin();
+  Storage::loadSettings(g_settings);
+  DeviceManager::begin();
+  TimeManager::begin();
+  TelemetryLogger::begin();
+  Automation::begin();
+  SensorStats::begin();
+  Rules::begin();
+  Diagnostics::begin();
+  TaskMonitor::begin();
+  StateMachine::begin(Clock::millis());
+
+  for (uint8_t a = 0; a < ACT_COUNT; ++a) lastValue[a] = actuatorValue(a);
+
+  std::vector<Decision> decisions;
+  decisions.reserve(trace.size() / 4 + 16);
+
+  const uint32_t stepMs = AutomationConfig::SCHED_TICK_MS;
+  uint64_t ticks = 0;
+
+  auto wall0 = std::chrono::steady_clock::now();
+
+  for (size_t k = 0; k < trace.size(); ++k) {
+    pushSample(trace[k]);
+
+    uint32_t gapMs = stepMs;
+    if (k + 1 < trace.size() && trace[k + 1].ts > trace[k].ts) {
+      gapMs = (trace[k + 1].ts - trace[k].ts) * 1000UL;
+    }
+
+    if (fast) {
+      // без удержания: один проход и сразу к следующей строке
+      StateMachine::runDue(Clock::millis());
+      recordChanges(decisions);
+      ManualClock::advance(gapMs);
+      ticks++;
+      continue;
+    }
+
+    // millis() переполняется через 49.7 суток — планировщик сравнивает
+    // моменты по разности, так что длинные trace идут без сбоев
+    for (uint32_t t = 0; t < gapMs; t += stepMs) {
+      StateMachine::runDue(Clock::millis());
+      recordChanges(decisions);
+      ManualClock::advance(stepMs);
+      ticks++;
+    }
+  }
+
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+  if (wallSec <= 0.0) wallSec = 1e-9;
+
+  double spanDays = (trace.back().ts - trace.front().ts) / 86400.0;
+  printf("samples:   %zu (%.1f days)\n", trace.size(), spanDays);
+  printf("ticks:     %llu\n", (unsigned long long)ticks);
+  printf("decisions: %zu\n", decisions.size());
+  printf("wall:      %.3f s — %.0f samples/s, %.0f ticks/s\n",
+         wallSec, trace.size() / wallSec, ticks / wallSec);
+
+  if (outPath) {
+    FILE* f = fopen(outPath, "w");
+    if (!f) { perror(outPath); return 2; }
+    fprintf(f, "ts,actuator,value\n");
+    for (const Decision& d : decisions) {
+      fprintf(f, "%u,%s,%d\n", d.ts, ACT_NAMES[d.act], d.value);
+    }
+    fclose(f);
+  }
+
+  if (goldenPath) {
+    std::vector<Decision> gold;
+    if (!readDecisions(goldenPath, gold)) return 2;
+    size_t diffs = diffDecisions(decisions, gold, maxDiff);
+    if (diffs == 0) {
+      printf("golden:    match (%zu decisions)\n", gold.size());
+    } else {
+      printf("golden:    %zu differences (got %zu, golden %zu)\n",
+             diffs, decisions.size(), gold.size());
+      return 1;
+    }
+  }
+
+  return 0;
+}